@@ -63,6 +63,12 @@
 #define MAX_PWM_PER_CONTROLLER 6
 #define LPC24_PWM_PINS  { { { PIN(3, 16), PF(2) }, { PIN(3, 17), PF(2) }, { PIN_NONE, PF_NONE }, { PIN_NONE, PF_NONE }, { PIN_NONE, PF_NONE }, { PIN_NONE  , PF_NONE } }, { { PIN(3, 24), PF(3) }, { PIN_NONE  , PF_NONE }, { PIN(3, 26), PF(3) }, { PIN(3, 27), PF(3) }, { PIN_NONE, PF_NONE }, { PIN(3, 29), PF(3) } } }
 
+#define INCLUDE_COUNTER
+#define LPC24_COUNTER_PINS { { PIN_NONE, PF_NONE }, { PIN(1, 18), PF(3) }, { PIN(0,  4), PF(3) }, { PIN(0, 23), PF(3) } }
+
+#define INCLUDE_ONEPULSE
+#define LPC24_ONEPULSE_PINS { { { PIN_NONE, PF_NONE }, { PIN_NONE, PF_NONE } }, { { PIN(1, 18), PF(3) }, { PIN(1, 22), PF(3) } }, { { PIN(0,  4), PF(3) }, { PIN(0,  6), PF(3) } }, { { PIN(0, 23), PF(3) }, { PIN(0, 10), PF(3) } } }
+
 #define INCLUDE_SPI
 #define TOTAL_SPI_CONTROLLERS 2
 #define LPC24_SPI_SCLK_PINS { { PIN(0, 15), PF(2) }, { PIN(0,  7), PF(2) } }
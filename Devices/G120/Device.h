@@ -69,6 +69,18 @@
 #define LPC17_G120_PWM_PINS  { { { PIN(1,  2), PF(3) }, { PIN(1,  3), PF(3) }, { PIN(1,  5), PF(3) }, { PIN(1,  6), PF(3) }, { PIN(1,  7), PF(3) }, { PIN(1, 11), PF(3) } }, { { PIN(3, 24), PF(2) }, { PIN(3, 25), PF(2) }, { PIN(3, 26), PF(2) }, { PIN(2,  3), PF(1) }, { PIN(2,  4), PF(1) }, { PIN(2,  5), PF(1) } } }
 #define LPC17_G120E_PWM_PINS { { { PIN(3, 16), PF(2) }, { PIN(3, 17), PF(2) }, { PIN(3, 18), PF(2) }, { PIN(3, 19), PF(2) }, { PIN(3, 20), PF(2) }, { PIN(3, 21), PF(2) } }, { { PIN(3, 24), PF(2) }, { PIN(3, 25), PF(2) }, { PIN(3, 26), PF(2) }, { PIN(3, 27), PF(2) }, { PIN(3, 28), PF(2) }, { PIN(3, 29), PF(2) } } }
 
+#define INCLUDE_CAPTURE
+#define LPC17_CAPTURE_PINS { { { PIN(1, 26), PF(3) }, { PIN(1, 27), PF(3) } }, { { PIN(1, 18), PF(3) }, { PIN(1, 19), PF(3) } }, { { PIN(0,  4), PF(3) }, { PIN(0,  5), PF(3) } }, { { PIN(0, 23), PF(3) }, { PIN(0, 24), PF(3) } } }
+
+#define INCLUDE_ENCODER
+#define LPC17_ENCODER_PINS { { PIN(1, 20), PF(3) }, { PIN(1, 23), PF(3) }, { PIN(1, 24), PF(3) } }
+
+#define INCLUDE_COUNTER
+#define LPC17_COUNTER_PINS { { PIN(1, 26), PF(3) }, { PIN(1, 18), PF(3) }, { PIN(0,  4), PF(3) }, { PIN(0, 23), PF(3) } }
+
+#define INCLUDE_ONEPULSE
+#define LPC17_ONEPULSE_PINS { { { PIN(1, 26), PF(3) }, { PIN(1, 28), PF(3) } }, { { PIN(1, 18), PF(3) }, { PIN(1, 22), PF(3) } }, { { PIN(0,  4), PF(3) }, { PIN(0,  6), PF(3) } }, { { PIN(0, 23), PF(3) }, { PIN(0, 10), PF(3) } } }
+
 #define INCLUDE_SPI
 #define TOTAL_SPI_CONTROLLERS 3
 #define LPC17_SPI_SCLK_PINS { { PIN(0, 15), PF(2) }, { PIN(0,  7), PF(2) }, { PIN(1,  0), PF(4) } }
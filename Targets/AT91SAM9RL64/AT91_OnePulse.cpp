@@ -0,0 +1,211 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "AT91.h"
+
+#ifdef INCLUDE_ONEPULSE
+///////////////////////////////////////////////////////////////////////////////
+
+// controller x is TC x in waveform mode: a TIOBx edge or a software trigger restarts the counter,
+// RA drives TIOAx to the pulse level and RC ends the pulse and stops the clock. TC0 is the system timer.
+#define AT91_ONEPULSE_TRIGGER_PIN 0
+#define AT91_ONEPULSE_OUTPUT_PIN 1
+#define AT91_ONEPULSE_MASK 0xFFFF
+#define AT91_ONEPULSE_PERIPHERAL_ID(controller) (AT91C_ID_TC0 + (controller))
+
+struct AT91_OnePulse_Controller {
+    bool acquired;
+    bool configured;
+    bool invert;
+    AT91_OnePulse_Trigger trigger;
+};
+
+static const AT91_Gpio_Pin g_AT91_OnePulse_Pins[][2] = AT91_ONEPULSE_PINS;
+
+static const int TOTAL_ONEPULSE_CONTROLLERS = SIZEOF_ARRAY(g_AT91_OnePulse_Pins);
+
+static AT91_OnePulse_Controller g_AT91_OnePulse_Controller[TOTAL_ONEPULSE_CONTROLLERS];
+
+static TinyCLR_Result AT91_OnePulse_OpenPin(int32_t controller, int32_t index, AT91_Gpio_Direction direction) {
+    auto& pin = g_AT91_OnePulse_Pins[controller][index];
+
+    if (pin.number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+    if (!AT91_Gpio_OpenPin(pin.number))
+        return TinyCLR_Result::SharingViolation;
+
+    AT91_Gpio_ConfigurePin(pin.number, direction, pin.peripheralSelection, AT91_Gpio_ResistorMode::Inactive);
+
+    return TinyCLR_Result::Success;
+}
+
+static void AT91_OnePulse_ClosePin(int32_t controller, int32_t index) {
+    auto& pin = g_AT91_OnePulse_Pins[controller][index];
+
+    AT91_Gpio_ConfigurePin(pin.number, AT91_Gpio_Direction::Input, AT91_Gpio_PeripheralSelection::None, AT91_Gpio_ResistorMode::Inactive);
+    AT91_Gpio_ClosePin(pin.number);
+}
+
+// invert makes the pulse low on an idle high output
+TinyCLR_Result AT91_OnePulse_Acquire(int32_t controller, AT91_OnePulse_Trigger trigger, bool invert) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    AT91_TC& tc = AT91::TIMER(controller);
+    auto& state = g_AT91_OnePulse_Controller[controller];
+
+    if (state.acquired || (tc.TC_SR & AT91_TC::TC_CLKSTA)) // system timer or another client
+        return TinyCLR_Result::SharingViolation;
+
+    auto result = AT91_OnePulse_OpenPin(controller, AT91_ONEPULSE_OUTPUT_PIN, AT91_Gpio_Direction::Output);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    if (trigger != AT91_OnePulse_Trigger::Software) {
+        result = AT91_OnePulse_OpenPin(controller, AT91_ONEPULSE_TRIGGER_PIN, AT91_Gpio_Direction::Input);
+
+        if (result != TinyCLR_Result::Success) {
+            AT91_OnePulse_ClosePin(controller, AT91_ONEPULSE_OUTPUT_PIN);
+
+            return result;
+        }
+    }
+
+    state.acquired = true;
+    state.configured = false;
+    state.invert = invert;
+    state.trigger = trigger;
+
+    AT91_PMC& pmc = AT91::PMC();
+
+    pmc.PMC_PCER = (1 << AT91_ONEPULSE_PERIPHERAL_ID(controller));
+
+    tc.TC_CCR = AT91_TC::TC_CLKDIS;
+    tc.TC_IDR = 0xFFFFFFFF;
+
+    // park the counter on RC with the output at its idle level, RA is out of reach until a pulse is set
+    tc.TC_CMR = AT91_TC::TC_WAVE | AT91_TC::TC_WAVESEL_UP | AT91_TC::TC_CPCSTOP | (invert ? AT91_TC::TC_ASWTRG_SET : AT91_TC::TC_ASWTRG_CLEAR);
+    tc.TC_RA = 2;
+    tc.TC_RC = 1;
+
+    (void)tc.TC_SR;
+
+    tc.TC_CCR = AT91_TC::TC_CLKEN | AT91_TC::TC_SWTRG;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result AT91_OnePulse_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_AT91_OnePulse_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    AT91_TC& tc = AT91::TIMER(controller);
+
+    tc.TC_CCR = AT91_TC::TC_CLKDIS;
+    tc.TC_CMR = 0;
+
+    (void)tc.TC_SR;
+
+    AT91_OnePulse_ClosePin(controller, AT91_ONEPULSE_OUTPUT_PIN);
+
+    if (state.trigger != AT91_OnePulse_Trigger::Software)
+        AT91_OnePulse_ClosePin(controller, AT91_ONEPULSE_TRIGGER_PIN);
+
+    state.acquired = false;
+
+    return TinyCLR_Result::Success;
+}
+
+// delay is from the trigger to the pulse start, both times are rounded down to timer ticks with a minimum of one.
+// A trigger during a pulse restarts it.
+TinyCLR_Result AT91_OnePulse_SetPulse(int32_t controller, uint32_t delayNanoseconds, uint32_t widthNanoseconds) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_AT91_OnePulse_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (widthNanoseconds == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // TIMER_CLOCK1..4 are MCK / 2, 8, 32 and 128, use the fastest one that fits the whole pulse
+    uint64_t total = (uint64_t)delayNanoseconds + widthNanoseconds;
+    uint32_t clockSelect = AT91_TC::TC_CLKS_TIMER_DIV1_CLOCK;
+    uint64_t clock = AT91_SYSTEM_PERIPHERAL_CLOCK_HZ / 2;
+
+    while ((total * clock) / 1000000000 >= AT91_ONEPULSE_MASK) {
+        if (clockSelect == AT91_TC::TC_CLKS_TIMER_DIV4_CLOCK)
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        clockSelect++;
+        clock /= 4;
+    }
+
+    uint32_t delay = ((uint64_t)delayNanoseconds * clock) / 1000000000;
+    uint32_t width = ((uint64_t)widthNanoseconds * clock) / 1000000000;
+
+    if (delay == 0) // RA = 0 would leave the output at the pulse level while idle
+        delay = 1;
+
+    if (width == 0)
+        width = 1;
+
+    AT91_TC& tc = AT91::TIMER(controller);
+
+    uint32_t mode = clockSelect | AT91_TC::TC_WAVE | AT91_TC::TC_WAVESEL_UP | AT91_TC::TC_CPCSTOP;
+
+    if (state.invert)
+        mode |= AT91_TC::TC_ACPA_CLEAR | AT91_TC::TC_ACPC_SET | AT91_TC::TC_ASWTRG_SET | AT91_TC::TC_AEEVT_SET;
+    else
+        mode |= AT91_TC::TC_ACPA_SET | AT91_TC::TC_ACPC_CLEAR | AT91_TC::TC_ASWTRG_CLEAR | AT91_TC::TC_AEEVT_CLEAR;
+
+    if (state.trigger != AT91_OnePulse_Trigger::Software)
+        mode |= AT91_TC::TC_ENETRG | AT91_TC::TC_EEVT_TIOB | (state.trigger == AT91_OnePulse_Trigger::FallingEdge ? AT91_TC::TC_EEVTEDG_FALLING : AT91_TC::TC_EEVTEDG_RISING);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    tc.TC_CMR = mode;
+    tc.TC_RA = delay;
+    tc.TC_RC = delay + width;
+
+    state.configured = true;
+
+    return TinyCLR_Result::Success;
+}
+
+// starts the pulse now, edge triggered controllers start on each edge by themselves
+TinyCLR_Result AT91_OnePulse_Fire(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_AT91_OnePulse_Controller[controller];
+
+    if (!state.acquired || !state.configured)
+        return TinyCLR_Result::InvalidOperation;
+
+    AT91::TIMER(controller).TC_CCR = AT91_TC::TC_SWTRG;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
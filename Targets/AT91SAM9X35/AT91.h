@@ -467,6 +467,27 @@ TinyCLR_Result AT91_Gpio_Release(const TinyCLR_Gpio_Provider* self);
 TinyCLR_Result AT91_Gpio_EnableAlternatePin(int32_t pin, TinyCLR_Gpio_PinDriveMode resistor, uint32_t alternate);
 TinyCLR_Result AT91_Gpio_Read(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& value);
 TinyCLR_Result AT91_Gpio_Write(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue value);
+TinyCLR_Result AT91_Gpio_ReadPort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t& value);
+TinyCLR_Result AT91_Gpio_WritePort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t mask, uint32_t value);
+
+struct AT91_Gpio_Event {
+    int32_t pin;
+    TinyCLR_Gpio_PinValue value;
+    uint64_t ticks; // processor ticks at the edge
+};
+
+TinyCLR_Result AT91_Gpio_SetEventQueueEnabled(const TinyCLR_Gpio_Provider* self, int32_t pin, bool enabled);
+TinyCLR_Result AT91_Gpio_ReadEvents(const TinyCLR_Gpio_Provider* self, AT91_Gpio_Event* events, size_t& count);
+TinyCLR_Result AT91_Gpio_DispatchEvents(const TinyCLR_Gpio_Provider* self);
+uint32_t AT91_Gpio_GetLostEventCount(const TinyCLR_Gpio_Provider* self);
+
+struct AT91_Gpio_WaveformStep {
+    TinyCLR_Gpio_PinValue value;
+    uint32_t duration; // nanoseconds
+};
+
+TinyCLR_Result AT91_Gpio_WriteWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, const AT91_Gpio_WaveformStep* steps, size_t count);
+TinyCLR_Result AT91_Gpio_CaptureWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& initialValue, uint32_t* durations, size_t& count, uint32_t timeout);
 TinyCLR_Result AT91_Gpio_SetDebounceTimeout(const TinyCLR_Gpio_Provider* self, int32_t pin, int32_t debounceTime);
 TinyCLR_Result AT91_Gpio_SetDriveMode(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinDriveMode mode);
 TinyCLR_Result AT91_Gpio_AcquirePin(const TinyCLR_Gpio_Provider* self, int32_t pin);
@@ -528,8 +549,13 @@ struct PwmController {
 
     bool                            invert[MAX_PWM_PER_CONTROLLER];
     double                          frequency;
-    double                          dutyCycle[MAX_PWM_PER_CONTROLLER];
+    uint32_t                        periodTicks;
+    uint32_t                        registerDividerFlag;
+    uint32_t                        dutyCycle[MAX_PWM_PER_CONTROLLER]; // Q16
 };
+
+#define AT91_PWM_DUTY_CYCLE_FULL 0x10000 // 1.0 in Q16
+
 const TinyCLR_Api_Info* AT91_Pwm_GetApi();
 void AT91_Pwm_Reset();
 void AT91_Pwm_ResetController(int32_t controller);
@@ -543,11 +569,38 @@ TinyCLR_Result AT91_Pwm_ReleasePin(const TinyCLR_Pwm_Provider* self, int32_t pin
 TinyCLR_Result AT91_Pwm_EnablePin(const TinyCLR_Pwm_Provider* self, int32_t pin);
 TinyCLR_Result AT91_Pwm_DisablePin(const TinyCLR_Pwm_Provider* self, int32_t pin);
 TinyCLR_Result AT91_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity);
+TinyCLR_Result AT91_Pwm_SetPulseParametersFixed(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity);
 double AT91_Pwm_GetMinFrequency(const TinyCLR_Pwm_Provider* self);
 double AT91_Pwm_GetMaxFrequency(const TinyCLR_Pwm_Provider* self);
 double AT91_Pwm_GetActualFrequency(const TinyCLR_Pwm_Provider* self);
 int32_t AT91_Pwm_GetPinCount(const TinyCLR_Pwm_Provider* self);
 
+//Counter
+enum class AT91_Counter_Edge : uint8_t {
+    Rising = 0,
+    Falling = 1,
+    Both = 2,
+};
+
+TinyCLR_Result AT91_Counter_Acquire(int32_t controller, AT91_Counter_Edge edge);
+TinyCLR_Result AT91_Counter_Release(int32_t controller);
+TinyCLR_Result AT91_Counter_GetCount(int32_t controller, uint64_t& count);
+TinyCLR_Result AT91_Counter_ClearCount(int32_t controller);
+TinyCLR_Result AT91_Counter_SetCompare(int32_t controller, uint64_t compare);
+TinyCLR_Result AT91_Counter_GetCompareReached(int32_t controller, bool& reached);
+
+//OnePulse
+enum class AT91_OnePulse_Trigger : uint8_t {
+    Software = 0,
+    RisingEdge = 1,
+    FallingEdge = 2,
+};
+
+TinyCLR_Result AT91_OnePulse_Acquire(int32_t controller, AT91_OnePulse_Trigger trigger, bool invert);
+TinyCLR_Result AT91_OnePulse_Release(int32_t controller);
+TinyCLR_Result AT91_OnePulse_SetPulse(int32_t controller, uint32_t delayNanoseconds, uint32_t widthNanoseconds);
+TinyCLR_Result AT91_OnePulse_Fire(int32_t controller);
+
 //SPI
 //////////////////////////////////////////////////////////////////////////////
 // AT91_SPI
@@ -1263,6 +1316,20 @@ void AT91_Time_DelayNoInterrupt(const TinyCLR_Time_Provider* self, uint64_t micr
 void AT91_Time_Delay(const TinyCLR_Time_Provider* self, uint64_t microseconds);
 void AT91_Time_GetDriftParameters(const TinyCLR_Time_Provider* self, int32_t* a, int32_t* b, int64_t* c);
 
+typedef void(*AT91_Time_TimerCallback)(void* param);
+
+struct AT91_Time_Timer {
+    AT91_Time_TimerCallback callback;
+    void* param;
+
+    uint64_t deadline; // processor ticks
+    uint64_t period; // processor ticks, 0 for one shot
+    int32_t index; // position in the timer heap
+};
+
+TinyCLR_Result AT91_Time_StartTimer(const TinyCLR_Time_Provider* self, AT91_Time_Timer* timer, uint64_t timeout, uint64_t period);
+TinyCLR_Result AT91_Time_StopTimer(const TinyCLR_Time_Provider* self, AT91_Time_Timer* timer);
+
 // Power
 const TinyCLR_Api_Info* AT91_Power_GetApi();
 void AT91_Power_SetHandlers(void(*stop)(), void(*restart)());
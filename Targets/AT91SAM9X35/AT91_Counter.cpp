@@ -0,0 +1,194 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "AT91.h"
+
+#ifdef INCLUDE_COUNTER
+///////////////////////////////////////////////////////////////////////////////
+
+// controller x is TC x clocked by XCx, which is TCLKx after reset. TC0 is the system timer.
+// The TC interrupt is owned by the system timer, so overflow and compare are polled from TC_SR.
+#define AT91_COUNTER_MASK 0xFFFFFFFF
+#define AT91_COUNTER_PERIPHERAL_ID(controller) AT91C_ID_TC0_TC1
+
+struct AT91_Counter_Controller {
+    bool acquired;
+
+    uint64_t wraps;
+    uint64_t clear; // count at the last ClearCount
+
+    uint64_t compare;
+    bool compareArmed;
+};
+
+static const AT91_Gpio_Pin g_AT91_Counter_Pins[] = AT91_COUNTER_PINS;
+
+static const int TOTAL_COUNTER_CONTROLLERS = SIZEOF_ARRAY(g_AT91_Counter_Pins);
+
+static AT91_Counter_Controller g_AT91_Counter_Controller[TOTAL_COUNTER_CONTROLLERS];
+
+static uint64_t AT91_Counter_Update(AT91_TC& tc, AT91_Counter_Controller& state) {
+    // reading TC_SR clears COVFS, a second read catches an overflow between the first read and TC_CV
+    if (tc.TC_SR & AT91_TC::TC_COVFS)
+        state.wraps++;
+
+    uint32_t count = tc.TC_CV & AT91_COUNTER_MASK;
+
+    if (tc.TC_SR & AT91_TC::TC_COVFS) {
+        state.wraps++;
+
+        count = tc.TC_CV & AT91_COUNTER_MASK;
+    }
+
+    return state.wraps * ((uint64_t)AT91_COUNTER_MASK + 1) + count;
+}
+
+TinyCLR_Result AT91_Counter_Acquire(int32_t controller, AT91_Counter_Edge edge) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (edge == AT91_Counter_Edge::Both) // the TC counts one edge of XCx
+        return TinyCLR_Result::NotSupported;
+
+    AT91_TC& tc = AT91::TIMER(controller);
+    auto& state = g_AT91_Counter_Controller[controller];
+
+    if (state.acquired || (tc.TC_SR & AT91_TC::TC_CLKSTA)) // system timer or another client
+        return TinyCLR_Result::SharingViolation;
+
+    auto& pin = g_AT91_Counter_Pins[controller];
+
+    if (pin.number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+    if (!AT91_Gpio_OpenPin(pin.number))
+        return TinyCLR_Result::SharingViolation;
+
+    AT91_Gpio_ConfigurePin(pin.number, AT91_Gpio_Direction::Input, pin.peripheralSelection, AT91_Gpio_ResistorMode::Inactive);
+
+    state.acquired = true;
+    state.wraps = 0;
+    state.clear = 0;
+    state.compareArmed = false;
+
+    AT91_PMC& pmc = AT91::PMC();
+
+    pmc.PMC_PCER = (1 << AT91_COUNTER_PERIPHERAL_ID(controller));
+
+    tc.TC_CCR = AT91_TC::TC_CLKDIS;
+    tc.TC_IDR = 0xFFFFFFFF;
+    tc.TC_CMR = (AT91_TC::TC_CLKS_XC0 + controller) | (edge == AT91_Counter_Edge::Falling ? AT91_TC::TC_CLKI : 0); // capture mode, no loads
+
+    (void)tc.TC_SR;
+
+    tc.TC_CCR = AT91_TC::TC_CLKEN | AT91_TC::TC_SWTRG;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result AT91_Counter_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_AT91_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    AT91_TC& tc = AT91::TIMER(controller);
+
+    tc.TC_CCR = AT91_TC::TC_CLKDIS;
+    tc.TC_CMR = 0;
+
+    (void)tc.TC_SR;
+
+    auto& pin = g_AT91_Counter_Pins[controller];
+
+    AT91_Gpio_ConfigurePin(pin.number, AT91_Gpio_Direction::Input, AT91_Gpio_PeripheralSelection::None, AT91_Gpio_ResistorMode::Inactive);
+    AT91_Gpio_ClosePin(pin.number);
+
+    state.acquired = false;
+
+    return TinyCLR_Result::Success;
+}
+
+// must be polled at least once per counter lap to keep the 64 bit count
+TinyCLR_Result AT91_Counter_GetCount(int32_t controller, uint64_t& count) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_AT91_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    count = AT91_Counter_Update(AT91::TIMER(controller), state) - state.clear;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result AT91_Counter_ClearCount(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_AT91_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    state.clear = AT91_Counter_Update(AT91::TIMER(controller), state);
+    state.compareArmed = false; // refers to the old count
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result AT91_Counter_SetCompare(int32_t controller, uint64_t compare) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_AT91_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    state.compare = state.clear + compare;
+    state.compareArmed = true;
+
+    return TinyCLR_Result::Success;
+}
+
+// reached stays set until the next SetCompare or ClearCount
+TinyCLR_Result AT91_Counter_GetCompareReached(int32_t controller, bool& reached) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_AT91_Counter_Controller[controller];
+
+    if (!state.acquired || !state.compareArmed)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    reached = AT91_Counter_Update(AT91::TIMER(controller), state) >= state.compare;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
@@ -22,6 +22,11 @@ static const AT91_Gpio_PinConfiguration g_at91_pins[] = AT91_GPIO_PINS;
 
 #define PIO_PPDDR(x)	(*(volatile unsigned long *)(0xFFFFF490 + (x * 0x200))) // Pull-down Disable Resistor Register -- Write Only
 #define PIO_PPDER(x)	(*(volatile unsigned long *)(0xFFFFF494 + (x * 0x200))) // Pull-down Enable Resistor Register -- Write Only
+#define PIO_IFSCER(x)	(*(volatile unsigned long *)(0xFFFFF484 + (x * 0x200))) // Input Filter Slow Clock Enable Register -- Write Only
+#define PIO_SCDR(x)	(*(volatile unsigned long *)(0xFFFFF48C + (x * 0x200))) // Slow Clock Divider Debouncing Register
+
+#define AT91_Gpio_SlowClockHz                 32768
+#define AT91_Gpio_DebounceFilterMaxMilisecond 1000 // 2 * (0x3FFF + 1) slow clock periods
 
 #define GETPORT(pin)    (pin/32)
 #define GETBIT(pin)     (pin%32)
@@ -43,6 +48,19 @@ static uint64_t                     g_debounceTicksPin[AT91_Gpio_MaxPins];
 static AT91_Int_State              	g_int_state[AT91_Gpio_MaxPins]; // interrupt state
 static TinyCLR_Gpio_PinDriveMode    g_pinDriveMode[AT91_Gpio_MaxPins];
 
+// power of two, edges of queued pins are stored here by the interrupt and drained by ReadEvents or DispatchEvents
+#define AT91_Gpio_EventQueueSize                64
+
+struct AT91_Gpio_EventQueue {
+    volatile AT91_Gpio_Event                    events[AT91_Gpio_EventQueueSize];
+    volatile uint32_t                           head; // written by the interrupt only
+    volatile uint32_t                           tail; // written by the reader only
+    volatile uint32_t                           lost;
+};
+
+static bool                         g_eventQueued[AT91_Gpio_MaxPins];
+static AT91_Gpio_EventQueue          g_eventQueue;
+
 static TinyCLR_Gpio_Provider gpioProvider;
 static TinyCLR_Api_Info gpioApi;
 
@@ -85,6 +103,25 @@ TinyCLR_Result AT91_Gpio_Release(const TinyCLR_Gpio_Provider* self) {
     return TinyCLR_Result::Success;
 }
 
+// single producer: all pin interrupts run at the same priority and never preempt each other
+static void AT91_Gpio_PushEvent(int32_t pin, TinyCLR_Gpio_PinValue value) {
+    auto head = g_eventQueue.head;
+
+    if (head - g_eventQueue.tail >= AT91_Gpio_EventQueueSize) {
+        g_eventQueue.lost++;
+
+        return;
+    }
+
+    auto& event = g_eventQueue.events[head % AT91_Gpio_EventQueueSize];
+
+    event.pin = pin;
+    event.value = value;
+    event.ticks = AT91_Time_GetCurrentTicks(nullptr);
+
+    g_eventQueue.head = head + 1; // publish after the event is complete
+}
+
 void AT91_Gpio_InterruptHandler(void* param) {
     INTERRUPT_STARTED_SCOPED(isr);
 
@@ -94,18 +131,13 @@ void AT91_Gpio_InterruptHandler(void* param) {
 
         AT91_PIO &pioX = AT91::PIO(port);
 
-        uint32_t bitMask = 0x00000001;
-        uint32_t bitIndex = 0;
-
         uint32_t interruptsActive = pioX.PIO_ISR;
 
         interruptsActive &= pioX.PIO_IMR;
 
         while (interruptsActive) {
-            while ((interruptsActive & bitMask) == 0) {
-                bitMask <<= 1;
-                bitIndex++;
-            }
+            uint32_t bitIndex = 31 - __builtin_clz(interruptsActive); // highest pending pin, one iteration per pending pin
+            uint32_t bitMask = 1 << bitIndex;
 
             bool executeIsr = true;
 
@@ -123,7 +155,10 @@ void AT91_Gpio_InterruptHandler(void* param) {
             if (executeIsr) {
                 AT91_Gpio_Read(&gpioProvider, state->pin, state->currentValue); // read value as soon as possible
 
-                state->ISR(state->controller, state->pin, state->currentValue);
+                if (g_eventQueued[state->pin])
+                    AT91_Gpio_PushEvent(state->pin, state->currentValue);
+                else
+                    state->ISR(state->controller, state->pin, state->currentValue);
             }
 
             interruptsActive ^= bitMask;
@@ -132,6 +167,67 @@ void AT91_Gpio_InterruptHandler(void* param) {
 
 }
 
+// queued pins keep their value changed handler installed but it is no longer called from the interrupt,
+// the edges are timestamped and kept until the owner drains them from thread context
+TinyCLR_Result AT91_Gpio_SetEventQueueEnabled(const TinyCLR_Gpio_Provider* self, int32_t pin, bool enabled) {
+    if (pin < 0 || pin >= AT91_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    g_eventQueued[pin] = enabled;
+
+    return TinyCLR_Result::Success;
+}
+
+// single consumer: count is the capacity of events on entry and the number of events read on return
+TinyCLR_Result AT91_Gpio_ReadEvents(const TinyCLR_Gpio_Provider* self, AT91_Gpio_Event* events, size_t& count) {
+    auto tail = g_eventQueue.tail;
+    auto available = g_eventQueue.head - tail;
+    size_t read = 0;
+
+    while (read < count && read < available) {
+        auto& event = g_eventQueue.events[tail % AT91_Gpio_EventQueueSize];
+
+        events[read].pin = event.pin;
+        events[read].value = event.value;
+        events[read].ticks = event.ticks;
+
+        tail++;
+        read++;
+    }
+
+    g_eventQueue.tail = tail; // free the slots after they are copied
+
+    count = read;
+
+    return TinyCLR_Result::Success;
+}
+
+// calls the value changed handler of each queued edge in order, in the context of the caller
+TinyCLR_Result AT91_Gpio_DispatchEvents(const TinyCLR_Gpio_Provider* self) {
+    AT91_Gpio_Event events[8];
+    size_t count;
+
+    do {
+        count = SIZEOF_ARRAY(events);
+
+        AT91_Gpio_ReadEvents(self, events, count);
+
+        for (size_t i = 0; i < count; i++) {
+            auto state = &g_int_state[events[i].pin];
+
+            if (state->ISR)
+                state->ISR(state->controller, events[i].pin, events[i].value);
+        }
+    } while (count == SIZEOF_ARRAY(events));
+
+    return TinyCLR_Result::Success;
+}
+
+// edges dropped because the queue was full
+uint32_t AT91_Gpio_GetLostEventCount(const TinyCLR_Gpio_Provider* self) {
+    return g_eventQueue.lost;
+}
+
 TinyCLR_Result AT91_Gpio_SetValueChangedHandler(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_ValueChangedHandler ISR) {
     AT91_Int_State* state = &g_int_state[pin];
 
@@ -151,10 +247,25 @@ TinyCLR_Result AT91_Gpio_SetValueChangedHandler(const TinyCLR_Gpio_Provider* sel
         state->ISR = ISR;
         state->lastDebounceTicks = AT91_Time_GetCurrentTicks(nullptr);
 
+        uint32_t debounceMilisecond = AT91_Time_GetTimeForProcessorTicks(nullptr, (uint64_t)(g_debounceTicksPin[pin])) / 10000;
+
+        if (state->debounce && debounceMilisecond > 0 && debounceMilisecond <= AT91_Gpio_DebounceFilterMaxMilisecond) {
+            // the PIO debounce filter drops pulses shorter than the divided slow clock, the divider is shared by the whole port
+            PIO_SCDR(port) = (debounceMilisecond * (AT91_Gpio_SlowClockHz / 2)) / 1000 - 1;
+            PIO_IFSCER(port) = bitmask;
+            pioX.PIO_IFER = bitmask;
+
+            state->debounce = 0; // filtered in hardware, no tick compare in the interrupt
+        }
+        else {
+            pioX.PIO_IFDR = bitmask;
+        }
+
         pioX.PIO_IER = bitmask; // Enable interrupt
     }
     else {
         pioX.PIO_IDR = bitmask; // Disable interrupt
+        pioX.PIO_IFDR = bitmask;
     }
 
     return TinyCLR_Result::Success;
@@ -354,6 +465,134 @@ TinyCLR_Result AT91_Gpio_Write(const TinyCLR_Gpio_Provider* self, int32_t pin, T
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result AT91_Gpio_ReadPort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t& value) {
+    if (port < 0 || port >= MAX_PORT)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    value = AT91::PIO(port).PIO_PDSR;
+
+    return TinyCLR_Result::Success;
+}
+
+// pins in mask take their bit from value in a single PIO_ODSR write, the others are write protected by PIO_OWSR
+TinyCLR_Result AT91_Gpio_WritePort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t mask, uint32_t value) {
+    if (port < 0 || port >= MAX_PORT)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    AT91_PIO &pioX = AT91::PIO(port);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    pioX.PIO_OWER = mask;
+    pioX.PIO_ODSR = value;
+    pioX.PIO_OWDR = mask;
+
+    return TinyCLR_Result::Success;
+}
+
+// waveforms are timed by the free running system timer and run with interrupts disabled
+#define AT91_Gpio_WaveformTimer 0 // system timer, clocked by TIMER_CLOCK3
+#define AT91_Gpio_WaveformClockHz (AT91_SYSTEM_PERIPHERAL_CLOCK_HZ / 32)
+
+struct AT91_Gpio_WaveformClock {
+    uint32_t last;
+    uint32_t ticks;
+};
+
+static uint32_t AT91_Gpio_WaveformNanosecondsToTicks(uint32_t nanoseconds) {
+    return ((uint64_t)nanoseconds * AT91_Gpio_WaveformClockHz) / 1000000000;
+}
+
+// extends the counter to 32 bit, it has to be read at least once per lap
+static uint32_t AT91_Gpio_WaveformNow(AT91_Gpio_WaveformClock& clock) {
+    uint32_t counter = AT91::TIMER(AT91_Gpio_WaveformTimer).TC_CV;
+
+    clock.ticks += (counter - clock.last) & 0xFFFFFFFF;
+    clock.last = counter;
+
+    return clock.ticks;
+}
+
+// each step holds its level for its duration, the edges are placed against the start so the delays do not add up
+TinyCLR_Result AT91_Gpio_WriteWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, const AT91_Gpio_WaveformStep* steps, size_t count) {
+    if (pin < 0 || pin >= AT91_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (steps == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    AT91_PIO &pioX = AT91::PIO(GETPORT(pin));
+    uint32_t mask = 1 << GETBIT(pin);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    AT91_Gpio_WaveformClock clock = { AT91::TIMER(AT91_Gpio_WaveformTimer).TC_CV, 0 };
+    uint32_t deadline = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (steps[i].value == TinyCLR_Gpio_PinValue::High)
+            pioX.PIO_SODR = mask;
+        else
+            pioX.PIO_CODR = mask;
+
+        deadline += AT91_Gpio_WaveformNanosecondsToTicks(steps[i].duration);
+
+        while ((int32_t)(AT91_Gpio_WaveformNow(clock) - deadline) < 0);
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+// durations receives the time between edges, starting from the call, until count edges are seen or
+// the pin stays unchanged for timeout nanoseconds. count returns the number of edges.
+TinyCLR_Result AT91_Gpio_CaptureWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& initialValue, uint32_t* durations, size_t& count, uint32_t timeout) {
+    if (pin < 0 || pin >= AT91_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (durations == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    AT91_PIO &pioX = AT91::PIO(GETPORT(pin));
+    uint32_t mask = 1 << GETBIT(pin);
+
+    uint32_t timeoutTicks = AT91_Gpio_WaveformNanosecondsToTicks(timeout);
+    size_t captured = 0;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        uint32_t level = (pioX.PIO_PDSR & mask);
+
+        AT91_Gpio_WaveformClock clock = { AT91::TIMER(AT91_Gpio_WaveformTimer).TC_CV, 0 };
+        uint32_t last = 0;
+
+        initialValue = level ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+
+        while (captured < count) {
+            uint32_t now = AT91_Gpio_WaveformNow(clock);
+
+            if (((pioX.PIO_PDSR & mask)) == level) {
+                if (now - last >= timeoutTicks)
+                    break;
+
+                continue;
+            }
+
+            level ^= mask;
+
+            durations[captured++] = now - last; // ticks for now, converted once the capture is over
+            last = now;
+        }
+    }
+
+    for (size_t i = 0; i < captured; i++)
+        durations[i] = ((uint64_t)durations[i] * 1000000000) / AT91_Gpio_WaveformClockHz;
+
+    count = captured;
+
+    return TinyCLR_Result::Success;
+}
+
 TinyCLR_Result AT91_Gpio_AcquirePin(const TinyCLR_Gpio_Provider* self, int32_t pin) {
 
     DISABLE_INTERRUPTS_SCOPED(irq);
@@ -464,8 +703,11 @@ void AT91_Gpio_Reset() {
         pioX.PIO_ISR ^= 0xffffffff;
     }
 
+    g_eventQueue.tail = g_eventQueue.head;
+
     for (auto pin = 0; pin < AT91_Gpio_GetPinCount(&gpioProvider); pin++) {
         g_pinReserved[pin] = false;
+        g_eventQueued[pin] = false;
         AT91_Gpio_SetDebounceTimeout(&gpioProvider, pin, AT91_Gpio_DebounceDefaultMilisecond);
     }
 
@@ -214,43 +214,23 @@ double AT91_Pwm_GetMinFrequency(const TinyCLR_Pwm_Provider* self) {
     return AT91_MIN_PWM_FREQUENCY;
 }
 
-TinyCLR_Result AT91_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity) {
+static uint32_t AT91_Pwm_GetPeriodTicks(double frequency, uint32_t& registerDividerFlag) {
     uint32_t period = 0;
-    uint32_t duration = 0;
     uint32_t scale = 0;
 
-    uint32_t convertedPeriod = 0;
-    uint32_t convertedDuration = 0;
-    uint32_t pulseBeginsOnHighEdge = 1; // Default Pulse starts on High Edge.
-
     uint32_t divider = 4; // Sets the default period/duration clock divider to 4 --> (MCK / divider) // MCK = 100 MHz
-    uint32_t registerDividerFlag = 0x2; // Sets the default channel clock divider to 4 --> (MCK / divider) // MCK = 100 MHz
 
-    double frequency = g_PwmController[self->Index].frequency;
+    registerDividerFlag = 0x2; // Sets the default channel clock divider to 4 --> (MCK / divider) // MCK = 100 MHz
 
-    AT91_Pwm_GetScaleFactor(frequency, period, scale);
-
-    duration = (uint32_t)(dutyCycle * period);
+    if (frequency <= 0.0)
+        return 0;
 
-    switch (scale) {
-    case PWM_MILLISECONDS:
-        convertedPeriod = (period * 1000000);
-        convertedDuration = (duration * 1000000);
-        break;
+    AT91_Pwm_GetScaleFactor(frequency, period, scale);
 
-    case PWM_MICROSECONDS:
-        convertedPeriod = (period * 1000);
-        convertedDuration = (duration * 1000);
-        break;
-
-    case PWM_NANOSECONDS:
-        convertedPeriod = period;
-        convertedDuration = duration;
-        break;
-    }
+    uint32_t convertedPeriod = period * (PWM_NANOSECONDS / scale);
 
     if (convertedPeriod > 503308801) {
-        return TinyCLR_Result::InvalidOperation;
+        return 0;
     }
     else if (convertedPeriod > 251654401) {
         divider = 1024;
@@ -298,35 +278,60 @@ TinyCLR_Result AT91_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int
         registerDividerFlag = 0x0;
     }
     else {
-        return TinyCLR_Result::InvalidOperation;
+        return 0;
     }
 
+    // 7.5ns per MCK tick
+    return (convertedPeriod * 2) / (divider * 15);
+}
+
+TinyCLR_Result AT91_Pwm_SetPulseParametersFixed(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity) {
+    uint32_t periodTicks = g_PwmController[self->Index].periodTicks;
+    uint32_t pulseBeginsOnHighEdge = 1; // Default Pulse starts on High Edge.
+
+    if (periodTicks == 0)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (dutyCycle > AT91_PWM_DUTY_CYCLE_FULL)
+        dutyCycle = AT91_PWM_DUTY_CYCLE_FULL;
+
     // Flips the pulse
     if (invertPolarity == 0)
         pulseBeginsOnHighEdge = 1;
     else
         pulseBeginsOnHighEdge = 0;
 
-    *g_PwmController[self->Index].channelModeReg = (volatile unsigned long)(registerDividerFlag | (pulseBeginsOnHighEdge << 9) | (1 << 10));
-    *g_PwmController[self->Index].channelUpdateReg = (volatile unsigned long)(convertedPeriod / (divider * 7.5));
-    *g_PwmController[self->Index].dutyCycleReg = (volatile unsigned long)(convertedDuration / (divider * 7.5));
+    *g_PwmController[self->Index].channelModeReg = (volatile unsigned long)(g_PwmController[self->Index].registerDividerFlag | (pulseBeginsOnHighEdge << 9) | (1 << 10));
+    *g_PwmController[self->Index].channelUpdateReg = periodTicks;
+    *g_PwmController[self->Index].dutyCycleReg = (uint32_t)(((uint64_t)dutyCycle * periodTicks) >> 16);
 
     g_PwmController[self->Index].invert[pin] = invertPolarity;
     g_PwmController[self->Index].dutyCycle[pin] = dutyCycle;
 
     return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result AT91_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity) {
+    uint32_t fixed = 0;
+
+    if (dutyCycle >= 1.0)
+        fixed = AT91_PWM_DUTY_CYCLE_FULL;
+    else if (dutyCycle > 0.0)
+        fixed = (uint32_t)(dutyCycle * AT91_PWM_DUTY_CYCLE_FULL + 0.5);
 
+    return AT91_Pwm_SetPulseParametersFixed(self, pin, fixed, invertPolarity);
 }
 
 TinyCLR_Result AT91_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Provider* self, double& frequency) {
     g_PwmController[self->Index].frequency = frequency;
+    g_PwmController[self->Index].periodTicks = AT91_Pwm_GetPeriodTicks(frequency, g_PwmController[self->Index].registerDividerFlag);
 
     // Calculate actual frequency
     frequency = AT91_Pwm_GetActualFrequency(self);
 
     for (int p = 0; p < MAX_PWM_PER_CONTROLLER; p++)
         if (g_PwmController[self->Index].gpioPin[p].number != PIN_NONE)
-            if (AT91_Pwm_SetPulseParameters(self, p, g_PwmController[self->Index].dutyCycle[p], g_PwmController[self->Index].invert[p]) != TinyCLR_Result::Success)
+            if (AT91_Pwm_SetPulseParametersFixed(self, p, g_PwmController[self->Index].dutyCycle[p], g_PwmController[self->Index].invert[p]) != TinyCLR_Result::Success)
                 return TinyCLR_Result::InvalidOperation;
 
 
@@ -380,7 +385,9 @@ void AT91_Pwm_ResetController(int32_t controller) {
             g_PwmController[pwmProviders[controller]->Index].channelUpdateReg = PWM_CHANNEL_UPDATE_REGISTER(controller);
             g_PwmController[pwmProviders[controller]->Index].invert[p] = false;
             g_PwmController[pwmProviders[controller]->Index].frequency = 0.0;
-            g_PwmController[pwmProviders[controller]->Index].dutyCycle[p] = 0.0;
+            g_PwmController[pwmProviders[controller]->Index].periodTicks = 0;
+            g_PwmController[pwmProviders[controller]->Index].registerDividerFlag = 0;
+            g_PwmController[pwmProviders[controller]->Index].dutyCycle[p] = 0;
         }
     }
 }
@@ -16,6 +16,9 @@
 #include "AT91.h"
 
 #define AT91_SLEEP_USEC_FIXED_OVERHEAD_CLOCKS 4
+#define AT91_TIME_COUNTER_MASK 0xFFFFFFFF
+#define AT91_TIME_OVERFLOW_FLAG 0x80000000
+#define TIMER_IDLE_VALUE 0x0000FFFFFFFFFFFFull
 
 #define SLOW_CLOCKS_PER_SECOND              (AT91_SYSTEM_PERIPHERAL_CLOCK_HZ / 32)
 #define CLOCK_COMMON_FACTOR                 10
@@ -83,6 +86,15 @@ struct AT91_TIMER_Driver {
         return    TC.TC_CV;
     }
 
+    static void ResetCompareHit(uint32_t Timer) {
+        if (!(Timer < AT91_TIMER_Driver::c_MaxTimer))
+            return;
+
+        AT91_TC &TC = AT91::TIMER(Timer);
+
+        (void)TC.TC_SR;
+    }
+
     static bool DidTimerOverFlow(uint32_t Timer) {
         if (!(Timer < AT91_TIMER_Driver::c_MaxTimer))
             return false;
@@ -196,7 +208,7 @@ void AT91_TIMER_Driver::ISR_TIMER(void* param) {
 // AT91_TIME_Driver
 //
 struct AT91_TIME_Driver {
-    uint64_t m_lastRead;
+    volatile uint64_t m_lastRead; // written with interrupts disabled at least every quarter lap of the counter
     uint64_t m_nextCompare;
 
     TinyCLR_Time_TickCallback m_DequeuAndExecute;
@@ -235,19 +247,26 @@ const TinyCLR_Api_Info* AT91_Time_GetApi() {
     return &timeApi;
 }
 
+static void AT91_Time_ScheduleCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks);
+static void AT91_Time_Dispatch(const TinyCLR_Time_Provider* self);
+
 void AT91_Time_InterruptHandler(void* Param) {
     TinyCLR_Time_Provider *provider = (TinyCLR_Time_Provider*)Param;
 
+    AT91_TIMER_Driver::ResetCompareHit(AT91_TIMER_Driver::c_SystemTimer);
+
+    g_AT91_TIME_Driver.m_lastRead = AT91_Time_GetCurrentTicks(provider);
+
     if (AT91_Time_GetCurrentTicks(provider) >= g_AT91_TIME_Driver.m_nextCompare) {
         // this also schedules the next one, if there is one
-        g_AT91_TIME_Driver.m_DequeuAndExecute();
+        AT91_Time_Dispatch(provider);
     }
     else {
         //
         // Because we are limited in the resolution of timer,
         // resetting the compare will properly configure the next interrupt.
         //
-        AT91_Time_SetCompare(provider, g_AT91_TIME_Driver.m_nextCompare);
+        AT91_Time_ScheduleCompare(provider, g_AT91_TIME_Driver.m_nextCompare);
     }
 }
 
@@ -292,22 +311,25 @@ uint64_t AT91_Time_GetCurrentTicks(const TinyCLR_Time_Provider* self) {
     if (self != nullptr)
         timer = self->Index;
 
-    DISABLE_INTERRUPTS_SCOPED(irq);
-
-    uint32_t value = AT91_TIMER_Driver::ReadCounter(AT91_TIMER_Driver::c_SystemTimer);
+    uint64_t lastValue;
 
-    g_AT91_TIME_Driver.m_lastRead &= (0xFFFFFFFF00000000ull);
+    // no interrupt masking: read the snapshot again until no update came in between,
+    // the counter is read after it and is less than half a lap ahead
+    do {
+        lastValue = g_AT91_TIME_Driver.m_lastRead;
+    } while (lastValue != g_AT91_TIME_Driver.m_lastRead);
 
-    if (AT91_TIMER_Driver::DidTimerOverFlow(AT91_TIMER_Driver::c_SystemTimer)) {
-        g_AT91_TIME_Driver.m_lastRead += (0x1ull << 32);
-    }
+    uint32_t value = AT91_TIMER_Driver::ReadCounter(AT91_TIMER_Driver::c_SystemTimer) & AT91_TIME_COUNTER_MASK;
+    uint64_t result = (lastValue & ~(uint64_t)AT91_TIME_COUNTER_MASK) | value;
 
-    g_AT91_TIME_Driver.m_lastRead |= value;
+    if ((lastValue & AT91_TIME_OVERFLOW_FLAG) && !(value & AT91_TIME_OVERFLOW_FLAG))
+        result += (uint64_t)AT91_TIME_COUNTER_MASK + 1;
 
-    return (uint64_t)g_AT91_TIME_Driver.m_lastRead;
+    return result;
 }
 
-TinyCLR_Result AT91_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
+// programs the hardware compare, a passed processorTicks forces the interrupt
+static void AT91_Time_ScheduleCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
     int32_t timer = 0;
 
     if (self != nullptr)
@@ -321,14 +343,16 @@ TinyCLR_Result AT91_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t
 
     uint64_t CntrValue = AT91_Time_GetCurrentTicks(self);
 
+    g_AT91_TIME_Driver.m_lastRead = CntrValue;
+
     if (processorTicks <= CntrValue) {
         fForceInterrupt = true;
     }
     else {
         uint32_t diff;
 
-        if ((processorTicks - CntrValue) > AT91_TIMER_Driver::c_MaxTimerValue) {
-            diff = AT91_TIMER_Driver::c_MaxTimerValue;
+        if ((processorTicks - CntrValue) > AT91_TIME_OVERFLOW_FLAG / 2) {
+            diff = AT91_TIME_OVERFLOW_FLAG / 2; // keeps the snapshot within a quarter lap
         }
         else {
             diff = (uint32_t)(processorTicks - CntrValue);
@@ -347,6 +371,173 @@ TinyCLR_Result AT91_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t
         AT91_TIMER_Driver::ForceInterrupt(AT91_TIMER_Driver::c_SystemTimer);
     }
 
+}
+
+//******************** Timer service ********************
+
+// native timers share the hardware compare with the runtime: a min heap on the deadline keeps the earliest
+// timer at the top, and the compare is set to the earlier of it and the runtime event
+#define AT91_Time_MaxTimers 32
+
+static AT91_Time_Timer* g_AT91_Time_Timers[AT91_Time_MaxTimers];
+static int32_t g_AT91_Time_TimerCount;
+
+static uint64_t g_runtimeEvent = TIMER_IDLE_VALUE; // next event asked for by the runtime
+
+static void AT91_Time_TimerSwap(int32_t a, int32_t b) {
+    auto timer = g_AT91_Time_Timers[a];
+
+    g_AT91_Time_Timers[a] = g_AT91_Time_Timers[b];
+    g_AT91_Time_Timers[b] = timer;
+
+    g_AT91_Time_Timers[a]->index = a;
+    g_AT91_Time_Timers[b]->index = b;
+}
+
+static void AT91_Time_TimerSiftUp(int32_t index) {
+    while (index > 0 && g_AT91_Time_Timers[(index - 1) / 2]->deadline > g_AT91_Time_Timers[index]->deadline) {
+        AT91_Time_TimerSwap(index, (index - 1) / 2);
+
+        index = (index - 1) / 2;
+    }
+}
+
+static void AT91_Time_TimerSiftDown(int32_t index) {
+    while (true) {
+        auto smallest = index;
+        auto left = index * 2 + 1;
+        auto right = index * 2 + 2;
+
+        if (left < g_AT91_Time_TimerCount && g_AT91_Time_Timers[left]->deadline < g_AT91_Time_Timers[smallest]->deadline)
+            smallest = left;
+
+        if (right < g_AT91_Time_TimerCount && g_AT91_Time_Timers[right]->deadline < g_AT91_Time_Timers[smallest]->deadline)
+            smallest = right;
+
+        if (smallest == index)
+            return;
+
+        AT91_Time_TimerSwap(index, smallest);
+
+        index = smallest;
+    }
+}
+
+static bool AT91_Time_TimerIsActive(AT91_Time_Timer* timer) {
+    return timer->index >= 0 && timer->index < g_AT91_Time_TimerCount && g_AT91_Time_Timers[timer->index] == timer;
+}
+
+static void AT91_Time_TimerInsert(AT91_Time_Timer* timer) {
+    timer->index = g_AT91_Time_TimerCount++;
+
+    g_AT91_Time_Timers[timer->index] = timer;
+
+    AT91_Time_TimerSiftUp(timer->index);
+}
+
+static void AT91_Time_TimerRemove(AT91_Time_Timer* timer) {
+    auto index = timer->index;
+
+    timer->index = -1;
+
+    if (index == --g_AT91_Time_TimerCount)
+        return;
+
+    g_AT91_Time_Timers[index] = g_AT91_Time_Timers[g_AT91_Time_TimerCount];
+    g_AT91_Time_Timers[index]->index = index;
+
+    AT91_Time_TimerSiftDown(index);
+    AT91_Time_TimerSiftUp(index);
+}
+
+static uint64_t AT91_Time_GetNextCompare() {
+    if (g_AT91_Time_TimerCount > 0 && g_AT91_Time_Timers[0]->deadline < g_runtimeEvent)
+        return g_AT91_Time_Timers[0]->deadline;
+
+    return g_runtimeEvent;
+}
+
+// runs the timers that are due, a periodic timer is queued again before its callback so the callback can stop it
+static void AT91_Time_ExecuteTimers(const TinyCLR_Time_Provider* self) {
+    auto now = AT91_Time_GetCurrentTicks(self);
+
+    while (g_AT91_Time_TimerCount > 0 && g_AT91_Time_Timers[0]->deadline <= now) {
+        auto timer = g_AT91_Time_Timers[0];
+
+        AT91_Time_TimerRemove(timer);
+
+        if (timer->period != 0) {
+            timer->deadline += timer->period;
+
+            if (timer->deadline <= now) // missed periods are skipped, not run in a burst
+                timer->deadline = now + timer->period;
+
+            AT91_Time_TimerInsert(timer);
+        }
+
+        timer->callback(timer->param);
+    }
+}
+
+static void AT91_Time_Dispatch(const TinyCLR_Time_Provider* self) {
+    AT91_Time_ExecuteTimers(self);
+
+    if (AT91_Time_GetCurrentTicks(self) >= g_runtimeEvent) {
+        g_runtimeEvent = TIMER_IDLE_VALUE;
+
+        g_AT91_TIME_Driver.m_DequeuAndExecute(); // schedules the next runtime event, if there is one
+    }
+
+    AT91_Time_ScheduleCompare(self, AT91_Time_GetNextCompare());
+}
+
+// timeout and period are in microseconds, a period of 0 makes a one shot timer. The callback runs in interrupt
+// context with interrupts disabled. The timer is owned by the caller and must stay valid while it is started.
+TinyCLR_Result AT91_Time_StartTimer(const TinyCLR_Time_Provider* self, AT91_Time_Timer* timer, uint64_t timeout, uint64_t period) {
+    if (timer == nullptr || timer->callback == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (AT91_Time_TimerIsActive(timer))
+        AT91_Time_TimerRemove(timer);
+
+    if (g_AT91_Time_TimerCount == AT91_Time_MaxTimers)
+        return TinyCLR_Result::NotAvailable;
+
+    timer->deadline = AT91_Time_GetCurrentTicks(self) + AT91_Time_MicrosecondsToTicks(self, timeout);
+    timer->period = AT91_Time_MicrosecondsToTicks(self, period);
+
+    if (period != 0 && timer->period == 0)
+        timer->period = 1;
+
+    AT91_Time_TimerInsert(timer);
+
+    if (timer->index == 0)
+        AT91_Time_ScheduleCompare(self, AT91_Time_GetNextCompare());
+
+    return TinyCLR_Result::Success;
+}
+
+// a stopped timer can leave one early compare interrupt behind, which finds nothing to run
+TinyCLR_Result AT91_Time_StopTimer(const TinyCLR_Time_Provider* self, AT91_Time_Timer* timer) {
+    if (timer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (AT91_Time_TimerIsActive(timer))
+        AT91_Time_TimerRemove(timer);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result AT91_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    g_runtimeEvent = processorTicks;
+
+    AT91_Time_ScheduleCompare(self, AT91_Time_GetNextCompare());
 
     return TinyCLR_Result::Success;
 }
@@ -35,6 +35,7 @@ TinyCLR_Result LPC17_Adc_Release(const TinyCLR_Adc_Provider* self);
 TinyCLR_Result LPC17_Adc_AcquireChannel(const TinyCLR_Adc_Provider* self, int32_t channel);
 TinyCLR_Result LPC17_Adc_ReleaseChannel(const TinyCLR_Adc_Provider* self, int32_t channel);
 TinyCLR_Result LPC17_Adc_ReadValue(const TinyCLR_Adc_Provider* self, int32_t channel, int32_t& value);
+TinyCLR_Result LPC17_Adc_ReadChannels(const TinyCLR_Adc_Provider* self, const int32_t* channels, int32_t* values, size_t count);
 int32_t LPC17_Adc_GetChannelCount(const TinyCLR_Adc_Provider* self);
 int32_t LPC17_Adc_GetResolutionInBits(const TinyCLR_Adc_Provider* self);
 int32_t LPC17_Adc_GetMinValue(const TinyCLR_Adc_Provider* self);
@@ -43,7 +44,24 @@ TinyCLR_Adc_ChannelMode LPC17_Adc_GetChannelMode(const TinyCLR_Adc_Provider* sel
 TinyCLR_Result LPC17_Adc_SetChannelMode(const TinyCLR_Adc_Provider* self, TinyCLR_Adc_ChannelMode mode);
 bool LPC17_Adc_IsChannelModeSupported(const TinyCLR_Adc_Provider* self, TinyCLR_Adc_ChannelMode mode);
 
+//DMA
+#define LPC17_DMA_CHANNELS 8
+
+typedef void(*LPC17_Dma_Handler)(int32_t channel, bool error);
+
+LPC_GPDMACH_TypeDef* LPC17_Dma_GetChannel(int32_t channel);
+bool LPC17_Dma_Acquire(int32_t channel, LPC17_Dma_Handler handler);
+void LPC17_Dma_Release(int32_t channel);
+
 //DAC
+enum class LPC17_Dac_PlaybackEvent : uint8_t {
+    HalfTransfer = 0,
+    TransferComplete = 1,
+    Error = 2,
+};
+
+typedef void(*LPC17_Dac_PlaybackHandler)(int32_t channel, LPC17_Dac_PlaybackEvent event);
+
 const TinyCLR_Api_Info* LPC17_Dac_GetApi();
 void LPC17_Dac_Reset();
 TinyCLR_Result LPC17_Dac_Acquire(const TinyCLR_Dac_Provider* self);
@@ -55,6 +73,8 @@ int32_t LPC17_Dac_GetChannelCount(const TinyCLR_Dac_Provider* self);
 int32_t LPC17_Dac_GetResolutionInBits(const TinyCLR_Dac_Provider* self);
 int32_t LPC17_Dac_GetMinValue(const TinyCLR_Dac_Provider* self);
 int32_t LPC17_Dac_GetMaxValue(const TinyCLR_Dac_Provider* self);
+TinyCLR_Result LPC17_Dac_StartPlayback(const TinyCLR_Dac_Provider* self, int32_t channel, const uint32_t* buffer, size_t length, uint32_t& sampleRate, bool circular, LPC17_Dac_PlaybackHandler handler);
+TinyCLR_Result LPC17_Dac_StopPlayback(const TinyCLR_Dac_Provider* self, int32_t channel);
 
 // GPIO
 enum class LPC17_Gpio_Direction : uint8_t {
@@ -133,6 +153,41 @@ TinyCLR_Result LPC17_Gpio_Release(const TinyCLR_Gpio_Provider* self);
 TinyCLR_Result LPC17_Gpio_EnableAlternatePin(int32_t pin, TinyCLR_Gpio_PinDriveMode resistor, uint32_t alternate);
 TinyCLR_Result LPC17_Gpio_Read(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& value);
 TinyCLR_Result LPC17_Gpio_Write(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue value);
+TinyCLR_Result LPC17_Gpio_ReadPort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t& value);
+TinyCLR_Result LPC17_Gpio_WritePort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t mask, uint32_t value);
+
+struct LPC17_Gpio_Event {
+    int32_t pin;
+    TinyCLR_Gpio_PinValue value;
+    uint64_t ticks; // processor ticks at the edge
+};
+
+TinyCLR_Result LPC17_Gpio_SetEventQueueEnabled(const TinyCLR_Gpio_Provider* self, int32_t pin, bool enabled);
+TinyCLR_Result LPC17_Gpio_ReadEvents(const TinyCLR_Gpio_Provider* self, LPC17_Gpio_Event* events, size_t& count);
+TinyCLR_Result LPC17_Gpio_DispatchEvents(const TinyCLR_Gpio_Provider* self);
+uint32_t LPC17_Gpio_GetLostEventCount(const TinyCLR_Gpio_Provider* self);
+
+struct LPC17_Gpio_WaveformStep {
+    TinyCLR_Gpio_PinValue value;
+    uint32_t duration; // nanoseconds
+};
+
+TinyCLR_Result LPC17_Gpio_WriteWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, const LPC17_Gpio_WaveformStep* steps, size_t count);
+TinyCLR_Result LPC17_Gpio_CaptureWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& initialValue, uint32_t* durations, size_t& count, uint32_t timeout);
+
+// bit-band alias words of one pin, the macros below are a single load or store without validation
+struct LPC17_Gpio_FastPin {
+    volatile uint32_t* input;
+    volatile uint32_t* output;
+    volatile uint32_t* set;
+    volatile uint32_t* clear;
+};
+
+TinyCLR_Result LPC17_Gpio_GetFastPin(const TinyCLR_Gpio_Provider* self, int32_t pin, LPC17_Gpio_FastPin& fastPin);
+
+#define LPC17_Gpio_FastRead(fastPin) (*(fastPin).input != 0)
+#define LPC17_Gpio_FastWrite(fastPin, value) (*((value) ? (fastPin).set : (fastPin).clear) = 1)
+#define LPC17_Gpio_FastToggle(fastPin) (*(*(fastPin).output ? (fastPin).clear : (fastPin).set) = 1)
 TinyCLR_Result LPC17_Gpio_SetDebounceTimeout(const TinyCLR_Gpio_Provider* self, int32_t pin, int32_t debounceTime);
 TinyCLR_Result LPC17_Gpio_SetDriveMode(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinDriveMode mode);
 TinyCLR_Result LPC17_Gpio_AcquirePin(const TinyCLR_Gpio_Provider* self, int32_t pin);
@@ -157,9 +212,20 @@ struct PwmController {
     uint32_t                        *matchAddress[MAX_PWM_PER_CONTROLLER];
     bool                            invert[MAX_PWM_PER_CONTROLLER];
     double                          frequency;
-    double                          dutyCycle[MAX_PWM_PER_CONTROLLER];
+    uint32_t                        periodTicks;
+    uint32_t                        dutyCycle[MAX_PWM_PER_CONTROLLER]; // Q16
+};
+
+#define LPC17_PWM_DUTY_CYCLE_FULL 0x10000 // 1.0 in Q16
+
+enum class LPC17_Pwm_SequenceEvent : uint8_t {
+    HalfTransfer = 0,
+    TransferComplete = 1,
+    Error = 2,
 };
 
+typedef void(*LPC17_Pwm_SequenceHandler)(int32_t controller, LPC17_Pwm_SequenceEvent event);
+
 const TinyCLR_Api_Info* LPC17_Pwm_GetApi();
 void LPC17_Pwm_Reset();
 void LPC17_Pwm_ResetController(int32_t controller);
@@ -172,12 +238,87 @@ TinyCLR_Result LPC17_Pwm_ReleasePin(const TinyCLR_Pwm_Provider* self, int32_t pi
 TinyCLR_Result LPC17_Pwm_EnablePin(const TinyCLR_Pwm_Provider* self, int32_t pin);
 TinyCLR_Result LPC17_Pwm_DisablePin(const TinyCLR_Pwm_Provider* self, int32_t pin);
 TinyCLR_Result LPC17_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity);
+TinyCLR_Result LPC17_Pwm_SetPulseParametersFixed(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity);
+TinyCLR_Result LPC17_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Provider* self, const int32_t* pins, const uint32_t* dutyCycles, const bool* invertPolarity, size_t count);
+uint32_t LPC17_Pwm_GetPeriodTicks(const TinyCLR_Pwm_Provider* self);
+TinyCLR_Result LPC17_Pwm_StartSequence(const TinyCLR_Pwm_Provider* self, int32_t pin, const uint32_t* matchValues, size_t length, bool circular, LPC17_Pwm_SequenceHandler handler);
+TinyCLR_Result LPC17_Pwm_StopSequence(const TinyCLR_Pwm_Provider* self);
 double LPC17_Pwm_GetMinFrequency(const TinyCLR_Pwm_Provider* self);
 double LPC17_Pwm_GetMaxFrequency(const TinyCLR_Pwm_Provider* self);
 double LPC17_Pwm_GetActualFrequency(const TinyCLR_Pwm_Provider* self);
 int32_t LPC17_Pwm_GetPinCount(const TinyCLR_Pwm_Provider* self);
 LPC17_Gpio_Pin LPC17_Pwm_GetPins(int32_t controller, int32_t channel);
 
+//Capture
+enum class LPC17_Capture_Edge : uint8_t {
+    Rising = 0,
+    Falling = 1,
+    Both = 2,
+};
+
+enum class LPC17_Capture_BufferEvent : uint8_t {
+    HalfTransfer = 0,
+    TransferComplete = 1,
+    Error = 2,
+};
+
+typedef void(*LPC17_Capture_BufferHandler)(int32_t controller, LPC17_Capture_BufferEvent event);
+
+TinyCLR_Result LPC17_Capture_Acquire(int32_t controller, uint32_t& frequency);
+TinyCLR_Result LPC17_Capture_Release(int32_t controller);
+uint32_t LPC17_Capture_GetCounterMask(int32_t controller);
+TinyCLR_Result LPC17_Capture_AcquireChannel(int32_t controller, int32_t channel, LPC17_Capture_Edge edge);
+TinyCLR_Result LPC17_Capture_ReleaseChannel(int32_t controller, int32_t channel);
+TinyCLR_Result LPC17_Capture_ReadTimestamp(int32_t controller, int32_t channel, uint32_t& timestamp, bool& overcapture);
+TinyCLR_Result LPC17_Capture_StartBuffer(int32_t controller, int32_t channel, uint32_t* timestamps, size_t length, bool circular, LPC17_Capture_BufferHandler handler);
+TinyCLR_Result LPC17_Capture_StopBuffer(int32_t controller, size_t& captured);
+TinyCLR_Result LPC17_Capture_AcquirePulse(int32_t controller, int32_t channel);
+TinyCLR_Result LPC17_Capture_ReadPulse(int32_t controller, uint32_t& period, uint32_t& highTime);
+
+//Encoder
+enum class LPC17_Encoder_Mode : uint8_t {
+    X2 = 0,
+    X4 = 1,
+};
+
+typedef void(*LPC17_Encoder_IndexHandler)(int32_t controller, int64_t position);
+
+TinyCLR_Result LPC17_Encoder_Acquire(int32_t controller, LPC17_Encoder_Mode mode, bool useIndex);
+TinyCLR_Result LPC17_Encoder_Release(int32_t controller);
+TinyCLR_Result LPC17_Encoder_GetPosition(int32_t controller, int64_t& position);
+TinyCLR_Result LPC17_Encoder_SetPosition(int32_t controller, int64_t position);
+TinyCLR_Result LPC17_Encoder_GetDirection(int32_t controller, bool& forward);
+TinyCLR_Result LPC17_Encoder_GetVelocity(int32_t controller, int32_t& countsPerSecond);
+TinyCLR_Result LPC17_Encoder_SetIndexHandler(int32_t controller, LPC17_Encoder_IndexHandler handler);
+
+//Counter
+enum class LPC17_Counter_Edge : uint8_t {
+    Rising = 0,
+    Falling = 1,
+    Both = 2,
+};
+
+typedef void(*LPC17_Counter_CompareHandler)(int32_t controller, uint64_t count);
+
+TinyCLR_Result LPC17_Counter_Acquire(int32_t controller, LPC17_Counter_Edge edge);
+TinyCLR_Result LPC17_Counter_Release(int32_t controller);
+TinyCLR_Result LPC17_Counter_GetCount(int32_t controller, uint64_t& count);
+TinyCLR_Result LPC17_Counter_ClearCount(int32_t controller);
+TinyCLR_Result LPC17_Counter_SetCompare(int32_t controller, uint64_t compare, LPC17_Counter_CompareHandler handler);
+
+//OnePulse
+enum class LPC17_OnePulse_Trigger : uint8_t {
+    Software = 0,
+    RisingEdge = 1,
+    FallingEdge = 2,
+};
+
+TinyCLR_Result LPC17_OnePulse_Acquire(int32_t controller, LPC17_OnePulse_Trigger trigger, bool invert);
+TinyCLR_Result LPC17_OnePulse_Release(int32_t controller);
+TinyCLR_Result LPC17_OnePulse_SetPulse(int32_t controller, uint32_t delayNanoseconds, uint32_t widthNanoseconds);
+TinyCLR_Result LPC17_OnePulse_Fire(int32_t controller);
+TinyCLR_Result LPC17_OnePulse_IsBusy(int32_t controller, bool& busy);
+
 //SPI
 const TinyCLR_Api_Info* LPC17_Spi_GetApi();
 void LPC17_Spi_Reset();
@@ -317,6 +458,20 @@ void LPC17_Time_DelayNoInterrupt(const TinyCLR_Time_Provider* self, uint64_t mic
 void LPC17_Time_Delay(const TinyCLR_Time_Provider* self, uint64_t microseconds);
 void LPC17_Time_GetDriftParameters(const TinyCLR_Time_Provider* self, int32_t* a, int32_t* b, int64_t* c);
 
+typedef void(*LPC17_Time_TimerCallback)(void* param);
+
+struct LPC17_Time_Timer {
+    LPC17_Time_TimerCallback callback;
+    void* param;
+
+    uint64_t deadline; // processor ticks
+    uint64_t period; // processor ticks, 0 for one shot
+    int32_t index; // position in the timer heap
+};
+
+TinyCLR_Result LPC17_Time_StartTimer(const TinyCLR_Time_Provider* self, LPC17_Time_Timer* timer, uint64_t timeout, uint64_t period);
+TinyCLR_Result LPC17_Time_StopTimer(const TinyCLR_Time_Provider* self, LPC17_Time_Timer* timer);
+
 // Power
 const TinyCLR_Api_Info* LPC17_Power_GetApi();
 void LPC17_Power_SetHandlers(void(*stop)(), void(*restart)());
@@ -424,6 +579,9 @@ void LPC17_Startup_GetRunApp(bool& runApp);
 #define PCONP_PCAN2_MASK 0x4000
 #define PCONP_PCAN2 0x4000
 #define PCONP_PCAN2_BIT 14
+#define PCONP_PCQEI_MASK 0x40000
+#define PCONP_PCQEI 0x40000
+#define PCONP_PCQEI_BIT 18
 #define PCONP_PCI2C1_MASK 0x80000
 #define PCONP_PCI2C1 0x80000
 #define PCONP_PCI2C1_BIT 19
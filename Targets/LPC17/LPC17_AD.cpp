@@ -231,6 +231,8 @@ struct LPC17xx_ADC {
 
 };
 
+#define LPC17xx_ADC_DataRegister(channel) (*((volatile uint32_t*)(LPC17xx_ADC::c_ADC_Base) + (channel)))
+
 static const LPC17_Gpio_Pin g_lpc17_adc_pins[] = LPC17_ADC_PINS;
 
 static TinyCLR_Adc_Provider adcProvider;
@@ -324,6 +326,35 @@ TinyCLR_Result LPC17_Adc_ReadValue(const TinyCLR_Adc_Provider* self, int32_t cha
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result LPC17_Adc_ReadChannels(const TinyCLR_Adc_Provider* self, const int32_t* channels, int32_t* values, size_t count) {
+    uint32_t mask = 0;
+
+    if (channels == nullptr || values == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    for (size_t i = 0; i < count; i++) {
+        if (channels[i] < 0 || channels[i] >= SIZEOF_ARRAY(g_lpc17_adc_pins))
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        if (!(AD0CR & (1 << channels[i]))) // channel not acquired
+            return TinyCLR_Result::InvalidOperation;
+
+        mask |= (1 << channels[i]);
+    }
+
+    // burst mode keeps converting all selected channels, reading a data register clears its DONE flag
+    for (size_t i = 0; i < count; i++)
+        (void)LPC17xx_ADC_DataRegister(channels[i]);
+
+    // wait for one full burst pass over the requested channels
+    while ((AD0STAT & mask) != mask);
+
+    for (size_t i = 0; i < count; i++)
+        values[i] = (LPC17xx_ADC_DataRegister(channels[i]) >> LPC17xx_ADC_DataRegisterShiftBits) & LPC17xx_ADC_BitRegisterMask;
+
+    return TinyCLR_Result::Success;
+}
+
 int32_t LPC17_Adc_GetChannelCount(const TinyCLR_Adc_Provider* self) {
     return SIZEOF_ARRAY(g_lpc17_adc_pins);
 }
@@ -0,0 +1,422 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include "LPC17.h"
+
+#ifdef INCLUDE_CAPTURE
+///////////////////////////////////////////////////////////////////////////////
+
+// controller x is timer x, channel y is CAPx.y
+#define LPC17_CAPTURE_CHANNELS 2
+#define LPC17_CAPTURE_PCLK_HZ (LPC17_SYSTEM_CLOCK_HZ / 2)
+#define LPC17_CAPTURE_DEFAULT_FREQUENCY 1000000
+
+#define LPC17_CAPTURE_CCR_RE(channel) (1 << (3 * (channel)))
+#define LPC17_CAPTURE_CCR_FE(channel) (2 << (3 * (channel)))
+#define LPC17_CAPTURE_CCR_I(channel) (4 << (3 * (channel)))
+#define LPC17_CAPTURE_IR_CR(channel) (0x10 << (channel))
+
+struct LPC17_Capture_Controller {
+    bool acquired;
+    uint32_t channels; // acquired channel mask
+
+    // last edge per channel, latched by the interrupt
+    uint32_t timestamp[LPC17_CAPTURE_CHANNELS];
+    bool pending[LPC17_CAPTURE_CHANNELS];
+    bool overcapture[LPC17_CAPTURE_CHANNELS];
+
+    bool pulse;
+    int32_t pulseChannel;
+    int32_t pulseEdges; // edges seen since acquire, a result needs rise-fall-rise
+    uint32_t lastRise;
+    uint32_t highTime;
+    uint32_t period;
+
+    int32_t bufferChannel; // -1 when idle
+    uint32_t* buffer;
+    size_t bufferLength;
+    size_t bufferIndex;
+    bool bufferCircular;
+    LPC17_Capture_BufferHandler handler;
+};
+
+static const LPC17_Gpio_Pin g_LPC17_Capture_Pins[][LPC17_CAPTURE_CHANNELS] = LPC17_CAPTURE_PINS;
+
+static const int TOTAL_CAPTURE_CONTROLLERS = SIZEOF_ARRAY(g_LPC17_Capture_Pins);
+
+static LPC17_Capture_Controller g_LPC17_Capture_Controller[TOTAL_CAPTURE_CONTROLLERS];
+
+static LPC_TIM_TypeDef* LPC17_Capture_GetTimer(int32_t controller) {
+    switch (controller) {
+    case 0: return LPC_TIM0;
+    case 1: return LPC_TIM1;
+    case 2: return LPC_TIM2;
+    case 3: return LPC_TIM3;
+    }
+
+    return nullptr;
+}
+
+static uint32_t LPC17_Capture_GetPower(int32_t controller) {
+    static const uint32_t power[] = { PCONP_PCTIM0, PCONP_PCTIM1, PCONP_PCTIM2, PCONP_PCTIM3 };
+
+    return power[controller];
+}
+
+static void LPC17_Capture_InterruptHandler(int32_t controller) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto timer = LPC17_Capture_GetTimer(controller);
+    auto& state = g_LPC17_Capture_Controller[controller];
+    auto ir = timer->IR & (LPC17_CAPTURE_IR_CR(0) | LPC17_CAPTURE_IR_CR(1));
+
+    timer->IR = ir; // clear
+
+    for (auto channel = 0; channel < LPC17_CAPTURE_CHANNELS; channel++) {
+        if (!(ir & LPC17_CAPTURE_IR_CR(channel)))
+            continue;
+
+        uint32_t timestamp = channel == 0 ? timer->CR0 : timer->CR1;
+
+        if (state.pulse) {
+            // one input alternates between rising and falling edge capture
+            if (timer->CCR & LPC17_CAPTURE_CCR_RE(channel)) {
+                if (state.pulseEdges >= 2) {
+                    state.period = timestamp - state.lastRise;
+                    state.pending[channel] = true;
+                }
+
+                state.lastRise = timestamp;
+                timer->CCR = LPC17_CAPTURE_CCR_FE(channel) | LPC17_CAPTURE_CCR_I(channel);
+            }
+            else {
+                state.highTime = timestamp - state.lastRise;
+                timer->CCR = LPC17_CAPTURE_CCR_RE(channel) | LPC17_CAPTURE_CCR_I(channel);
+            }
+
+            if (state.pulseEdges < 2)
+                state.pulseEdges++;
+        }
+        else if (state.bufferChannel == channel) {
+            state.buffer[state.bufferIndex++] = timestamp;
+
+            if (state.bufferCircular && state.bufferIndex == state.bufferLength / 2 && state.handler != nullptr)
+                state.handler(controller, LPC17_Capture_BufferEvent::HalfTransfer);
+
+            if (state.bufferIndex == state.bufferLength) {
+                auto handler = state.handler;
+
+                if (state.bufferCircular)
+                    state.bufferIndex = 0;
+                else
+                    state.bufferChannel = -1;
+
+                if (handler != nullptr)
+                    handler(controller, LPC17_Capture_BufferEvent::TransferComplete);
+            }
+        }
+        else {
+            state.overcapture[channel] |= state.pending[channel];
+            state.timestamp[channel] = timestamp;
+            state.pending[channel] = true;
+        }
+    }
+}
+
+void LPC17_Capture_InterruptHandler0(void* param) { LPC17_Capture_InterruptHandler(0); }
+void LPC17_Capture_InterruptHandler1(void* param) { LPC17_Capture_InterruptHandler(1); }
+void LPC17_Capture_InterruptHandler2(void* param) { LPC17_Capture_InterruptHandler(2); }
+void LPC17_Capture_InterruptHandler3(void* param) { LPC17_Capture_InterruptHandler(3); }
+
+static void (* const g_LPC17_Capture_Isr[])(void*) = {
+    &LPC17_Capture_InterruptHandler0, &LPC17_Capture_InterruptHandler1, &LPC17_Capture_InterruptHandler2, &LPC17_Capture_InterruptHandler3
+};
+
+static TinyCLR_Result LPC17_Capture_OpenPin(int32_t controller, int32_t channel) {
+    auto& pin = g_LPC17_Capture_Pins[controller][channel];
+
+    if (pin.number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+    if (!LPC17_Gpio_OpenPin(pin.number))
+        return TinyCLR_Result::SharingViolation;
+
+    LPC17_Gpio_ConfigurePin(pin.number, LPC17_Gpio_Direction::Input, pin.pinFunction, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+
+    return TinyCLR_Result::Success;
+}
+
+static void LPC17_Capture_ClosePin(int32_t controller, int32_t channel) {
+    auto& pin = g_LPC17_Capture_Pins[controller][channel];
+
+    LPC17_Gpio_ConfigurePin(pin.number, LPC17_Gpio_Direction::Input, LPC17_Gpio_PinFunction::PinFunction0, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+    LPC17_Gpio_ClosePin(pin.number);
+}
+
+// frequency is the requested counter tick rate in Hz and returns the actual rate
+TinyCLR_Result LPC17_Capture_Acquire(int32_t controller, uint32_t& frequency) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto timer = LPC17_Capture_GetTimer(controller);
+    auto& state = g_LPC17_Capture_Controller[controller];
+
+    if (state.acquired || ((LPC_SC->PCONP & LPC17_Capture_GetPower(controller)) && (timer->TCR & (1 << 0)))) // timer 3 runs PWM sequences
+        return TinyCLR_Result::SharingViolation;
+
+    if (frequency == 0)
+        frequency = LPC17_CAPTURE_DEFAULT_FREQUENCY;
+
+    uint32_t prescaler = LPC17_CAPTURE_PCLK_HZ / frequency;
+
+    if (prescaler == 0)
+        prescaler = 1;
+
+    frequency = LPC17_CAPTURE_PCLK_HZ / prescaler;
+
+    memset(&state, 0, sizeof(state));
+
+    state.acquired = true;
+    state.bufferChannel = -1;
+
+    LPC_SC->PCONP |= LPC17_Capture_GetPower(controller);
+
+    timer->TCR = (1 << 1); // hold in reset
+    timer->CTCR = 0; // timer mode
+    timer->PR = prescaler - 1;
+    timer->MCR = 0;
+    timer->CCR = 0;
+    timer->EMR = 0;
+    timer->IR = 0xFFFFFFFF;
+
+    LPC17_Interrupt_Activate(TIMER0_IRQn + controller, (uint32_t*)g_LPC17_Capture_Isr[controller], 0);
+
+    timer->TCR = (1 << 0); // free running 32 bit counter
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Capture_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto timer = LPC17_Capture_GetTimer(controller);
+    auto& state = g_LPC17_Capture_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    timer->CCR = 0;
+    timer->TCR = 0;
+    timer->IR = 0xFFFFFFFF;
+
+    LPC17_Interrupt_Deactivate(TIMER0_IRQn + controller);
+
+    for (auto channel = 0; channel < LPC17_CAPTURE_CHANNELS; channel++)
+        if (state.channels & (1 << channel))
+            LPC17_Capture_ClosePin(controller, channel);
+
+    LPC_SC->PCONP &= ~LPC17_Capture_GetPower(controller);
+
+    state.acquired = false;
+    state.channels = 0;
+
+    return TinyCLR_Result::Success;
+}
+
+uint32_t LPC17_Capture_GetCounterMask(int32_t controller) {
+    return 0xFFFFFFFF;
+}
+
+TinyCLR_Result LPC17_Capture_AcquireChannel(int32_t controller, int32_t channel, LPC17_Capture_Edge edge) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS || channel < 0 || channel >= LPC17_CAPTURE_CHANNELS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto timer = LPC17_Capture_GetTimer(controller);
+    auto& state = g_LPC17_Capture_Controller[controller];
+
+    if (!state.acquired || state.pulse)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (state.channels & (1 << channel))
+        return TinyCLR_Result::SharingViolation;
+
+    auto result = LPC17_Capture_OpenPin(controller, channel);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    uint32_t ccr = LPC17_CAPTURE_CCR_I(channel);
+
+    if (edge != LPC17_Capture_Edge::Falling) ccr |= LPC17_CAPTURE_CCR_RE(channel);
+    if (edge != LPC17_Capture_Edge::Rising) ccr |= LPC17_CAPTURE_CCR_FE(channel);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    state.pending[channel] = false;
+    state.overcapture[channel] = false;
+    state.channels |= 1 << channel;
+
+    timer->CCR = (timer->CCR & ~(7 << (3 * channel))) | ccr;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Capture_ReleaseChannel(int32_t controller, int32_t channel) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS || channel < 0 || channel >= LPC17_CAPTURE_CHANNELS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto timer = LPC17_Capture_GetTimer(controller);
+    auto& state = g_LPC17_Capture_Controller[controller];
+
+    if (!state.acquired || !(state.channels & (1 << channel)))
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    timer->CCR &= ~(7 << (3 * channel));
+
+    if (state.bufferChannel == channel)
+        state.bufferChannel = -1;
+
+    if (state.pulse)
+        state.pulse = false;
+
+    state.channels &= ~(1 << channel);
+
+    irq.Release();
+
+    LPC17_Capture_ClosePin(controller, channel);
+
+    return TinyCLR_Result::Success;
+}
+
+// timestamp is the counter value latched by the last edge
+TinyCLR_Result LPC17_Capture_ReadTimestamp(int32_t controller, int32_t channel, uint32_t& timestamp, bool& overcapture) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS || channel < 0 || channel >= LPC17_CAPTURE_CHANNELS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Capture_Controller[controller];
+
+    if (!state.acquired || !(state.channels & (1 << channel)) || state.pulse || state.bufferChannel == channel)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (!state.pending[channel])
+        return TinyCLR_Result::NotAvailable;
+
+    timestamp = state.timestamp[channel];
+    overcapture = state.overcapture[channel]; // edges were lost since the last read
+
+    state.pending[channel] = false;
+    state.overcapture[channel] = false;
+
+    return TinyCLR_Result::Success;
+}
+
+// the timer capture has no GPDMA request, edges are stored by the capture interrupt
+TinyCLR_Result LPC17_Capture_StartBuffer(int32_t controller, int32_t channel, uint32_t* timestamps, size_t length, bool circular, LPC17_Capture_BufferHandler handler) {
+    if (timestamps == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS || channel < 0 || channel >= LPC17_CAPTURE_CHANNELS || length == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Capture_Controller[controller];
+
+    if (!state.acquired || !(state.channels & (1 << channel)) || state.pulse || state.bufferChannel >= 0)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    state.buffer = timestamps;
+    state.bufferLength = length;
+    state.bufferIndex = 0;
+    state.bufferCircular = circular;
+    state.handler = handler;
+    state.bufferChannel = channel;
+
+    return TinyCLR_Result::Success;
+}
+
+// captured returns the number of timestamps written in the current pass over the buffer
+TinyCLR_Result LPC17_Capture_StopBuffer(int32_t controller, size_t& captured) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Capture_Controller[controller];
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    captured = state.bufferChannel >= 0 ? state.bufferIndex : 0;
+
+    state.bufferChannel = -1;
+
+    return TinyCLR_Result::Success;
+}
+
+// period and high time of one input, the interrupt swaps the capture edge so pulses shorter than its latency are missed
+TinyCLR_Result LPC17_Capture_AcquirePulse(int32_t controller, int32_t channel) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS || channel < 0 || channel >= LPC17_CAPTURE_CHANNELS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto timer = LPC17_Capture_GetTimer(controller);
+    auto& state = g_LPC17_Capture_Controller[controller];
+
+    if (!state.acquired || state.channels != 0)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto result = LPC17_Capture_OpenPin(controller, channel);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    state.pulse = true;
+    state.pulseChannel = channel;
+    state.pulseEdges = 0;
+    state.pending[channel] = false;
+    state.channels = 1 << channel;
+
+    timer->CCR = LPC17_CAPTURE_CCR_RE(channel) | LPC17_CAPTURE_CCR_I(channel);
+
+    return TinyCLR_Result::Success;
+}
+
+// period and highTime are in counter ticks of the last complete cycle
+TinyCLR_Result LPC17_Capture_ReadPulse(int32_t controller, uint32_t& period, uint32_t& highTime) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Capture_Controller[controller];
+
+    if (!state.acquired || !state.pulse)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (!state.pending[state.pulseChannel])
+        return TinyCLR_Result::NotAvailable;
+
+    period = state.period;
+    highTime = state.highTime;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
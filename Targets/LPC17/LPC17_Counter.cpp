@@ -0,0 +1,248 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC17.h"
+
+#ifdef INCLUDE_COUNTER
+///////////////////////////////////////////////////////////////////////////////
+
+// controller x is timer x in counter mode, clocked by CAPx.0
+#define LPC17_COUNTER_CTCR_INPUT_CAP0 (0 << 2)
+
+// MR0 is the compare, MR2 and MR3 sample TC twice per lap to extend it to 64 bit
+#define LPC17_COUNTER_MCR_MR0I (1 << 0)
+#define LPC17_COUNTER_MCR_MR2I (1 << 6)
+#define LPC17_COUNTER_MCR_MR3I (1 << 9)
+#define LPC17_COUNTER_IR_MR0 (1 << 0)
+#define LPC17_COUNTER_IR_MR2 (1 << 2)
+#define LPC17_COUNTER_IR_MR3 (1 << 3)
+
+struct LPC17_Counter_Controller {
+    bool acquired;
+
+    uint32_t lastCount;
+    uint64_t count;
+
+    uint64_t compare;
+    LPC17_Counter_CompareHandler handler;
+};
+
+static const LPC17_Gpio_Pin g_LPC17_Counter_Pins[] = LPC17_COUNTER_PINS;
+
+static const int TOTAL_COUNTER_CONTROLLERS = SIZEOF_ARRAY(g_LPC17_Counter_Pins);
+
+static LPC17_Counter_Controller g_LPC17_Counter_Controller[TOTAL_COUNTER_CONTROLLERS];
+
+static LPC_TIM_TypeDef* LPC17_Counter_GetTimer(int32_t controller) {
+    switch (controller) {
+    case 0: return LPC_TIM0;
+    case 1: return LPC_TIM1;
+    case 2: return LPC_TIM2;
+    case 3: return LPC_TIM3;
+    }
+
+    return nullptr;
+}
+
+static uint32_t LPC17_Counter_GetPower(int32_t controller) {
+    static const uint32_t power[] = { PCONP_PCTIM0, PCONP_PCTIM1, PCONP_PCTIM2, PCONP_PCTIM3 };
+
+    return power[controller];
+}
+
+static uint64_t LPC17_Counter_Update(LPC_TIM_TypeDef* timer, LPC17_Counter_Controller& state) {
+    uint32_t count = timer->TC;
+
+    // TC only counts up and is sampled at least every half lap, so the unsigned delta is exact
+    state.count += count - state.lastCount;
+    state.lastCount = count;
+
+    return state.count;
+}
+
+static void LPC17_Counter_InterruptHandler(int32_t controller) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto timer = LPC17_Counter_GetTimer(controller);
+    auto& state = g_LPC17_Counter_Controller[controller];
+    auto ir = timer->IR & (LPC17_COUNTER_IR_MR0 | LPC17_COUNTER_IR_MR2 | LPC17_COUNTER_IR_MR3);
+
+    timer->IR = ir; // clear
+
+    auto count = LPC17_Counter_Update(timer, state);
+
+    if ((ir & LPC17_COUNTER_IR_MR0) && (timer->MCR & LPC17_COUNTER_MCR_MR0I) && count >= state.compare) {
+        timer->MCR &= ~LPC17_COUNTER_MCR_MR0I;
+
+        if (state.handler != nullptr)
+            state.handler(controller, count);
+    }
+}
+
+void LPC17_Counter_InterruptHandler0(void* param) { LPC17_Counter_InterruptHandler(0); }
+void LPC17_Counter_InterruptHandler1(void* param) { LPC17_Counter_InterruptHandler(1); }
+void LPC17_Counter_InterruptHandler2(void* param) { LPC17_Counter_InterruptHandler(2); }
+void LPC17_Counter_InterruptHandler3(void* param) { LPC17_Counter_InterruptHandler(3); }
+
+static void (* const g_LPC17_Counter_Isr[])(void*) = {
+    &LPC17_Counter_InterruptHandler0, &LPC17_Counter_InterruptHandler1, &LPC17_Counter_InterruptHandler2, &LPC17_Counter_InterruptHandler3
+};
+
+TinyCLR_Result LPC17_Counter_Acquire(int32_t controller, LPC17_Counter_Edge edge) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto timer = LPC17_Counter_GetTimer(controller);
+    auto& state = g_LPC17_Counter_Controller[controller];
+
+    if (state.acquired || ((LPC_SC->PCONP & LPC17_Counter_GetPower(controller)) && (timer->TCR & (1 << 0)))) // timer used by capture or PWM sequences
+        return TinyCLR_Result::SharingViolation;
+
+    auto& pin = g_LPC17_Counter_Pins[controller];
+
+    if (pin.number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+    if (!LPC17_Gpio_OpenPin(pin.number))
+        return TinyCLR_Result::SharingViolation;
+
+    LPC17_Gpio_ConfigurePin(pin.number, LPC17_Gpio_Direction::Input, pin.pinFunction, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Enable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+
+    state.acquired = true;
+    state.lastCount = 0;
+    state.count = 0;
+    state.compare = 0;
+    state.handler = nullptr;
+
+    LPC_SC->PCONP |= LPC17_Counter_GetPower(controller);
+
+    timer->TCR = (1 << 1); // hold in reset
+    timer->CTCR = (static_cast<uint32_t>(edge) + 1) | LPC17_COUNTER_CTCR_INPUT_CAP0; // 1 rising, 2 falling, 3 both edges
+    timer->PR = 0;
+    timer->CCR = 0; // the counting input must not also capture
+    timer->EMR = 0;
+    timer->MR2 = 0x80000000;
+    timer->MR3 = 0;
+    timer->MCR = LPC17_COUNTER_MCR_MR2I | LPC17_COUNTER_MCR_MR3I;
+    timer->IR = 0xFFFFFFFF;
+
+    LPC17_Interrupt_Activate(TIMER0_IRQn + controller, (uint32_t*)g_LPC17_Counter_Isr[controller], 0);
+
+    timer->TCR = (1 << 0);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Counter_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto timer = LPC17_Counter_GetTimer(controller);
+    auto& state = g_LPC17_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    timer->TCR = 0;
+    timer->MCR = 0;
+    timer->CTCR = 0;
+    timer->IR = 0xFFFFFFFF;
+
+    LPC17_Interrupt_Deactivate(TIMER0_IRQn + controller);
+
+    LPC_SC->PCONP &= ~LPC17_Counter_GetPower(controller);
+
+    auto& pin = g_LPC17_Counter_Pins[controller];
+
+    LPC17_Gpio_ConfigurePin(pin.number, LPC17_Gpio_Direction::Input, LPC17_Gpio_PinFunction::PinFunction0, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+    LPC17_Gpio_ClosePin(pin.number);
+
+    state.acquired = false;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Counter_GetCount(int32_t controller, uint64_t& count) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    count = LPC17_Counter_Update(LPC17_Counter_GetTimer(controller), state);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Counter_ClearCount(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto timer = LPC17_Counter_GetTimer(controller);
+
+    timer->MCR &= ~LPC17_COUNTER_MCR_MR0I; // a pending compare refers to the old count
+
+    LPC17_Counter_Update(timer, state);
+
+    state.count = 0;
+
+    return TinyCLR_Result::Success;
+}
+
+// handler runs in interrupt context once the count reaches compare, no interrupt is taken per edge
+TinyCLR_Result LPC17_Counter_SetCompare(int32_t controller, uint64_t compare, LPC17_Counter_CompareHandler handler) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto timer = LPC17_Counter_GetTimer(controller);
+
+    timer->MCR &= ~LPC17_COUNTER_MCR_MR0I;
+
+    if (handler == nullptr)
+        return TinyCLR_Result::Success;
+
+    auto count = LPC17_Counter_Update(timer, state);
+
+    if (compare <= count)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    state.compare = compare;
+    state.handler = handler;
+
+    timer->MR0 = state.lastCount + (uint32_t)(compare - count);
+    timer->IR = LPC17_COUNTER_IR_MR0;
+    timer->MCR |= LPC17_COUNTER_MCR_MR0I;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
@@ -28,6 +28,25 @@
 #define LPC17_DAC_PRECISION_BITS 	10	// Number of Bits in the DAC Convertion
 #define LPC17_DAC_MAX_VALUE 	(1<<LPC17_DAC_PRECISION_BITS)
 
+#define DACCTRL_INT_DMA_REQ 0x1
+#define DACCTRL_DBLBUF_ENA 0x2
+#define DACCTRL_CNT_ENA 0x4
+#define DACCTRL_DMA_ENA 0x8
+
+#define LPC17_DAC_PCLK_HZ (LPC17_SYSTEM_CLOCK_HZ / 2)
+#define LPC17_DAC_MAX_COUNTER 0xFFFF
+
+#define LPC17_DAC_DMA_CHANNEL_INDEX 0
+#define LPC17_DAC_DMA_CHANNEL LPC_GPDMACH0
+#define LPC17_DAC_DMA_REQUEST 9 // DAC peripheral connection
+#define LPC17_DAC_DMA_MAX_TRANSFER 0xFFF // per linked list item
+
+#define GPDMA_CONFIG_E 0x1
+#define GPDMA_CCONTROL(size) ((size) | (2 << 18) | (2 << 21) | (1 << 26) | (1U << 31)) // word to word, source increment, terminal count interrupt
+#define GPDMA_CCONFIG_M2P (1 << 11)
+#define GPDMA_CCONFIG_IE (1 << 14)
+#define GPDMA_CCONFIG_ITC (1 << 15)
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static TinyCLR_Dac_Provider dacProvider;
@@ -37,6 +56,18 @@ static const LPC17_Gpio_Pin g_lpc17_dac_pins[] = LPC17_DAC_PINS;
 
 bool g_Lpc17_DacOpened = false;
 
+struct LPC17_Dac_DmaItem {
+    uint32_t source;
+    uint32_t destination;
+    uint32_t next;
+    uint32_t control;
+};
+
+static LPC17_Dac_DmaItem g_LPC17_Dac_DmaItems[2]; // one per buffer half in circular mode
+static LPC17_Dac_PlaybackHandler g_LPC17_Dac_PlaybackHandler;
+static bool g_LPC17_Dac_PlaybackCircular;
+static bool g_LPC17_Dac_PlaybackActive = false;
+
 const TinyCLR_Api_Info* LPC17_Dac_GetApi() {
     dacProvider.Parent = &dacApi;
     dacProvider.Index = 0;
@@ -95,6 +126,8 @@ TinyCLR_Result LPC17_Dac_ReleaseChannel(const TinyCLR_Dac_Provider* self, int32_
         return TinyCLR_Result::ArgumentOutOfRange;
 
     if (g_Lpc17_DacOpened) {
+        LPC17_Dac_StopPlayback(self, channel);
+
         DACR = (0 << 6); // This sets the initial starting voltage at 0
 
         LPC17_Gpio_ClosePin(g_lpc17_dac_pins[channel].number);
@@ -109,6 +142,9 @@ TinyCLR_Result LPC17_Dac_WriteValue(const TinyCLR_Dac_Provider* self, int32_t ch
     if (channel >= SIZEOF_ARRAY(g_lpc17_dac_pins))
         return TinyCLR_Result::ArgumentOutOfRange;
 
+    if (g_LPC17_Dac_PlaybackActive)
+        return TinyCLR_Result::InvalidOperation;
+
     if (value > LPC17_DAC_MAX_VALUE) {
         value = LPC17_DAC_MAX_VALUE;
     }
@@ -122,6 +158,109 @@ TinyCLR_Result LPC17_Dac_WriteValue(const TinyCLR_Dac_Provider* self, int32_t ch
     return TinyCLR_Result::Success;
 }
 
+static void LPC17_Dac_DmaHandler(int32_t channel, bool error) {
+    auto handler = g_LPC17_Dac_PlaybackHandler;
+
+    if (error) {
+        LPC17_Dac_StopPlayback(nullptr, 0);
+
+        if (handler != nullptr)
+            handler(0, LPC17_Dac_PlaybackEvent::Error);
+    }
+    else {
+        auto event = LPC17_Dac_PlaybackEvent::TransferComplete;
+
+        if (!g_LPC17_Dac_PlaybackCircular)
+            LPC17_Dac_StopPlayback(nullptr, 0);
+        else if (LPC17_DAC_DMA_CHANNEL->CLLI == (uint32_t)&g_LPC17_Dac_DmaItems[0]) // second half is playing
+            event = LPC17_Dac_PlaybackEvent::HalfTransfer;
+
+        if (handler != nullptr)
+            handler(0, event);
+    }
+}
+
+// buffer holds DACR words, the sample value in bits 6..15
+TinyCLR_Result LPC17_Dac_StartPlayback(const TinyCLR_Dac_Provider* self, int32_t channel, const uint32_t* buffer, size_t length, uint32_t& sampleRate, bool circular, LPC17_Dac_PlaybackHandler handler) {
+    if (buffer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (channel < 0 || channel >= SIZEOF_ARRAY(g_lpc17_dac_pins) || sampleRate == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (length == 0 || length > (circular ? 2 * LPC17_DAC_DMA_MAX_TRANSFER : LPC17_DAC_DMA_MAX_TRANSFER) || (circular && length < 2))
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    uint32_t counter = LPC17_DAC_PCLK_HZ / sampleRate;
+
+    if (counter == 0 || counter > LPC17_DAC_MAX_COUNTER + 1)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!g_Lpc17_DacOpened || g_LPC17_Dac_PlaybackActive)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto& first = g_LPC17_Dac_DmaItems[0];
+    auto& second = g_LPC17_Dac_DmaItems[1];
+
+    if (circular) {
+        size_t half = length / 2;
+
+        first.source = (uint32_t)buffer;
+        first.destination = (uint32_t)&LPC_DAC->CR;
+        first.next = (uint32_t)&second;
+        first.control = GPDMA_CCONTROL(half);
+
+        second.source = (uint32_t)(buffer + half);
+        second.destination = (uint32_t)&LPC_DAC->CR;
+        second.next = (uint32_t)&first;
+        second.control = GPDMA_CCONTROL(length - half);
+    }
+    else {
+        first.source = (uint32_t)buffer;
+        first.destination = (uint32_t)&LPC_DAC->CR;
+        first.next = 0;
+        first.control = GPDMA_CCONTROL(length);
+    }
+
+    if (!LPC17_Dma_Acquire(LPC17_DAC_DMA_CHANNEL_INDEX, &LPC17_Dac_DmaHandler))
+        return TinyCLR_Result::SharingViolation;
+
+    g_LPC17_Dac_PlaybackHandler = handler;
+    g_LPC17_Dac_PlaybackCircular = circular;
+    g_LPC17_Dac_PlaybackActive = true;
+
+    LPC17_DAC_DMA_CHANNEL->CSrcAddr = first.source;
+    LPC17_DAC_DMA_CHANNEL->CDestAddr = first.destination;
+    LPC17_DAC_DMA_CHANNEL->CLLI = first.next;
+    LPC17_DAC_DMA_CHANNEL->CControl = first.control;
+
+    LPC17_DAC_DMA_CHANNEL->CConfig = (LPC17_DAC_DMA_REQUEST << 6) | GPDMA_CCONFIG_M2P | GPDMA_CCONFIG_IE | GPDMA_CCONFIG_ITC | GPDMA_CONFIG_E;
+
+    // the DAC counter paces the DMA requests at PCLK / counter
+    LPC_DAC->CNTVAL = counter - 1;
+    LPC_DAC->CTRL = DACCTRL_DBLBUF_ENA | DACCTRL_CNT_ENA | DACCTRL_DMA_ENA;
+
+    sampleRate = LPC17_DAC_PCLK_HZ / counter;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Dac_StopPlayback(const TinyCLR_Dac_Provider* self, int32_t channel) {
+    if (channel < 0 || channel >= SIZEOF_ARRAY(g_lpc17_dac_pins))
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!g_LPC17_Dac_PlaybackActive)
+        return TinyCLR_Result::Success;
+
+    LPC_DAC->CTRL = 0;
+
+    LPC17_Dma_Release(LPC17_DAC_DMA_CHANNEL_INDEX);
+
+    g_LPC17_Dac_PlaybackActive = false;
+
+    return TinyCLR_Result::Success;
+}
+
 int32_t LPC17_Dac_GetChannelCount(const TinyCLR_Dac_Provider* self) {
     return SIZEOF_ARRAY(g_lpc17_dac_pins);
 }
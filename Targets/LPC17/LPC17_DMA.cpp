@@ -0,0 +1,91 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC17.h"
+
+#define GPDMA_CONFIG_E 0x1
+
+// all GPDMA channels share one interrupt, handlers are dispatched per channel
+static LPC17_Dma_Handler g_LPC17_Dma_Handlers[LPC17_DMA_CHANNELS];
+static uint32_t g_LPC17_Dma_Acquired = 0;
+
+void LPC17_Dma_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    uint32_t completed = LPC_GPDMA->IntTCStat;
+    uint32_t error = LPC_GPDMA->IntErrStat;
+
+    LPC_GPDMA->IntTCClear = completed;
+    LPC_GPDMA->IntErrClr = error;
+
+    for (auto channel = 0; channel < LPC17_DMA_CHANNELS; channel++) {
+        uint32_t mask = 1 << channel;
+
+        if (((completed | error) & mask) && g_LPC17_Dma_Handlers[channel] != nullptr)
+            g_LPC17_Dma_Handlers[channel](channel, (error & mask) != 0);
+    }
+}
+
+LPC_GPDMACH_TypeDef* LPC17_Dma_GetChannel(int32_t channel) {
+    return (LPC_GPDMACH_TypeDef*)(LPC_GPDMACH0_BASE + (channel * 0x20));
+}
+
+bool LPC17_Dma_Acquire(int32_t channel, LPC17_Dma_Handler handler) {
+    uint32_t mask = 1 << channel;
+
+    if (channel < 0 || channel >= LPC17_DMA_CHANNELS || (g_LPC17_Dma_Acquired & mask))
+        return false;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (g_LPC17_Dma_Acquired == 0) {
+        LPC_SC->PCONP |= PCONP_PCGPDMA;
+
+        LPC_GPDMA->Config = GPDMA_CONFIG_E; // little endian
+    }
+
+    LPC17_Dma_GetChannel(channel)->CConfig = 0;
+
+    LPC_GPDMA->IntTCClear = mask;
+    LPC_GPDMA->IntErrClr = mask;
+
+    g_LPC17_Dma_Handlers[channel] = handler;
+
+    if (g_LPC17_Dma_Acquired == 0)
+        LPC17_Interrupt_Activate(DMA_IRQn, (uint32_t*)&LPC17_Dma_InterruptHandler, 0);
+
+    g_LPC17_Dma_Acquired |= mask;
+
+    return true;
+}
+
+void LPC17_Dma_Release(int32_t channel) {
+    uint32_t mask = 1 << channel;
+
+    if (channel < 0 || channel >= LPC17_DMA_CHANNELS || !(g_LPC17_Dma_Acquired & mask))
+        return;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    LPC17_Dma_GetChannel(channel)->CConfig = 0;
+
+    LPC_GPDMA->IntTCClear = mask;
+    LPC_GPDMA->IntErrClr = mask;
+
+    g_LPC17_Dma_Handlers[channel] = nullptr;
+    g_LPC17_Dma_Acquired &= ~mask;
+
+    if (g_LPC17_Dma_Acquired == 0)
+        LPC17_Interrupt_Deactivate(DMA_IRQn);
+}
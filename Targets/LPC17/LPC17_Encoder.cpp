@@ -0,0 +1,225 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC17.h"
+
+#ifdef INCLUDE_ENCODER
+///////////////////////////////////////////////////////////////////////////////
+
+// one QEI, pins are PHA, PHB, IDX
+#define LPC17_ENCODER_PINS_COUNT 3
+#define LPC17_ENCODER_PCLK_HZ (LPC17_SYSTEM_CLOCK_HZ / 2)
+#define LPC17_ENCODER_VELOCITY_HZ 100 // velocity window, also extends the position to 64 bit
+
+#define QEI_CON_RESP (1 << 0)
+#define QEI_CON_RESV (1 << 2)
+#define QEI_CON_RESI (1 << 3)
+
+#define QEI_CONF_CAPMODE (1 << 2)
+
+#define QEI_STAT_DIR (1 << 0)
+
+#define QEI_INT_INX (1 << 0)
+#define QEI_INT_TIM (1 << 1)
+
+struct LPC17_Encoder_Controller {
+    bool acquired;
+    bool useIndex;
+
+    uint32_t lastCount;
+    int64_t position;
+
+    LPC17_Encoder_IndexHandler handler;
+};
+
+static const LPC17_Gpio_Pin g_LPC17_Encoder_Pins[] = LPC17_ENCODER_PINS;
+
+static LPC17_Encoder_Controller g_LPC17_Encoder_Controller;
+
+static int64_t LPC17_Encoder_Update(LPC17_Encoder_Controller& state) {
+    uint32_t count = LPC_QEI->POS;
+
+    // POS wraps at MAXPOS, the interrupt samples often enough for the signed delta to be exact
+    state.position += (int32_t)(count - state.lastCount);
+    state.lastCount = count;
+
+    return state.position;
+}
+
+void LPC17_Encoder_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& state = g_LPC17_Encoder_Controller;
+    uint32_t status = LPC_QEI->INTSTAT & LPC_QEI->IE;
+
+    LPC_QEI->CLR = status;
+
+    auto position = LPC17_Encoder_Update(state);
+
+    if ((status & QEI_INT_INX) && state.handler != nullptr)
+        state.handler(0, position);
+}
+
+static void LPC17_Encoder_ClosePins(int32_t count) {
+    for (auto i = 0; i < count; i++) {
+        LPC17_Gpio_ConfigurePin(g_LPC17_Encoder_Pins[i].number, LPC17_Gpio_Direction::Input, LPC17_Gpio_PinFunction::PinFunction0, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+        LPC17_Gpio_ClosePin(g_LPC17_Encoder_Pins[i].number);
+    }
+}
+
+TinyCLR_Result LPC17_Encoder_Acquire(int32_t controller, LPC17_Encoder_Mode mode, bool useIndex) {
+    if (controller != 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Encoder_Controller;
+
+    if (state.acquired)
+        return TinyCLR_Result::SharingViolation;
+
+    int32_t count = useIndex ? LPC17_ENCODER_PINS_COUNT : LPC17_ENCODER_PINS_COUNT - 1;
+
+    for (auto i = 0; i < count; i++) {
+        if (!LPC17_Gpio_OpenPin(g_LPC17_Encoder_Pins[i].number)) {
+            LPC17_Encoder_ClosePins(i);
+
+            return TinyCLR_Result::SharingViolation;
+        }
+
+        LPC17_Gpio_ConfigurePin(g_LPC17_Encoder_Pins[i].number, LPC17_Gpio_Direction::Input, g_LPC17_Encoder_Pins[i].pinFunction, LPC17_Gpio_ResistorMode::PullUp, LPC17_Gpio_Hysteresis::Enable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+    }
+
+    state.acquired = true;
+    state.useIndex = useIndex;
+    state.lastCount = 0;
+    state.position = 0;
+    state.handler = nullptr;
+
+    LPC_SC->PCONP |= PCONP_PCQEI;
+
+    LPC_QEI->IEC = 0xFFFFFFFF;
+    LPC_QEI->CLR = 0xFFFFFFFF;
+    LPC_QEI->CONF = mode == LPC17_Encoder_Mode::X4 ? QEI_CONF_CAPMODE : 0;
+    LPC_QEI->MAXPOS = 0xFFFFFFFF;
+    LPC_QEI->LOAD = LPC17_ENCODER_PCLK_HZ / LPC17_ENCODER_VELOCITY_HZ - 1;
+    LPC_QEI->FILTERPHA = 0;
+    LPC_QEI->FILTERPHB = 0;
+    LPC_QEI->FILTERINX = 0;
+    LPC_QEI->CON = QEI_CON_RESP | QEI_CON_RESV | QEI_CON_RESI;
+    LPC_QEI->IES = QEI_INT_TIM | (useIndex ? QEI_INT_INX : 0);
+
+    LPC17_Interrupt_Activate(QEI_IRQn, (uint32_t*)&LPC17_Encoder_InterruptHandler, 0);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Encoder_Release(int32_t controller) {
+    if (controller != 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Encoder_Controller;
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    LPC_QEI->IEC = 0xFFFFFFFF;
+    LPC_QEI->CLR = 0xFFFFFFFF;
+
+    LPC17_Interrupt_Deactivate(QEI_IRQn);
+
+    LPC_SC->PCONP &= ~PCONP_PCQEI;
+
+    LPC17_Encoder_ClosePins(state.useIndex ? LPC17_ENCODER_PINS_COUNT : LPC17_ENCODER_PINS_COUNT - 1);
+
+    state.acquired = false;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Encoder_GetPosition(int32_t controller, int64_t& position) {
+    if (controller != 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Encoder_Controller;
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    position = LPC17_Encoder_Update(state);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Encoder_SetPosition(int32_t controller, int64_t position) {
+    if (controller != 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Encoder_Controller;
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    LPC17_Encoder_Update(state);
+
+    state.position = position;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Encoder_GetDirection(int32_t controller, bool& forward) {
+    if (controller != 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!g_LPC17_Encoder_Controller.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    forward = !(LPC_QEI->STAT & QEI_STAT_DIR);
+
+    return TinyCLR_Result::Success;
+}
+
+// counts per second over the last hardware velocity window
+TinyCLR_Result LPC17_Encoder_GetVelocity(int32_t controller, int32_t& countsPerSecond) {
+    if (controller != 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!g_LPC17_Encoder_Controller.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    int32_t velocity = LPC_QEI->CAP * LPC17_ENCODER_VELOCITY_HZ;
+
+    countsPerSecond = (LPC_QEI->STAT & QEI_STAT_DIR) ? -velocity : velocity;
+
+    return TinyCLR_Result::Success;
+}
+
+// handler runs in interrupt context with the position at the index pulse
+TinyCLR_Result LPC17_Encoder_SetIndexHandler(int32_t controller, LPC17_Encoder_IndexHandler handler) {
+    if (controller != 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_Encoder_Controller;
+
+    if (!state.acquired || !state.useIndex)
+        return TinyCLR_Result::InvalidOperation;
+
+    state.handler = handler;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
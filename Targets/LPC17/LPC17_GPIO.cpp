@@ -24,6 +24,7 @@
 #define FIOSET(x)                   ((uint32_t*)(0x20098018 + (0x20 * GET_PORT(x))))
 #define FIOCLR(x)                   ((uint32_t*)(0x2009801C + (0x20 * GET_PORT(x))))
 #define FIOPIN(x)                   ((uint32_t*)(0x20098014 + (0x20 * GET_PORT(x))))
+#define FIOMASK(x)                  ((uint32_t*)(0x20098010 + (0x20 * GET_PORT(x))))
 
 #define GPIO_INT_RisingEdge(port)               ((uint32_t*)(0X40028090 + (0x10 * port)))
 #define GPIO_INT_FallingEdge(port)              ((uint32_t*)(0X40028094 + (0x10 * port)))
@@ -48,6 +49,14 @@ static const LPC17_Gpio_PinConfiguration pins[] = LPC17_GPIO_PINS;
 #define LPC17_Gpio_DebounceDefaultMilisecond   20
 #define LPC17_Gpio_MaxPins                     SIZEOF_ARRAY(pins)
 
+// debounced pins have their edges disabled on the first edge and are sampled again by timer 3 after the debounce time
+#define LPC17_Gpio_DebounceTimer               LPC_TIM3
+#define LPC17_Gpio_DebounceTimerIrq            TIMER3_IRQn
+#define LPC17_Gpio_DebounceTimerPower          PCONP_PCTIM3
+#define LPC17_Gpio_DebounceTimerHz             (LPC17_SYSTEM_CLOCK_HZ / 2)
+#define LPC17_Gpio_DebounceTimer_MCR_MR0I      (1 << 0)
+#define LPC17_Gpio_DebounceTimer_IR_MR0        (1 << 0)
+
 struct LPC17_Int_State {
     uint8_t                                     pin;      // pin number
     uint32_t                                    debounce; // debounce
@@ -56,12 +65,30 @@ struct LPC17_Int_State {
     const TinyCLR_Gpio_Provider*                controller; // controller
     TinyCLR_Gpio_ValueChangedHandler            ISR; // interrupt handler
     TinyCLR_Gpio_PinValue                       currentValue;
+    TinyCLR_Gpio_PinValue                       lastValue; // last value reported
+    uint32_t                                    debounceDeadline; // debounce timer count
 };
 
 static bool                     g_pinReserved[LPC17_Gpio_MaxPins];
 static uint64_t                     g_debounceTicksPin[LPC17_Gpio_MaxPins];
 static LPC17_Int_State             g_int_state[LPC17_Gpio_MaxPins]; // interrupt state
 static TinyCLR_Gpio_PinDriveMode    g_pinDriveMode[LPC17_Gpio_MaxPins];
+static uint32_t                     g_debounceTimerTicksPin[LPC17_Gpio_MaxPins];
+static uint32_t                     g_debouncing[2]; // 1 bit per masked pin of port 0 and port 2
+static bool                         g_debounceTimerOwned;
+
+// power of two, edges of queued pins are stored here by the interrupt and drained by ReadEvents or DispatchEvents
+#define LPC17_Gpio_EventQueueSize                64
+
+struct LPC17_Gpio_EventQueue {
+    volatile LPC17_Gpio_Event                    events[LPC17_Gpio_EventQueueSize];
+    volatile uint32_t                           head; // written by the interrupt only
+    volatile uint32_t                           tail; // written by the reader only
+    volatile uint32_t                           lost;
+};
+
+static bool                         g_eventQueued[LPC17_Gpio_MaxPins];
+static LPC17_Gpio_EventQueue          g_eventQueue;
 
 static TinyCLR_Gpio_Provider gpioProvider;
 static TinyCLR_Api_Info gpioApi;
@@ -105,6 +132,186 @@ TinyCLR_Result LPC17_Gpio_Release(const TinyCLR_Gpio_Provider* self) {
     return TinyCLR_Result::Success;
 }
 
+// single producer: all pin interrupts run at the same priority and never preempt each other
+static void LPC17_Gpio_PushEvent(int32_t pin, TinyCLR_Gpio_PinValue value) {
+    auto head = g_eventQueue.head;
+
+    if (head - g_eventQueue.tail >= LPC17_Gpio_EventQueueSize) {
+        g_eventQueue.lost++;
+
+        return;
+    }
+
+    auto& event = g_eventQueue.events[head % LPC17_Gpio_EventQueueSize];
+
+    event.pin = pin;
+    event.value = value;
+    event.ticks = LPC17_Time_GetCurrentTicks(nullptr);
+
+    g_eventQueue.head = head + 1; // publish after the event is complete
+}
+
+static void LPC17_Gpio_Report(LPC17_Int_State* state) {
+    state->lastValue = state->currentValue;
+
+    if (g_eventQueued[state->pin])
+        LPC17_Gpio_PushEvent(state->pin, state->currentValue);
+    else
+        state->ISR(state->controller, state->pin, state->currentValue);
+}
+
+static void LPC17_Gpio_DebounceTimerRelease();
+
+// compare on the nearest deadline, the timer is stopped once no pin is pending. Called with interrupts disabled
+static void LPC17_Gpio_DebounceSchedule() {
+    if (!g_debounceTimerOwned)
+        return;
+
+    auto timer = LPC17_Gpio_DebounceTimer;
+    uint32_t now = timer->TC;
+    int32_t next = 0x7FFFFFFF;
+    bool any = false;
+
+    for (auto port = 0; port <= 2; port += 2) {
+        for (auto pending = g_debouncing[port / 2]; pending; ) {
+            auto pin = 31 - __CLZ(pending);
+
+            pending &= ~(1 << pin);
+
+            int32_t remaining = (int32_t)(g_int_state[pin + port * 32].debounceDeadline - now);
+
+            if (remaining < next)
+                next = remaining;
+
+            any = true;
+        }
+    }
+
+    if (!any) {
+        LPC17_Gpio_DebounceTimerRelease();
+
+        return;
+    }
+
+    if (next < 1)
+        next = 1;
+
+    uint32_t compare = now + next;
+
+    timer->MR0 = compare;
+    timer->IR = LPC17_Gpio_DebounceTimer_IR_MR0;
+    timer->MCR = LPC17_Gpio_DebounceTimer_MCR_MR0I;
+
+    if ((int32_t)(timer->TC - compare) >= 0) // passed while programming
+        NVIC->ISPR[LPC17_Gpio_DebounceTimerIrq >> 5] = 1 << (LPC17_Gpio_DebounceTimerIrq & 0x1F); // set pending bit
+}
+
+static void LPC17_Gpio_DebounceStart(LPC17_Int_State* state) {
+    uint32_t port = GET_PORT(state->pin);
+
+    state->debounceDeadline = LPC17_Gpio_DebounceTimer->TC + g_debounceTimerTicksPin[state->pin];
+
+    g_debouncing[port / 2] |= GET_PIN_MASK(state->pin);
+
+    LPC17_Gpio_DebounceSchedule();
+}
+
+void LPC17_Gpio_DebounceInterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto timer = LPC17_Gpio_DebounceTimer;
+
+    timer->IR = LPC17_Gpio_DebounceTimer_IR_MR0;
+
+    uint32_t now = timer->TC;
+
+    for (auto port = 0; port <= 2; port += 2) {
+        for (auto pending = g_debouncing[port / 2]; pending; ) {
+            auto pin = 31 - __CLZ(pending);
+            uint32_t pinMask = 1 << pin;
+
+            pending &= ~pinMask;
+
+            LPC17_Int_State* state = &g_int_state[pin + port * 32];
+
+            if ((int32_t)(now - state->debounceDeadline) < 0)
+                continue;
+
+            if (state->ISR) {
+                *GPIO_INT_RisingEdge(port) |= pinMask;
+                *GPIO_INT_FallingEdge(port) |= pinMask;
+
+                LPC17_Gpio_Read(&gpioProvider, state->pin, state->currentValue); // after enabling, so no edge falls in between
+
+                if (state->currentValue != state->lastValue) { // settled on the other level, that is an edge of its own
+                    *GPIO_INT_RisingEdge(port) &= ~pinMask;
+                    *GPIO_INT_FallingEdge(port) &= ~pinMask;
+                    *GPIO_INT_Clear(port) = pinMask;
+
+                    state->debounceDeadline = now + g_debounceTimerTicksPin[state->pin];
+
+                    LPC17_Gpio_Report(state);
+
+                    continue;
+                }
+            }
+
+            g_debouncing[port / 2] &= ~pinMask;
+        }
+    }
+
+    LPC17_Gpio_DebounceSchedule();
+}
+
+// taken on the first edge of a debounce and released when the last pin settles, so capture, counter, one pulse
+// and PWM sequences see timer 3 idle in between. A busy timer leaves debounce to the tick compare in the edge interrupt
+static bool LPC17_Gpio_DebounceTimerAcquire() {
+    if (g_debounceTimerOwned)
+        return true;
+
+    auto timer = LPC17_Gpio_DebounceTimer;
+
+    if ((LPC_SC->PCONP & LPC17_Gpio_DebounceTimerPower) && (timer->TCR & (1 << 0))) // timer used by capture, counter or another client
+        return false;
+
+    LPC_SC->PCONP |= LPC17_Gpio_DebounceTimerPower;
+
+    timer->TCR = (1 << 1); // hold in reset
+    timer->CTCR = 0;
+    timer->PR = 0;
+    timer->CCR = 0;
+    timer->EMR = 0;
+    timer->MCR = 0;
+    timer->IR = 0xFFFFFFFF;
+
+    LPC17_Interrupt_Activate(LPC17_Gpio_DebounceTimerIrq, (uint32_t*)&LPC17_Gpio_DebounceInterruptHandler, 0);
+
+    timer->TCR = (1 << 0);
+
+    g_debounceTimerOwned = true;
+
+    return true;
+}
+
+static void LPC17_Gpio_DebounceTimerRelease() {
+    g_debouncing[0] = 0;
+    g_debouncing[1] = 0;
+
+    if (!g_debounceTimerOwned)
+        return;
+
+    LPC17_Gpio_DebounceTimer->TCR = 0;
+    LPC17_Gpio_DebounceTimer->MCR = 0;
+
+    LPC17_Interrupt_Deactivate(LPC17_Gpio_DebounceTimerIrq);
+
+    LPC_SC->PCONP &= ~LPC17_Gpio_DebounceTimerPower;
+
+    g_debounceTimerOwned = false;
+}
+
 void LPC17_Gpio_InterruptHandler(void* param) {
     INTERRUPT_STARTED_SCOPED(isr);
 
@@ -112,23 +319,38 @@ void LPC17_Gpio_InterruptHandler(void* param) {
 
     uint32_t* GPIO_INT_Overall_IO_Status_Register = GPIO_INT_Overall_IO_Status;
 
-    bool executeIsr = true;
-
     for (auto port = 0; port <= 2; port += 2) { // Only port 0 and port 2 support interrupts
         auto status_mask_register = 1 << port;
 
-        uint32_t* GPIO_Port_Interrupt_ClearRegister = GPIO_INT_Clear(port);
-        uint32_t* GPIO_Port_INT_RisingEdge_Status_Register = GPIO_INT_RisingEdge_Status(port);
-        uint32_t* GPIO_Port_INT_FallingEdge_Status_Register = GPIO_INT_FallingEdge_Status(port);
+        if (!(*GPIO_INT_Overall_IO_Status_Register & status_mask_register))
+            continue;
 
-        for (auto pin = 0; ((*GPIO_INT_Overall_IO_Status_Register) & status_mask_register) && (pin < 32); pin++) {
+        uint32_t pending = *GPIO_INT_RisingEdge_Status(port) | *GPIO_INT_FallingEdge_Status(port);
 
-            if (!(*GPIO_Port_INT_RisingEdge_Status_Register & (0x1 << pin)) && !(*GPIO_Port_INT_FallingEdge_Status_Register & (0x1 << pin))) // If this is not the Pin, skip to next pin
-                continue;
+        *GPIO_INT_Clear(port) = pending; // Clear the IRQ of every pin taken below
+
+        while (pending) {
+            auto pin = 31 - __CLZ(pending); // highest pending pin, one iteration per pending pin
+
+            pending &= ~(0x1 << pin);
+
+            bool executeIsr = true;
 
             LPC17_Int_State* state = &g_int_state[pin + port * 32];
 
-            *GPIO_Port_Interrupt_ClearRegister |= (0x1 << pin); // Clear this pin's IRQ
+            if (state->debounce && LPC17_Gpio_DebounceTimerAcquire()) {
+                *GPIO_INT_RisingEdge(port) &= ~(0x1 << pin); // no more edges until the pin is sampled again
+                *GPIO_INT_FallingEdge(port) &= ~(0x1 << pin);
+
+                LPC17_Gpio_Read(&gpioProvider, state->pin, state->currentValue);
+
+                LPC17_Gpio_DebounceStart(state);
+
+                if (state->currentValue != state->lastValue)
+                    LPC17_Gpio_Report(state);
+
+                continue;
+            }
 
             if (state->debounce) {
                 if ((LPC17_Time_GetCurrentTicks(nullptr) - state->lastDebounceTicks) >= g_debounceTicksPin[state->pin]) {
@@ -141,13 +363,74 @@ void LPC17_Gpio_InterruptHandler(void* param) {
 
             if (executeIsr) {
                 LPC17_Gpio_Read(&gpioProvider, state->pin, state->currentValue); // read value as soon as possible
-                
-                state->ISR(state->controller, state->pin, state->currentValue);
+
+                LPC17_Gpio_Report(state);
             }
         }
     }    
 }
 
+// queued pins keep their value changed handler installed but it is no longer called from the interrupt,
+// the edges are timestamped and kept until the owner drains them from thread context
+TinyCLR_Result LPC17_Gpio_SetEventQueueEnabled(const TinyCLR_Gpio_Provider* self, int32_t pin, bool enabled) {
+    if (pin < 0 || pin >= LPC17_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    g_eventQueued[pin] = enabled;
+
+    return TinyCLR_Result::Success;
+}
+
+// single consumer: count is the capacity of events on entry and the number of events read on return
+TinyCLR_Result LPC17_Gpio_ReadEvents(const TinyCLR_Gpio_Provider* self, LPC17_Gpio_Event* events, size_t& count) {
+    auto tail = g_eventQueue.tail;
+    auto available = g_eventQueue.head - tail;
+    size_t read = 0;
+
+    while (read < count && read < available) {
+        auto& event = g_eventQueue.events[tail % LPC17_Gpio_EventQueueSize];
+
+        events[read].pin = event.pin;
+        events[read].value = event.value;
+        events[read].ticks = event.ticks;
+
+        tail++;
+        read++;
+    }
+
+    g_eventQueue.tail = tail; // free the slots after they are copied
+
+    count = read;
+
+    return TinyCLR_Result::Success;
+}
+
+// calls the value changed handler of each queued edge in order, in the context of the caller
+TinyCLR_Result LPC17_Gpio_DispatchEvents(const TinyCLR_Gpio_Provider* self) {
+    LPC17_Gpio_Event events[8];
+    size_t count;
+
+    do {
+        count = SIZEOF_ARRAY(events);
+
+        LPC17_Gpio_ReadEvents(self, events, count);
+
+        for (size_t i = 0; i < count; i++) {
+            auto state = &g_int_state[events[i].pin];
+
+            if (state->ISR)
+                state->ISR(state->controller, events[i].pin, events[i].value);
+        }
+    } while (count == SIZEOF_ARRAY(events));
+
+    return TinyCLR_Result::Success;
+}
+
+// edges dropped because the queue was full
+uint32_t LPC17_Gpio_GetLostEventCount(const TinyCLR_Gpio_Provider* self) {
+    return g_eventQueue.lost;
+}
+
 TinyCLR_Result LPC17_Gpio_SetValueChangedHandler(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_ValueChangedHandler ISR) {
     LPC17_Int_State* state = &g_int_state[pin];
 
@@ -172,6 +455,12 @@ TinyCLR_Result LPC17_Gpio_SetValueChangedHandler(const TinyCLR_Gpio_Provider* se
         state->ISR = ISR;
         state->lastDebounceTicks = LPC17_Time_GetCurrentTicks(nullptr);
 
+        LPC17_Gpio_Read(self, pin, state->lastValue);
+
+        g_debouncing[port / 2] &= ~pinMask;
+
+        LPC17_Gpio_DebounceSchedule();
+
         *GPIO_Port_X_Interrupt_RisingEdgeRegister |= pinMask;
         *GPIO_Port_X_Interrupt_FallingEdgeRegister |= pinMask;
 
@@ -179,6 +468,12 @@ TinyCLR_Result LPC17_Gpio_SetValueChangedHandler(const TinyCLR_Gpio_Provider* se
         LPC17_Interrupt_Enable(GPIO_IRQn);
     }
     else {
+        if (port == 0 || port == 2) {
+            g_debouncing[port / 2] &= ~pinMask;
+
+            LPC17_Gpio_DebounceSchedule();
+        }
+
         LPC17_Interrupt_Disable(GPIO_IRQn);
     }
 
@@ -344,6 +639,145 @@ TinyCLR_Result LPC17_Gpio_Write(const TinyCLR_Gpio_Provider* self, int32_t pin,
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result LPC17_Gpio_ReadPort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t& value) {
+    if (port < 0 || port >= (LPC17_Gpio_MaxPins + 31) / 32)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    value = *FIOPIN(port * 32);
+
+    return TinyCLR_Result::Success;
+}
+
+// pins in mask take their bit from value in a single FIOPIN write, FIOMASK keeps the others untouched
+TinyCLR_Result LPC17_Gpio_WritePort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t mask, uint32_t value) {
+    if (port < 0 || port >= (LPC17_Gpio_MaxPins + 31) / 32)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    *FIOMASK(port * 32) = ~mask;
+    *FIOPIN(port * 32) = value;
+    *FIOMASK(port * 32) = 0; // single pin access relies on an open mask
+
+    return TinyCLR_Result::Success;
+}
+
+// waveforms are timed with the DWT cycle counter and run with interrupts disabled
+#define LPC17_Gpio_WaveformClockHz (LPC17_SYSTEM_CLOCK_HZ)
+
+static uint32_t LPC17_Gpio_WaveformNanosecondsToCycles(uint32_t nanoseconds) {
+    return ((uint64_t)nanoseconds * LPC17_Gpio_WaveformClockHz) / 1000000000;
+}
+
+static void LPC17_Gpio_WaveformStart() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+// each step holds its level for its duration, the edges are placed against the start so the delays do not add up
+TinyCLR_Result LPC17_Gpio_WriteWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, const LPC17_Gpio_WaveformStep* steps, size_t count) {
+    if (pin < 0 || pin >= LPC17_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (steps == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    volatile uint32_t* fioSet = FIOSET(pin);
+    volatile uint32_t* fioClr = FIOCLR(pin);
+    uint32_t mask = GET_PIN_MASK(pin);
+
+    LPC17_Gpio_WaveformStart();
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    uint32_t deadline = DWT->CYCCNT;
+
+    for (size_t i = 0; i < count; i++) {
+        if (steps[i].value == TinyCLR_Gpio_PinValue::High)
+            *fioSet = mask;
+        else
+            *fioClr = mask;
+
+        deadline += LPC17_Gpio_WaveformNanosecondsToCycles(steps[i].duration);
+
+        while ((int32_t)(DWT->CYCCNT - deadline) < 0);
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+// durations receives the time between edges, starting from the call, until count edges are seen or
+// the pin stays unchanged for timeout nanoseconds. count returns the number of edges.
+TinyCLR_Result LPC17_Gpio_CaptureWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& initialValue, uint32_t* durations, size_t& count, uint32_t timeout) {
+    if (pin < 0 || pin >= LPC17_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (durations == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    volatile uint32_t* fioPin = FIOPIN(pin);
+    uint32_t mask = GET_PIN_MASK(pin);
+
+    uint32_t timeoutCycles = LPC17_Gpio_WaveformNanosecondsToCycles(timeout);
+    size_t captured = 0;
+
+    LPC17_Gpio_WaveformStart();
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        uint32_t level = (*fioPin & mask);
+        uint32_t last = DWT->CYCCNT;
+
+        initialValue = level ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+
+        while (captured < count) {
+            uint32_t now = DWT->CYCCNT;
+
+            if (((*fioPin & mask)) == level) {
+                if (now - last >= timeoutCycles)
+                    break;
+
+                continue;
+            }
+
+            level ^= mask;
+
+            durations[captured++] = now - last; // cycles for now, converted once the capture is over
+            last = now;
+        }
+    }
+
+    for (size_t i = 0; i < captured; i++)
+        durations[i] = ((uint64_t)durations[i] * 1000000000) / LPC17_Gpio_WaveformClockHz;
+
+    count = captured;
+
+    return TinyCLR_Result::Success;
+}
+
+// the GPIO block is in the SRAM bit-band region
+#define LPC17_Gpio_BitBand(address, bit) ((volatile uint32_t*)(0x22000000 + (((uint32_t)(address) - 0x20000000) * 32) + ((bit) * 4)))
+
+// the handle stays valid until the pin is released. FIOSET reads back the output latch and FIOCLR reads
+// as zero, so a store to either alias only changes its own pin.
+TinyCLR_Result LPC17_Gpio_GetFastPin(const TinyCLR_Gpio_Provider* self, int32_t pin, LPC17_Gpio_FastPin& fastPin) {
+    if (pin >= LPC17_Gpio_MaxPins || pin < 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!g_pinReserved[pin])
+        return TinyCLR_Result::InvalidOperation;
+
+    uint32_t bit = pin % 32;
+
+    fastPin.input = LPC17_Gpio_BitBand(FIOPIN(pin), bit);
+    fastPin.output = LPC17_Gpio_BitBand(FIOSET(pin), bit);
+    fastPin.set = LPC17_Gpio_BitBand(FIOSET(pin), bit);
+    fastPin.clear = LPC17_Gpio_BitBand(FIOCLR(pin), bit);
+
+    return TinyCLR_Result::Success;
+}
+
 TinyCLR_Result LPC17_Gpio_AcquirePin(const TinyCLR_Gpio_Provider* self, int32_t pin) {
     if (pin >= LPC17_Gpio_MaxPins || pin < 0)
         return TinyCLR_Result::ArgumentOutOfRange;
@@ -427,6 +861,7 @@ TinyCLR_Result LPC17_Gpio_SetDebounceTimeout(const TinyCLR_Gpio_Provider* self,
 
     if (debounceTime > 0 && debounceTime < 10000) {
         g_debounceTicksPin[pin] = LPC17_Time_MillisecondsToTicks(nullptr, (uint64_t)debounceTime);
+        g_debounceTimerTicksPin[pin] = (LPC17_Gpio_DebounceTimerHz / 1000) * debounceTime;
         return TinyCLR_Result::Success;
     }
 
@@ -446,6 +881,7 @@ void LPC17_Gpio_Reset() {
 
     for (auto pin = 0; pin < LPC17_Gpio_GetPinCount(&gpioProvider); pin++) {
         g_pinReserved[pin] = 0;
+        g_eventQueued[pin] = false;
         LPC17_Gpio_SetDebounceTimeout(&gpioProvider, pin, LPC17_Gpio_DebounceDefaultMilisecond);
     }
 
@@ -453,4 +889,8 @@ void LPC17_Gpio_Reset() {
     *GPIO_Port_0_INT_FallingEdge_Register = 0x0;
     *GPIO_Port_2_INT_RisingEdge_Register = 0x0;
     *GPIO_Port_2_INT_FallingEdge_Register = 0x0;
+
+    LPC17_Gpio_DebounceTimerRelease();
+
+    g_eventQueue.tail = g_eventQueue.head;
 }
@@ -0,0 +1,293 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC17.h"
+
+#ifdef INCLUDE_ONEPULSE
+///////////////////////////////////////////////////////////////////////////////
+
+// controller x is timer x: CAPx.0 triggers and the pulse is output on MATx.0.
+// The trigger edge is captured in hardware and both pulse edges are match events relative to it,
+// so the interrupt only reloads MR0 and the pulse jitter is that of the timer, not of the interrupt.
+#define LPC17_ONEPULSE_TRIGGER_PIN 0
+#define LPC17_ONEPULSE_OUTPUT_PIN 1
+#define LPC17_ONEPULSE_PCLK_HZ (LPC17_SYSTEM_CLOCK_HZ / 2)
+#define LPC17_ONEPULSE_MIN_TICKS (LPC17_ONEPULSE_PCLK_HZ / 200000) // 5us, MR0 must be reloaded before it is reached
+
+#define LPC17_ONEPULSE_MCR_MR0I (1 << 0)
+#define LPC17_ONEPULSE_IR_MR0 (1 << 0)
+#define LPC17_ONEPULSE_IR_CR0 (1 << 4)
+#define LPC17_ONEPULSE_CCR_RE (1 << 0)
+#define LPC17_ONEPULSE_CCR_FE (1 << 1)
+#define LPC17_ONEPULSE_CCR_I (1 << 2)
+#define LPC17_ONEPULSE_EMR_EM0 (1 << 0)
+#define LPC17_ONEPULSE_EMR_EMC0_CLEAR (1 << 4)
+#define LPC17_ONEPULSE_EMR_EMC0_SET (2 << 4)
+
+enum class LPC17_OnePulse_Phase : uint8_t {
+    Idle = 0,
+    Delay = 1,
+    Width = 2,
+};
+
+struct LPC17_OnePulse_Controller {
+    bool acquired;
+    bool configured;
+    bool invert;
+    LPC17_OnePulse_Trigger trigger;
+    LPC17_OnePulse_Phase phase;
+
+    uint32_t delay;
+    uint32_t width;
+};
+
+static const LPC17_Gpio_Pin g_LPC17_OnePulse_Pins[][2] = LPC17_ONEPULSE_PINS;
+
+static const int TOTAL_ONEPULSE_CONTROLLERS = SIZEOF_ARRAY(g_LPC17_OnePulse_Pins);
+
+static LPC17_OnePulse_Controller g_LPC17_OnePulse_Controller[TOTAL_ONEPULSE_CONTROLLERS];
+
+static LPC_TIM_TypeDef* LPC17_OnePulse_GetTimer(int32_t controller) {
+    switch (controller) {
+    case 0: return LPC_TIM0;
+    case 1: return LPC_TIM1;
+    case 2: return LPC_TIM2;
+    case 3: return LPC_TIM3;
+    }
+
+    return nullptr;
+}
+
+static uint32_t LPC17_OnePulse_GetPower(int32_t controller) {
+    static const uint32_t power[] = { PCONP_PCTIM0, PCONP_PCTIM1, PCONP_PCTIM2, PCONP_PCTIM3 };
+
+    return power[controller];
+}
+
+// MAT0 goes to the pulse level at start + delay
+static void LPC17_OnePulse_Start(LPC_TIM_TypeDef* timer, LPC17_OnePulse_Controller& state, uint32_t start) {
+    timer->MR0 = start + state.delay;
+    timer->EMR = (state.invert ? LPC17_ONEPULSE_EMR_EM0 | LPC17_ONEPULSE_EMR_EMC0_CLEAR : LPC17_ONEPULSE_EMR_EMC0_SET);
+    timer->IR = LPC17_ONEPULSE_IR_MR0;
+    timer->MCR = LPC17_ONEPULSE_MCR_MR0I;
+
+    state.phase = LPC17_OnePulse_Phase::Delay;
+}
+
+static void LPC17_OnePulse_InterruptHandler(int32_t controller) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto timer = LPC17_OnePulse_GetTimer(controller);
+    auto& state = g_LPC17_OnePulse_Controller[controller];
+    auto ir = timer->IR & (LPC17_ONEPULSE_IR_MR0 | LPC17_ONEPULSE_IR_CR0);
+
+    timer->IR = ir; // clear
+
+    if (ir & LPC17_ONEPULSE_IR_MR0) {
+        if (state.phase == LPC17_OnePulse_Phase::Delay) {
+            // pulse started, the next match ends it
+            timer->MR0 += state.width;
+            timer->EMR = (state.invert ? LPC17_ONEPULSE_EMR_EMC0_SET : LPC17_ONEPULSE_EMR_EM0 | LPC17_ONEPULSE_EMR_EMC0_CLEAR);
+
+            state.phase = LPC17_OnePulse_Phase::Width;
+        }
+        else if (state.phase == LPC17_OnePulse_Phase::Width) {
+            timer->MCR = 0;
+            timer->EMR = state.invert ? LPC17_ONEPULSE_EMR_EM0 : 0;
+
+            state.phase = LPC17_OnePulse_Phase::Idle;
+        }
+    }
+
+    if ((ir & LPC17_ONEPULSE_IR_CR0) && state.configured && state.phase == LPC17_OnePulse_Phase::Idle) // edges during a pulse are ignored
+        LPC17_OnePulse_Start(timer, state, timer->CR0);
+}
+
+void LPC17_OnePulse_InterruptHandler0(void* param) { LPC17_OnePulse_InterruptHandler(0); }
+void LPC17_OnePulse_InterruptHandler1(void* param) { LPC17_OnePulse_InterruptHandler(1); }
+void LPC17_OnePulse_InterruptHandler2(void* param) { LPC17_OnePulse_InterruptHandler(2); }
+void LPC17_OnePulse_InterruptHandler3(void* param) { LPC17_OnePulse_InterruptHandler(3); }
+
+static void (* const g_LPC17_OnePulse_Isr[])(void*) = {
+    &LPC17_OnePulse_InterruptHandler0, &LPC17_OnePulse_InterruptHandler1, &LPC17_OnePulse_InterruptHandler2, &LPC17_OnePulse_InterruptHandler3
+};
+
+static TinyCLR_Result LPC17_OnePulse_OpenPin(int32_t controller, int32_t index, LPC17_Gpio_Direction direction) {
+    auto& pin = g_LPC17_OnePulse_Pins[controller][index];
+
+    if (pin.number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+    if (!LPC17_Gpio_OpenPin(pin.number))
+        return TinyCLR_Result::SharingViolation;
+
+    LPC17_Gpio_ConfigurePin(pin.number, direction, pin.pinFunction, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Enable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::FastMode, LPC17_Gpio_OutputType::PushPull);
+
+    return TinyCLR_Result::Success;
+}
+
+static void LPC17_OnePulse_ClosePin(int32_t controller, int32_t index) {
+    auto& pin = g_LPC17_OnePulse_Pins[controller][index];
+
+    LPC17_Gpio_ConfigurePin(pin.number, LPC17_Gpio_Direction::Input, LPC17_Gpio_PinFunction::PinFunction0, LPC17_Gpio_ResistorMode::Inactive, LPC17_Gpio_Hysteresis::Disable, LPC17_Gpio_InputPolarity::NotInverted, LPC17_Gpio_SlewRate::StandardMode, LPC17_Gpio_OutputType::PushPull);
+    LPC17_Gpio_ClosePin(pin.number);
+}
+
+// invert makes the pulse low on an idle high output
+TinyCLR_Result LPC17_OnePulse_Acquire(int32_t controller, LPC17_OnePulse_Trigger trigger, bool invert) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto timer = LPC17_OnePulse_GetTimer(controller);
+    auto& state = g_LPC17_OnePulse_Controller[controller];
+
+    if (state.acquired || ((LPC_SC->PCONP & LPC17_OnePulse_GetPower(controller)) && (timer->TCR & (1 << 0)))) // timer used by capture, counter or PWM sequences
+        return TinyCLR_Result::SharingViolation;
+
+    auto result = LPC17_OnePulse_OpenPin(controller, LPC17_ONEPULSE_OUTPUT_PIN, LPC17_Gpio_Direction::Output);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    if (trigger != LPC17_OnePulse_Trigger::Software) {
+        result = LPC17_OnePulse_OpenPin(controller, LPC17_ONEPULSE_TRIGGER_PIN, LPC17_Gpio_Direction::Input);
+
+        if (result != TinyCLR_Result::Success) {
+            LPC17_OnePulse_ClosePin(controller, LPC17_ONEPULSE_OUTPUT_PIN);
+
+            return result;
+        }
+    }
+
+    state.acquired = true;
+    state.configured = false;
+    state.invert = invert;
+    state.trigger = trigger;
+    state.phase = LPC17_OnePulse_Phase::Idle;
+
+    LPC_SC->PCONP |= LPC17_OnePulse_GetPower(controller);
+
+    timer->TCR = (1 << 1); // hold in reset
+    timer->CTCR = 0; // timer mode
+    timer->PR = 0;
+    timer->MCR = 0;
+    timer->EMR = invert ? LPC17_ONEPULSE_EMR_EM0 : 0; // idle level
+    timer->CCR = 0;
+    timer->IR = 0xFFFFFFFF;
+
+    if (trigger != LPC17_OnePulse_Trigger::Software)
+        timer->CCR = (trigger == LPC17_OnePulse_Trigger::FallingEdge ? LPC17_ONEPULSE_CCR_FE : LPC17_ONEPULSE_CCR_RE) | LPC17_ONEPULSE_CCR_I;
+
+    LPC17_Interrupt_Activate(TIMER0_IRQn + controller, (uint32_t*)g_LPC17_OnePulse_Isr[controller], 0);
+
+    timer->TCR = (1 << 0); // free running, pulses are scheduled relative to TC
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_OnePulse_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto timer = LPC17_OnePulse_GetTimer(controller);
+    auto& state = g_LPC17_OnePulse_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    timer->TCR = 0;
+    timer->MCR = 0;
+    timer->CCR = 0;
+    timer->EMR = 0;
+    timer->IR = 0xFFFFFFFF;
+
+    LPC17_Interrupt_Deactivate(TIMER0_IRQn + controller);
+
+    LPC_SC->PCONP &= ~LPC17_OnePulse_GetPower(controller);
+
+    LPC17_OnePulse_ClosePin(controller, LPC17_ONEPULSE_OUTPUT_PIN);
+
+    if (state.trigger != LPC17_OnePulse_Trigger::Software)
+        LPC17_OnePulse_ClosePin(controller, LPC17_ONEPULSE_TRIGGER_PIN);
+
+    state.acquired = false;
+
+    return TinyCLR_Result::Success;
+}
+
+// delay is from the trigger to the pulse start, both must be at least 5us
+TinyCLR_Result LPC17_OnePulse_SetPulse(int32_t controller, uint32_t delayNanoseconds, uint32_t widthNanoseconds) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_OnePulse_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    uint64_t delay = ((uint64_t)delayNanoseconds * LPC17_ONEPULSE_PCLK_HZ) / 1000000000;
+    uint64_t width = ((uint64_t)widthNanoseconds * LPC17_ONEPULSE_PCLK_HZ) / 1000000000;
+
+    if (delay < LPC17_ONEPULSE_MIN_TICKS || width < LPC17_ONEPULSE_MIN_TICKS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (state.phase != LPC17_OnePulse_Phase::Idle)
+        return TinyCLR_Result::Busy;
+
+    state.delay = delay;
+    state.width = width;
+    state.configured = true;
+
+    return TinyCLR_Result::Success;
+}
+
+// starts the pulse now, edge triggered controllers start on each edge by themselves
+TinyCLR_Result LPC17_OnePulse_Fire(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_OnePulse_Controller[controller];
+
+    if (!state.acquired || !state.configured)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (state.phase != LPC17_OnePulse_Phase::Idle)
+        return TinyCLR_Result::Busy;
+
+    auto timer = LPC17_OnePulse_GetTimer(controller);
+
+    LPC17_OnePulse_Start(timer, state, timer->TC);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_OnePulse_IsBusy(int32_t controller, bool& busy) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC17_OnePulse_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    busy = state.phase != LPC17_OnePulse_Phase::Idle;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
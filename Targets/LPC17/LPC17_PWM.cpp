@@ -66,6 +66,39 @@
 
 static PwmController g_PwmController[TOTAL_PWM_CONTROLLER];
 
+// sequence mode: timer 3 runs in lock step with the PWM counter, its MR0 match requests a DMA transfer
+// that writes the next match value right before the PWM period restarts
+#define LPC17_PWM_SEQUENCE_TIMER LPC_TIM3
+#define LPC17_PWM_SEQUENCE_DMA_CHANNEL 1
+#define LPC17_PWM_SEQUENCE_DMA_REQUEST 14 // timer 3 match 0 through DMAREQSEL
+#define LPC17_PWM_SEQUENCE_DMA_MAX_TRANSFER 0xFFF // per linked list item
+#define LPC17_PWM_SEQUENCE_DMA_ITEMS 8
+
+#define GPDMA_CCONTROL(size) ((size) | (2 << 18) | (2 << 21) | (1 << 26)) // word to word, source increment
+#define GPDMA_CCONTROL_I (1U << 31) // terminal count interrupt
+#define GPDMA_CCONFIG_E 0x1
+#define GPDMA_CCONFIG_M2P (1 << 11)
+#define GPDMA_CCONFIG_IE (1 << 14)
+#define GPDMA_CCONFIG_ITC (1 << 15)
+
+struct LPC17_Pwm_DmaItem {
+    uint32_t source;
+    uint32_t destination;
+    uint32_t next;
+    uint32_t control;
+};
+
+struct LPC17_Pwm_Sequence {
+    LPC17_Pwm_DmaItem items[LPC17_PWM_SEQUENCE_DMA_ITEMS];
+    int32_t count;
+    int32_t controller;
+    bool circular;
+    bool active;
+    LPC17_Pwm_SequenceHandler handler;
+};
+
+static LPC17_Pwm_Sequence g_LPC17_Pwm_Sequence;
+
 static uint8_t pwmProviderDefs[TOTAL_PWM_CONTROLLER * sizeof(TinyCLR_Pwm_Provider)];
 static TinyCLR_Pwm_Provider* pwmProviders[TOTAL_PWM_CONTROLLER];
 static TinyCLR_Api_Info pwmApi;
@@ -115,7 +148,8 @@ TinyCLR_Result LPC17_Pwm_AcquirePin(const TinyCLR_Pwm_Provider* self, int32_t pi
         PWM0TCR |= (1 << 1);
         *g_PwmController[self->Index].matchAddress[pin] = 0;
         PWM0MCR = (1 << 1); // Reset on MAT0
-        PWM0TCR = 1; // Enable
+        PWM0TCR = (1 << 0) | (1 << 3); // Enable, PWM mode so match registers are shadowed until latched
+        PWM0LER |= (1 << (g_PwmController[self->Index].match[pin] + 1));
         PWM0PCR |= (1 << (9 + g_PwmController[self->Index].match[pin])); // To enable output on the proper channel
     }
     else if (g_PwmController[self->Index].channel[pin] == 1) {
@@ -127,7 +161,8 @@ TinyCLR_Result LPC17_Pwm_AcquirePin(const TinyCLR_Pwm_Provider* self, int32_t pi
         PWM1TCR |= (1 << 1);
         *g_PwmController[self->Index].matchAddress[pin] = 0;
         PWM1MCR = (1 << 1); // Reset on MAT0
-        PWM1TCR = 1; // Enable
+        PWM1TCR = (1 << 0) | (1 << 3); // Enable, PWM mode so match registers are shadowed until latched
+        PWM1LER |= (1 << (g_PwmController[self->Index].match[pin] + 1));
         PWM1PCR |= (1 << (9 + (g_PwmController[self->Index].match[pin]))); // To enable output on the proper channel
     }
 
@@ -249,108 +284,69 @@ double LPC17_Pwm_GetMinFrequency(const TinyCLR_Pwm_Provider* self) {
     return 1;
 }
 
-TinyCLR_Result LPC17_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity) {
-
+static uint32_t LPC17_Pwm_GetPeriodTicks(double frequency) {
     uint32_t period = 0;
-    uint32_t duration = 0;
     uint32_t scale = 0;
 
-    uint32_t periodInNanoSeconds = 0;
-    uint32_t durationInNanoSeconds = 0;
-
-    double frequency = g_PwmController[self->Index].frequency;
+    if (frequency <= 0.0)
+        return 0;
 
     LPC17_Pwm_GetScaleFactor(frequency, period, scale);
 
-    duration = (uint32_t)(dutyCycle * period);
-
-    // Work on actual period and duration after update.
-    // Repeat calculation again to genarate periodTicks and highTicks. LPC17 convert from period and duration to ticks.
-    switch (scale) {
-    case PWM_MILLISECONDS:
-        periodInNanoSeconds = (period * 1000000);
-        durationInNanoSeconds = (duration * 1000000);
-        break;
-
-    case PWM_MICROSECONDS:
-        periodInNanoSeconds = (period * 1000);
-        durationInNanoSeconds = (duration * 1000);
-        break;
-
-    case PWM_NANOSECONDS:
-        periodInNanoSeconds = period;
-        durationInNanoSeconds = duration;
-        break;
-
-    default:
-        return TinyCLR_Result::InvalidOperation;
-    }
+    uint32_t periodInNanoSeconds = period * (PWM_NANOSECONDS / scale);
 
     // 18M/M = 18 * period / 1000 to get legal value.
     uint32_t periodTicks = (uint64_t)(((LPC17_SYSTEM_CLOCK_HZ / 2) / 1000000)) * periodInNanoSeconds / 1000;
-    uint32_t highTicks = (uint64_t)(((LPC17_SYSTEM_CLOCK_HZ / 2) / 1000000)) * durationInNanoSeconds / 1000;
 
     // A strange instance where if the periodInNanoSeconds would have ended in infinite 3 (calculated with float in NETMF), periodTicks are not computed correctly
     if (0 == ((periodInNanoSeconds - 3) % 10))
         periodTicks += 1;
 
-    if (0 == ((highTicks - 3) % 10))
-        highTicks += 1;
-
-    periodTicks -= 1;
-    highTicks -= 1;
-
-    if ((int)periodTicks < 0)
-        periodTicks = 0;
+    return periodTicks;
+}
 
-    if ((int)highTicks < 0)
-        highTicks = 0;
+// Writes the shadowed match registers, returns the latch enable bits needed to apply them
+static uint32_t LPC17_Pwm_StageChannel(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity) {
+    uint32_t periodTicks = g_PwmController[self->Index].periodTicks;
+    uint32_t latch = 0;
 
-    if (highTicks > periodTicks)
-        highTicks = periodTicks;
+    if (dutyCycle > LPC17_PWM_DUTY_CYCLE_FULL)
+        dutyCycle = LPC17_PWM_DUTY_CYCLE_FULL;
 
-    if (invertPolarity)
-        highTicks = periodTicks - highTicks;
+    uint32_t highTicks = (uint32_t)(((uint64_t)dutyCycle * periodTicks) >> 16);
 
-    if (period == 0 || duration == 0) {
+    if (periodTicks == 0 || highTicks == 0) {
         LPC17_Gpio_EnableOutputPin(g_PwmController[self->Index].gpioPin[pin].number, false);
         g_PwmController[self->Index].outputEnabled[pin] = true;
-
-        return TinyCLR_Result::Success;
     }
-    else if (duration >= period) {
+    else if (highTicks >= periodTicks) {
         LPC17_Gpio_EnableOutputPin(g_PwmController[self->Index].gpioPin[pin].number, true);
         g_PwmController[self->Index].outputEnabled[pin] = true;
-
-        return TinyCLR_Result::Success;
     }
     else {
+        periodTicks -= 1;
+        highTicks -= 1;
+
+        if (invertPolarity)
+            highTicks = periodTicks - highTicks;
+
+        // Re-scale with new frequency! Takes effect at the end of the current period.
         if (g_PwmController[self->Index].channel[pin] == 0) {
-            // Re-scale with new frequency!
             if ((PWM0MR0 != periodTicks)) {
-
-                // Reset Timer Counter
-                PWM0TCR |= (1 << 1);
                 PWM0MR0 = periodTicks;
-                PWM0MCR = (1 << 1); // Reset on MAT0
-                PWM0TCR = 1; // Enable
+                latch |= (1 << 0);
             }
-
-            *g_PwmController[self->Index].matchAddress[pin] = highTicks;
         }
         else if (g_PwmController[self->Index].channel[pin] == 1) {
-            // Re-scale with new frequency!
             if ((PWM1MR0 != periodTicks)) {
-                // Reset Timer Counter
-                PWM1TCR |= (1 << 1);
                 PWM1MR0 = periodTicks;
-                PWM1MCR = (1 << 1); // Reset on MAT0
-                PWM1TCR = 1; // Enable
+                latch |= (1 << 0);
             }
-
-            *g_PwmController[self->Index].matchAddress[pin] = highTicks;
         }
 
+        *g_PwmController[self->Index].matchAddress[pin] = highTicks;
+        latch |= (1 << (g_PwmController[self->Index].match[pin] + 1));
+
         if (g_PwmController[self->Index].outputEnabled[pin] == true) {
             LPC17_Pwm_EnablePin(self, pin);
 
@@ -361,19 +357,226 @@ TinyCLR_Result LPC17_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, in
     g_PwmController[self->Index].invert[pin] = invertPolarity;
     g_PwmController[self->Index].dutyCycle[pin] = dutyCycle;
 
+    return latch;
+}
+
+static void LPC17_Pwm_Latch(const TinyCLR_Pwm_Provider* self, uint32_t latch) {
+    // Shadow registers move to the match registers together on the next MR0 match
+    if (self->Index == 0)
+        PWM0LER |= latch;
+    else
+        PWM1LER |= latch;
+}
+
+TinyCLR_Result LPC17_Pwm_SetPulseParametersFixed(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity) {
+    if (g_LPC17_Pwm_Sequence.active && g_LPC17_Pwm_Sequence.controller == self->Index)
+        return TinyCLR_Result::InvalidOperation;
+
+    LPC17_Pwm_Latch(self, LPC17_Pwm_StageChannel(self, pin, dutyCycle, invertPolarity));
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Provider* self, const int32_t* pins, const uint32_t* dutyCycles, const bool* invertPolarity, size_t count) {
+    uint32_t latch = 0;
+
+    if (pins == nullptr || dutyCycles == nullptr || invertPolarity == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (g_LPC17_Pwm_Sequence.active && g_LPC17_Pwm_Sequence.controller == self->Index)
+        return TinyCLR_Result::InvalidOperation;
+
+    for (size_t i = 0; i < count; i++)
+        if (pins[i] < 0 || pins[i] >= MAX_PWM_PER_CONTROLLER || g_PwmController[self->Index].gpioPin[pins[i]].number == PIN_NONE)
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+    for (size_t i = 0; i < count; i++)
+        latch |= LPC17_Pwm_StageChannel(self, pins[i], dutyCycles[i], invertPolarity[i]);
+
+    LPC17_Pwm_Latch(self, latch);
+
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result LPC17_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity) {
+    uint32_t fixed = 0;
+
+    if (dutyCycle >= 1.0)
+        fixed = LPC17_PWM_DUTY_CYCLE_FULL;
+    else if (dutyCycle > 0.0)
+        fixed = (uint32_t)(dutyCycle * LPC17_PWM_DUTY_CYCLE_FULL + 0.5);
+
+    return LPC17_Pwm_SetPulseParametersFixed(self, pin, fixed, invertPolarity);
+}
+
 TinyCLR_Result LPC17_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Provider* self, double& frequency) {
     g_PwmController[self->Index].frequency = frequency;
+    g_PwmController[self->Index].periodTicks = LPC17_Pwm_GetPeriodTicks(frequency);
 
     // Calculate actual frequency
     frequency = LPC17_Pwm_GetActualFrequency(self);
 
-    for (int p = 0; p < MAX_PWM_PER_CONTROLLER; p++)
-        if (g_PwmController[self->Index].gpioPin[p].number != PIN_NONE)
-            if (LPC17_Pwm_SetPulseParameters(self, p, g_PwmController[self->Index].dutyCycle[p], g_PwmController[self->Index].invert[p]) != TinyCLR_Result::Success)
-                return TinyCLR_Result::InvalidOperation;
+    // Re-apply all channels, new period and duty cycles are latched together
+    int32_t pins[MAX_PWM_PER_CONTROLLER];
+    uint32_t dutyCycles[MAX_PWM_PER_CONTROLLER];
+    bool invert[MAX_PWM_PER_CONTROLLER];
+    size_t count = 0;
+
+    for (int p = 0; p < MAX_PWM_PER_CONTROLLER; p++) {
+        if (g_PwmController[self->Index].gpioPin[p].number != PIN_NONE) {
+            pins[count] = p;
+            dutyCycles[count] = g_PwmController[self->Index].dutyCycle[p];
+            invert[count] = g_PwmController[self->Index].invert[p];
+            count++;
+        }
+    }
+
+    if (LPC17_Pwm_SetPulseParametersBatch(self, pins, dutyCycles, invert, count) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    return TinyCLR_Result::Success;
+}
+
+static void LPC17_Pwm_ReleaseSequence(int32_t controller) {
+    if (!g_LPC17_Pwm_Sequence.active || g_LPC17_Pwm_Sequence.controller != controller)
+        return;
+
+    LPC17_PWM_SEQUENCE_TIMER->TCR = 0;
+
+    LPC17_Dma_Release(LPC17_PWM_SEQUENCE_DMA_CHANNEL);
+
+    // back to latched updates
+    if (controller == 0)
+        PWM0TCR = (1 << 0) | (1 << 3);
+    else
+        PWM1TCR = (1 << 0) | (1 << 3);
+
+    g_LPC17_Pwm_Sequence.active = false;
+}
+
+static void LPC17_Pwm_SequenceDmaHandler(int32_t channel, bool error) {
+    auto controller = g_LPC17_Pwm_Sequence.controller;
+    auto handler = g_LPC17_Pwm_Sequence.handler;
+
+    if (error) {
+        LPC17_Pwm_ReleaseSequence(controller);
+
+        if (handler != nullptr)
+            handler(controller, LPC17_Pwm_SequenceEvent::Error);
+    }
+    else {
+        auto event = LPC17_Pwm_SequenceEvent::TransferComplete;
+
+        if (!g_LPC17_Pwm_Sequence.circular)
+            LPC17_Pwm_ReleaseSequence(controller); // the last value stays in the match register
+        else if (LPC17_Dma_GetChannel(channel)->CLLI == g_LPC17_Pwm_Sequence.items[g_LPC17_Pwm_Sequence.count / 2].next) // second half is playing
+            event = LPC17_Pwm_SequenceEvent::HalfTransfer;
+
+        if (handler != nullptr)
+            handler(controller, event);
+    }
+}
+
+uint32_t LPC17_Pwm_GetPeriodTicks(const TinyCLR_Pwm_Provider* self) {
+    return g_PwmController[self->Index].periodTicks;
+}
+
+// matchValues are raw PWM counter ticks (0..GetPeriodTicks), one per PWM period
+TinyCLR_Result LPC17_Pwm_StartSequence(const TinyCLR_Pwm_Provider* self, int32_t pin, const uint32_t* matchValues, size_t length, bool circular, LPC17_Pwm_SequenceHandler handler) {
+    auto& sequence = g_LPC17_Pwm_Sequence;
+
+    if (matchValues == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (pin < 0 || pin >= MAX_PWM_PER_CONTROLLER || g_PwmController[self->Index].gpioPin[pin].number == PIN_NONE)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    // split in linked list items, an even count in circular mode so half transfer can be reported
+    int32_t count = (length + LPC17_PWM_SEQUENCE_DMA_MAX_TRANSFER - 1) / LPC17_PWM_SEQUENCE_DMA_MAX_TRANSFER;
+
+    if (circular) {
+        if (count < 2) count = 2;
+        if (count & 1) count++;
+    }
+
+    if (length == 0 || count > LPC17_PWM_SEQUENCE_DMA_ITEMS || length < (size_t)count)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    uint32_t periodTicks = g_PwmController[self->Index].periodTicks;
+
+    if (periodTicks == 0 || sequence.active)
+        return TinyCLR_Result::InvalidOperation;
+
+    if ((LPC_SC->PCONP & PCONP_PCTIM3) && (LPC17_PWM_SEQUENCE_TIMER->TCR & (1 << 0))) // timer 3 running for capture
+        return TinyCLR_Result::SharingViolation;
+
+    if (!LPC17_Dma_Acquire(LPC17_PWM_SEQUENCE_DMA_CHANNEL, &LPC17_Pwm_SequenceDmaHandler))
+        return TinyCLR_Result::SharingViolation;
+
+    size_t offset = 0;
+
+    for (auto i = 0; i < count; i++) {
+        size_t size = length / count + ((size_t)i < length % count ? 1 : 0);
+
+        sequence.items[i].source = (uint32_t)(matchValues + offset);
+        sequence.items[i].destination = (uint32_t)g_PwmController[self->Index].matchAddress[pin];
+        sequence.items[i].next = i + 1 < count ? (uint32_t)&sequence.items[i + 1] : (circular ? (uint32_t)&sequence.items[0] : 0);
+        sequence.items[i].control = GPDMA_CCONTROL(size) | (i + 1 == count || (circular && i + 1 == count / 2) ? GPDMA_CCONTROL_I : 0);
+
+        offset += size;
+    }
+
+    sequence.count = count;
+    sequence.controller = self->Index;
+    sequence.circular = circular;
+    sequence.handler = handler;
+    sequence.active = true;
+
+    g_PwmController[self->Index].dutyCycle[pin] = 0;
+
+    if (g_PwmController[self->Index].outputEnabled[pin] == true) {
+        LPC17_Pwm_EnablePin(self, pin);
+
+        g_PwmController[self->Index].outputEnabled[pin] = false;
+    }
+
+    LPC_SC->PCONP |= PCONP_PCTIM3;
+    LPC_SC->DMAREQSEL |= (1 << LPC17_PWM_SEQUENCE_DMA_REQUEST);
+
+    // hold both counters in reset, the PWM leaves PWM mode so every DMA write applies to the next period without a latch
+    LPC17_PWM_SEQUENCE_TIMER->TCR = (1 << 1);
+    LPC17_PWM_SEQUENCE_TIMER->PR = 0;
+    LPC17_PWM_SEQUENCE_TIMER->CTCR = 0;
+    LPC17_PWM_SEQUENCE_TIMER->MR0 = periodTicks - 1;
+    LPC17_PWM_SEQUENCE_TIMER->MCR = (1 << 1); // Reset on MR0
+    LPC17_PWM_SEQUENCE_TIMER->IR = 0xFFFFFFFF;
+
+    if (self->Index == 0)
+        PWM0TCR = (1 << 1);
+    else
+        PWM1TCR = (1 << 1);
+
+    auto dma = LPC17_Dma_GetChannel(LPC17_PWM_SEQUENCE_DMA_CHANNEL);
+
+    dma->CSrcAddr = sequence.items[0].source;
+    dma->CDestAddr = sequence.items[0].destination;
+    dma->CLLI = sequence.items[0].next;
+    dma->CControl = sequence.items[0].control;
+    dma->CConfig = (LPC17_PWM_SEQUENCE_DMA_REQUEST << 6) | GPDMA_CCONFIG_M2P | GPDMA_CCONFIG_IE | GPDMA_CCONFIG_ITC | GPDMA_CCONFIG_E;
+
+    // release both counters back to back so they stay in phase
+    LPC17_PWM_SEQUENCE_TIMER->TCR = (1 << 0);
+
+    if (self->Index == 0)
+        PWM0TCR = (1 << 0);
+    else
+        PWM1TCR = (1 << 0);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Pwm_StopSequence(const TinyCLR_Pwm_Provider* self) {
+    LPC17_Pwm_ReleaseSequence(self->Index);
 
     return TinyCLR_Result::Success;
 }
@@ -410,6 +613,8 @@ void LPC17_Pwm_Reset() {
 }
 
 void LPC17_Pwm_ResetController(int32_t controller) {
+    LPC17_Pwm_ReleaseSequence(controller);
+
     for (int p = 0; p < MAX_PWM_PER_CONTROLLER; p++) {
         g_PwmController[pwmProviders[controller]->Index].gpioPin[p] = LPC17_Pwm_GetPins(controller, p);
 
@@ -421,7 +626,8 @@ void LPC17_Pwm_ResetController(int32_t controller) {
             g_PwmController[pwmProviders[controller]->Index].outputEnabled[p] = false;
             g_PwmController[pwmProviders[controller]->Index].invert[p] = false;
             g_PwmController[pwmProviders[controller]->Index].frequency = 0.0;
-            g_PwmController[pwmProviders[controller]->Index].dutyCycle[p] = 0.0;
+            g_PwmController[pwmProviders[controller]->Index].periodTicks = 0;
+            g_PwmController[pwmProviders[controller]->Index].dutyCycle[p] = 0;
         }
     }
 }
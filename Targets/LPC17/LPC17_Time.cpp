@@ -25,8 +25,12 @@
 
 struct LPC17_Timer_Driver {
 
-    uint64_t m_lastRead;
-    uint32_t m_currentTick;
+    // SysTick is reloaded with the distance to the next event, the count is the start of the current
+    // period plus the progress into it. Both are only written by the SysTick interrupt or by a reload,
+    // with interrupts disabled, and m_sequence changes whenever they do.
+    volatile uint64_t m_periodStart;
+    volatile uint32_t m_period; // LOAD + 1
+    volatile uint32_t m_sequence;
     uint32_t m_periodTicks;
 
     TinyCLR_Time_TickCallback m_DequeuAndExecute;
@@ -110,32 +114,36 @@ uint64_t LPC17_Time_MicrosecondsToTicks(const TinyCLR_Time_Provider* self, uint6
 }
 
 uint64_t LPC17_Time_GetCurrentTicks(const TinyCLR_Time_Provider* self) {
-    DISABLE_INTERRUPTS_SCOPED(irq);
+    uint64_t start;
+    uint32_t period, value, wrapped;
 
-    uint32_t tick_spent;
-    uint32_t reg = SysTick->CTRL;
-    uint32_t ticks = (SysTick->VAL & SysTick_LOAD_RELOAD_Msk);
+    for (;;) {
+        uint32_t sequence = g_LPC17_Timer_Driver.m_sequence;
 
-    if ((reg & SysTick_CTRL_COUNTFLAG_Msk) == SysTick_CTRL_COUNTFLAG_Msk   // Interrupt was trigger on time as expected
-        || ticks >= g_LPC17_Timer_Driver.m_currentTick) {                // Interrupt was trigger slower than expected
-        if (ticks > 0) {
-            tick_spent = g_LPC17_Timer_Driver.m_currentTick + (SysTick->LOAD - ticks);
-        }
-        else {
-            tick_spent = g_LPC17_Timer_Driver.m_currentTick;
-        }
-    }
-    else {
-        tick_spent = g_LPC17_Timer_Driver.m_currentTick - ticks;
+        start = g_LPC17_Timer_Driver.m_periodStart;
+        period = g_LPC17_Timer_Driver.m_period;
+
+        // a wrap not yet seen by the interrupt counts only if VAL was read after it
+        wrapped = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+        value = SysTick->VAL & SysTick_LOAD_RELOAD_Msk;
+
+        if (wrapped != (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+            continue;
+
+        if (sequence == g_LPC17_Timer_Driver.m_sequence)
+            break;
     }
 
-    g_LPC17_Timer_Driver.m_currentTick = ticks;
-    g_LPC17_Timer_Driver.m_lastRead += tick_spent;
+    if (wrapped)
+        start += period;
 
-    return (uint64_t)(g_LPC17_Timer_Driver.m_lastRead & TIMER_IDLE_VALUE);
+    return (start + (period - 1 - value)) & TIMER_IDLE_VALUE;
 }
 
-TinyCLR_Result LPC17_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
+static void LPC17_Time_Dispatch(const TinyCLR_Time_Provider* self);
+
+// programs the hardware compare, it runs the events at once if processorTicks has passed
+static void LPC17_Time_ScheduleCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
     uint64_t ticks;
 
     DISABLE_INTERRUPTS_SCOPED(irq);
@@ -150,7 +158,7 @@ TinyCLR_Result LPC17_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t
     }
     else {
         if (ticks >= processorTicks) { // missed event
-            g_LPC17_Timer_Driver.m_DequeuAndExecute();
+            LPC17_Time_Dispatch(self);
         }
         else {
             g_LPC17_Timer_Driver.m_periodTicks = (processorTicks - ticks);
@@ -163,6 +171,176 @@ TinyCLR_Result LPC17_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t
             }
         }
     }
+}
+
+//******************** Timer service ********************
+
+// native timers share the hardware compare with the runtime: a min heap on the deadline keeps the earliest
+// timer at the top, and the compare is set to the earlier of it and the runtime event
+#define LPC17_Time_MaxTimers 32
+
+static LPC17_Time_Timer* g_LPC17_Time_Timers[LPC17_Time_MaxTimers];
+static int32_t g_LPC17_Time_TimerCount;
+
+static uint64_t g_runtimeEvent = TIMER_IDLE_VALUE; // next event asked for by the runtime
+
+static void LPC17_Time_TimerSwap(int32_t a, int32_t b) {
+    auto timer = g_LPC17_Time_Timers[a];
+
+    g_LPC17_Time_Timers[a] = g_LPC17_Time_Timers[b];
+    g_LPC17_Time_Timers[b] = timer;
+
+    g_LPC17_Time_Timers[a]->index = a;
+    g_LPC17_Time_Timers[b]->index = b;
+}
+
+static void LPC17_Time_TimerSiftUp(int32_t index) {
+    while (index > 0 && g_LPC17_Time_Timers[(index - 1) / 2]->deadline > g_LPC17_Time_Timers[index]->deadline) {
+        LPC17_Time_TimerSwap(index, (index - 1) / 2);
+
+        index = (index - 1) / 2;
+    }
+}
+
+static void LPC17_Time_TimerSiftDown(int32_t index) {
+    while (true) {
+        auto smallest = index;
+        auto left = index * 2 + 1;
+        auto right = index * 2 + 2;
+
+        if (left < g_LPC17_Time_TimerCount && g_LPC17_Time_Timers[left]->deadline < g_LPC17_Time_Timers[smallest]->deadline)
+            smallest = left;
+
+        if (right < g_LPC17_Time_TimerCount && g_LPC17_Time_Timers[right]->deadline < g_LPC17_Time_Timers[smallest]->deadline)
+            smallest = right;
+
+        if (smallest == index)
+            return;
+
+        LPC17_Time_TimerSwap(index, smallest);
+
+        index = smallest;
+    }
+}
+
+static bool LPC17_Time_TimerIsActive(LPC17_Time_Timer* timer) {
+    return timer->index >= 0 && timer->index < g_LPC17_Time_TimerCount && g_LPC17_Time_Timers[timer->index] == timer;
+}
+
+static void LPC17_Time_TimerInsert(LPC17_Time_Timer* timer) {
+    timer->index = g_LPC17_Time_TimerCount++;
+
+    g_LPC17_Time_Timers[timer->index] = timer;
+
+    LPC17_Time_TimerSiftUp(timer->index);
+}
+
+static void LPC17_Time_TimerRemove(LPC17_Time_Timer* timer) {
+    auto index = timer->index;
+
+    timer->index = -1;
+
+    if (index == --g_LPC17_Time_TimerCount)
+        return;
+
+    g_LPC17_Time_Timers[index] = g_LPC17_Time_Timers[g_LPC17_Time_TimerCount];
+    g_LPC17_Time_Timers[index]->index = index;
+
+    LPC17_Time_TimerSiftDown(index);
+    LPC17_Time_TimerSiftUp(index);
+}
+
+static uint64_t LPC17_Time_GetNextCompare() {
+    if (g_LPC17_Time_TimerCount > 0 && g_LPC17_Time_Timers[0]->deadline < g_runtimeEvent)
+        return g_LPC17_Time_Timers[0]->deadline;
+
+    return g_runtimeEvent;
+}
+
+// runs the timers that are due, a periodic timer is queued again before its callback so the callback can stop it
+static void LPC17_Time_ExecuteTimers(const TinyCLR_Time_Provider* self) {
+    auto now = LPC17_Time_GetCurrentTicks(self);
+
+    while (g_LPC17_Time_TimerCount > 0 && g_LPC17_Time_Timers[0]->deadline <= now) {
+        auto timer = g_LPC17_Time_Timers[0];
+
+        LPC17_Time_TimerRemove(timer);
+
+        if (timer->period != 0) {
+            timer->deadline += timer->period;
+
+            if (timer->deadline <= now) // missed periods are skipped, not run in a burst
+                timer->deadline = now + timer->period;
+
+            LPC17_Time_TimerInsert(timer);
+        }
+
+        timer->callback(timer->param);
+    }
+}
+
+static void LPC17_Time_Dispatch(const TinyCLR_Time_Provider* self) {
+    LPC17_Time_ExecuteTimers(self);
+
+    if (LPC17_Time_GetCurrentTicks(self) >= g_runtimeEvent) {
+        g_runtimeEvent = TIMER_IDLE_VALUE;
+
+        g_LPC17_Timer_Driver.m_DequeuAndExecute(); // schedules the next runtime event, if there is one
+    }
+
+    LPC17_Time_ScheduleCompare(self, LPC17_Time_GetNextCompare());
+}
+
+// timeout and period are in microseconds, a period of 0 makes a one shot timer. The callback runs in interrupt
+// context with interrupts disabled. The timer is owned by the caller and must stay valid while it is started.
+TinyCLR_Result LPC17_Time_StartTimer(const TinyCLR_Time_Provider* self, LPC17_Time_Timer* timer, uint64_t timeout, uint64_t period) {
+    if (timer == nullptr || timer->callback == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (g_LPC17_Timer_Driver.m_DequeuAndExecute == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (LPC17_Time_TimerIsActive(timer))
+        LPC17_Time_TimerRemove(timer);
+
+    if (g_LPC17_Time_TimerCount == LPC17_Time_MaxTimers)
+        return TinyCLR_Result::NotAvailable;
+
+    timer->deadline = LPC17_Time_GetCurrentTicks(self) + LPC17_Time_MicrosecondsToTicks(self, timeout);
+    timer->period = LPC17_Time_MicrosecondsToTicks(self, period);
+
+    if (period != 0 && timer->period == 0)
+        timer->period = 1;
+
+    LPC17_Time_TimerInsert(timer);
+
+    if (timer->index == 0)
+        LPC17_Time_ScheduleCompare(self, LPC17_Time_GetNextCompare());
+
+    return TinyCLR_Result::Success;
+}
+
+// a stopped timer can leave one early compare interrupt behind, which finds nothing to run
+TinyCLR_Result LPC17_Time_StopTimer(const TinyCLR_Time_Provider* self, LPC17_Time_Timer* timer) {
+    if (timer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (LPC17_Time_TimerIsActive(timer))
+        LPC17_Time_TimerRemove(timer);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC17_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    g_runtimeEvent = processorTicks;
+
+    LPC17_Time_ScheduleCompare(self, LPC17_Time_GetNextCompare());
 
     return TinyCLR_Result::Success;
 }
@@ -172,11 +350,20 @@ extern "C" {
     void SysTick_Handler(void *param) {
         INTERRUPT_STARTED_SCOPED(isr);
 
+        // SysTick has the highest priority, so nothing reads the count between the exception entry
+        // clearing the pending wrap and this
+        {
+            DISABLE_INTERRUPTS_SCOPED(irq);
+
+            g_LPC17_Timer_Driver.m_sequence++;
+            g_LPC17_Timer_Driver.m_periodStart += g_LPC17_Timer_Driver.m_period;
+        }
+
             if (LPC17_Time_GetCurrentTicks(nullptr) >= g_nextEvent) { // handle event
-                g_LPC17_Timer_Driver.m_DequeuAndExecute();
+                LPC17_Time_Dispatch(nullptr);
             }
             else {
-                LPC17_Time_SetCompare(nullptr, g_nextEvent);
+                LPC17_Time_ScheduleCompare(nullptr, g_nextEvent);
             }            
     }
 
@@ -239,20 +426,38 @@ void LPC17_Time_Delay(const TinyCLR_Time_Provider* self, uint64_t microseconds)
 //******************** Profiler ********************
 
 bool LPC17_Timer_Driver::Initialize() {
-    g_LPC17_Timer_Driver.m_lastRead = 0;
-
-    g_LPC17_Timer_Driver.m_currentTick = SysTick_LOAD_RELOAD_Msk;
+    g_LPC17_Timer_Driver.m_sequence++;
+    g_LPC17_Timer_Driver.m_periodStart = 0;
+    g_LPC17_Timer_Driver.m_period = SysTick_LOAD_RELOAD_Msk;
     g_LPC17_Timer_Driver.m_periodTicks = SysTick_LOAD_RELOAD_Msk;
 
     SysTick_Config(g_LPC17_Timer_Driver.m_periodTicks);
+    NVIC_SetPriority(SysTick_IRQn, 0); // SysTick_Config leaves it at the lowest
+
+    while (SysTick->VAL == 0); // VAL loads LOAD one clock after the write
 
     return true;
 }
+
+// the current count becomes the start of a period of value ticks
 void LPC17_Timer_Driver::Reload(uint32_t value) {
-    g_LPC17_Timer_Driver.m_currentTick = value;
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    uint64_t now = LPC17_Time_GetCurrentTicks(nullptr);
+
+    if (value < 2) // a LOAD of 0 stops the counter
+        value = 2;
 
-    SysTick->LOAD = (uint32_t)(g_LPC17_Timer_Driver.m_currentTick - 1UL);
+    SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk; // a pending wrap is already in now
+
+    SysTick->LOAD = (uint32_t)(value - 1UL);
     SysTick->VAL = 0UL;
+
+    while (SysTick->VAL == 0); // VAL loads LOAD one clock after the write
+
+    g_LPC17_Timer_Driver.m_periodStart = now;
+    g_LPC17_Timer_Driver.m_period = value;
+    g_LPC17_Timer_Driver.m_sequence++;
 }
 #ifdef __GNUC__
 asm volatile (
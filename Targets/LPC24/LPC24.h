@@ -155,6 +155,16 @@ TinyCLR_Result LPC24_Gpio_Release(const TinyCLR_Gpio_Provider* self);
 TinyCLR_Result LPC24_Gpio_EnableAlternatePin(int32_t pin, TinyCLR_Gpio_PinDriveMode resistor, uint32_t alternate);
 TinyCLR_Result LPC24_Gpio_Read(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& value);
 TinyCLR_Result LPC24_Gpio_Write(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue value);
+TinyCLR_Result LPC24_Gpio_ReadPort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t& value);
+TinyCLR_Result LPC24_Gpio_WritePort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t mask, uint32_t value);
+
+struct LPC24_Gpio_WaveformStep {
+    TinyCLR_Gpio_PinValue value;
+    uint32_t duration; // nanoseconds
+};
+
+TinyCLR_Result LPC24_Gpio_WriteWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, const LPC24_Gpio_WaveformStep* steps, size_t count);
+TinyCLR_Result LPC24_Gpio_CaptureWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& initialValue, uint32_t* durations, size_t& count, uint32_t timeout);
 TinyCLR_Result LPC24_Gpio_SetDebounceTimeout(const TinyCLR_Gpio_Provider* self, int32_t pin, int32_t debounceTime);
 TinyCLR_Result LPC24_Gpio_SetDriveMode(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinDriveMode mode);
 TinyCLR_Result LPC24_Gpio_AcquirePin(const TinyCLR_Gpio_Provider* self, int32_t pin);
@@ -193,6 +203,14 @@ TinyCLR_Result LPC24_Adc_SetChannelMode(const TinyCLR_Adc_Provider* self, TinyCL
 bool LPC24_Adc_IsChannelModeSupported(const TinyCLR_Adc_Provider* self, TinyCLR_Adc_ChannelMode mode);
 
 //DAC
+enum class LPC24_Dac_PlaybackEvent : uint8_t {
+    HalfTransfer = 0,
+    TransferComplete = 1,
+    Error = 2,
+};
+
+typedef void(*LPC24_Dac_PlaybackHandler)(int32_t channel, LPC24_Dac_PlaybackEvent event);
+
 const TinyCLR_Api_Info* LPC24_Dac_GetApi();
 void LPC24_Dac_Reset();
 TinyCLR_Result LPC24_Dac_Acquire(const TinyCLR_Dac_Provider* self);
@@ -204,6 +222,8 @@ int32_t LPC24_Dac_GetChannelCount(const TinyCLR_Dac_Provider* self);
 int32_t LPC24_Dac_GetResolutionInBits(const TinyCLR_Dac_Provider* self);
 int32_t LPC24_Dac_GetMinValue(const TinyCLR_Dac_Provider* self);
 int32_t LPC24_Dac_GetMaxValue(const TinyCLR_Dac_Provider* self);
+TinyCLR_Result LPC24_Dac_StartPlayback(const TinyCLR_Dac_Provider* self, int32_t channel, const uint32_t* buffer, size_t length, uint32_t& sampleRate, bool circular, LPC24_Dac_PlaybackHandler handler);
+TinyCLR_Result LPC24_Dac_StopPlayback(const TinyCLR_Dac_Provider* self, int32_t channel);
 
 // PWM
 struct PwmController {
@@ -214,8 +234,12 @@ struct PwmController {
     uint32_t                    *matchAddress[MAX_PWM_PER_CONTROLLER];
     bool                        invert[MAX_PWM_PER_CONTROLLER];
     double                      frequency;
-    double                      dutyCycle[MAX_PWM_PER_CONTROLLER];
+    uint32_t                    periodTicks;
+    uint32_t                    dutyCycle[MAX_PWM_PER_CONTROLLER]; // Q16
 };
+
+#define LPC24_PWM_DUTY_CYCLE_FULL 0x10000 // 1.0 in Q16
+
 const TinyCLR_Api_Info* LPC24_Pwm_GetApi();
 void LPC24_Pwm_Reset();
 void LPC24_Pwm_ResetController(int32_t controller);
@@ -229,11 +253,41 @@ TinyCLR_Result LPC24_Pwm_ReleasePin(const TinyCLR_Pwm_Provider* self, int32_t pi
 TinyCLR_Result LPC24_Pwm_EnablePin(const TinyCLR_Pwm_Provider* self, int32_t pin);
 TinyCLR_Result LPC24_Pwm_DisablePin(const TinyCLR_Pwm_Provider* self, int32_t pin);
 TinyCLR_Result LPC24_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity);
+TinyCLR_Result LPC24_Pwm_SetPulseParametersFixed(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity);
+TinyCLR_Result LPC24_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Provider* self, const int32_t* pins, const uint32_t* dutyCycles, const bool* invertPolarity, size_t count);
 double LPC24_Pwm_GetMinFrequency(const TinyCLR_Pwm_Provider* self);
 double LPC24_Pwm_GetMaxFrequency(const TinyCLR_Pwm_Provider* self);
 double LPC24_Pwm_GetActualFrequency(const TinyCLR_Pwm_Provider* self);
 int32_t LPC24_Pwm_GetPinCount(const TinyCLR_Pwm_Provider* self);
 
+//Counter
+enum class LPC24_Counter_Edge : uint8_t {
+    Rising = 0,
+    Falling = 1,
+    Both = 2,
+};
+
+typedef void(*LPC24_Counter_CompareHandler)(int32_t controller, uint64_t count);
+
+TinyCLR_Result LPC24_Counter_Acquire(int32_t controller, LPC24_Counter_Edge edge);
+TinyCLR_Result LPC24_Counter_Release(int32_t controller);
+TinyCLR_Result LPC24_Counter_GetCount(int32_t controller, uint64_t& count);
+TinyCLR_Result LPC24_Counter_ClearCount(int32_t controller);
+TinyCLR_Result LPC24_Counter_SetCompare(int32_t controller, uint64_t compare, LPC24_Counter_CompareHandler handler);
+
+//OnePulse
+enum class LPC24_OnePulse_Trigger : uint8_t {
+    Software = 0,
+    RisingEdge = 1,
+    FallingEdge = 2,
+};
+
+TinyCLR_Result LPC24_OnePulse_Acquire(int32_t controller, LPC24_OnePulse_Trigger trigger, bool invert);
+TinyCLR_Result LPC24_OnePulse_Release(int32_t controller);
+TinyCLR_Result LPC24_OnePulse_SetPulse(int32_t controller, uint32_t delayNanoseconds, uint32_t widthNanoseconds);
+TinyCLR_Result LPC24_OnePulse_Fire(int32_t controller);
+TinyCLR_Result LPC24_OnePulse_IsBusy(int32_t controller, bool& busy);
+
 //SPI
 const TinyCLR_Api_Info* LPC24_Spi_GetApi();
 void LPC24_Spi_Reset();
@@ -377,6 +431,20 @@ void LPC24_Time_DelayNoInterrupt(const TinyCLR_Time_Provider* self, uint64_t mic
 void LPC24_Time_Delay(const TinyCLR_Time_Provider* self, uint64_t microseconds);
 void LPC24_Time_GetDriftParameters(const TinyCLR_Time_Provider* self, int32_t* a, int32_t* b, int64_t* c);
 
+typedef void(*LPC24_Time_TimerCallback)(void* param);
+
+struct LPC24_Time_Timer {
+    LPC24_Time_TimerCallback callback;
+    void* param;
+
+    uint64_t deadline; // processor ticks
+    uint64_t period; // processor ticks, 0 for one shot
+    int32_t index; // position in the timer heap
+};
+
+TinyCLR_Result LPC24_Time_StartTimer(const TinyCLR_Time_Provider* self, LPC24_Time_Timer* timer, uint64_t timeout, uint64_t period);
+TinyCLR_Result LPC24_Time_StopTimer(const TinyCLR_Time_Provider* self, LPC24_Time_Timer* timer);
+
 // Power
 const TinyCLR_Api_Info* LPC24_Power_GetApi();
 void LPC24_Power_SetHandlers(void(*stop)(), void(*restart)());
@@ -721,6 +789,8 @@ struct LPC24XX_TIMER {
     /****/ volatile uint32_t CR2;    // Capture 2 register
     /****/ volatile uint32_t CR3;    // Capture 3 register
     /****/ volatile uint32_t EMR;    // External match register
+    /****/ volatile uint32_t Reserved0[12];
+    /****/ volatile uint32_t CTCR;   // Count control register
     //functions.
     static uint32_t inline getIntNo(int Timer) {
         switch (Timer) {
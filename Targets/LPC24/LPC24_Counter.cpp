@@ -0,0 +1,230 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC24.h"
+
+#ifdef INCLUDE_COUNTER
+///////////////////////////////////////////////////////////////////////////////
+
+// controller x is timer x in counter mode, clocked by CAPx.0. Timer 0 is the system timer.
+#define LPC24_COUNTER_CTCR_INPUT_CAP0 (0 << 2)
+
+// MR0 is the compare, MR2 and MR3 sample TC twice per lap to extend it to 64 bit
+#define LPC24_COUNTER_MCR_MR0I (1 << 0)
+#define LPC24_COUNTER_MCR_MR2I (1 << 6)
+#define LPC24_COUNTER_MCR_MR3I (1 << 9)
+#define LPC24_COUNTER_IR_MR0 (1 << 0)
+#define LPC24_COUNTER_IR_MR2 (1 << 2)
+#define LPC24_COUNTER_IR_MR3 (1 << 3)
+
+struct LPC24_Counter_Controller {
+    bool acquired;
+
+    uint32_t lastCount;
+    uint64_t count;
+
+    uint64_t compare;
+    LPC24_Counter_CompareHandler handler;
+};
+
+static const LPC24_Gpio_Pin g_LPC24_Counter_Pins[] = LPC24_COUNTER_PINS;
+
+static const int TOTAL_COUNTER_CONTROLLERS = SIZEOF_ARRAY(g_LPC24_Counter_Pins);
+
+static LPC24_Counter_Controller g_LPC24_Counter_Controller[TOTAL_COUNTER_CONTROLLERS];
+
+static uint32_t LPC24_Counter_GetPower(int32_t controller) {
+    static const uint32_t power[] = { PCONP_PCTIM0, PCONP_PCTIM1, PCONP_PCTIM2, PCONP_PCTIM3 };
+
+    return power[controller];
+}
+
+static uint64_t LPC24_Counter_Update(LPC24XX_TIMER& TIMER, LPC24_Counter_Controller& state) {
+    uint32_t count = TIMER.TC;
+
+    // TC only counts up and is sampled at least every half lap, so the unsigned delta is exact
+    state.count += count - state.lastCount;
+    state.lastCount = count;
+
+    return state.count;
+}
+
+void LPC24_Counter_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    int32_t controller = (int32_t)param;
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(controller);
+    auto& state = g_LPC24_Counter_Controller[controller];
+    auto ir = TIMER.IR & (LPC24_COUNTER_IR_MR0 | LPC24_COUNTER_IR_MR2 | LPC24_COUNTER_IR_MR3);
+
+    TIMER.IR = ir; // clear
+
+    auto count = LPC24_Counter_Update(TIMER, state);
+
+    if ((ir & LPC24_COUNTER_IR_MR0) && (TIMER.MCR & LPC24_COUNTER_MCR_MR0I) && count >= state.compare) {
+        TIMER.MCR &= ~LPC24_COUNTER_MCR_MR0I;
+
+        if (state.handler != nullptr)
+            state.handler(controller, count);
+    }
+}
+
+TinyCLR_Result LPC24_Counter_Acquire(int32_t controller, LPC24_Counter_Edge edge) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(controller);
+    auto& state = g_LPC24_Counter_Controller[controller];
+
+    if (state.acquired || ((LPC24XX::SYSCON().PCONP & LPC24_Counter_GetPower(controller)) && (TIMER.TCR & LPC24XX_TIMER::TCR_TEN))) // timer used by the DAC or the system timer
+        return TinyCLR_Result::SharingViolation;
+
+    auto& pin = g_LPC24_Counter_Pins[controller];
+
+    if (pin.number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+    if (!LPC24_Gpio_OpenPin(pin.number))
+        return TinyCLR_Result::SharingViolation;
+
+    LPC24_Gpio_ConfigurePin(pin.number, LPC24_Gpio_Direction::Input, pin.pinFunction, LPC24_Gpio_PinMode::Inactive);
+
+    state.acquired = true;
+    state.lastCount = 0;
+    state.count = 0;
+    state.compare = 0;
+    state.handler = nullptr;
+
+    LPC24XX::SYSCON().PCONP |= LPC24_Counter_GetPower(controller);
+
+    TIMER.TCR = 0x2; // hold in reset
+    TIMER.CTCR = (static_cast<uint32_t>(edge) + 1) | LPC24_COUNTER_CTCR_INPUT_CAP0; // 1 rising, 2 falling, 3 both edges
+    TIMER.PR = 0;
+    TIMER.CCR = 0; // the counting input must not also capture
+    TIMER.EMR = 0;
+    TIMER.MR2 = 0x80000000;
+    TIMER.MR3 = 0;
+    TIMER.MCR = LPC24_COUNTER_MCR_MR2I | LPC24_COUNTER_MCR_MR3I;
+    TIMER.IR = 0xFFFFFFFF;
+
+    LPC24_Interrupt_Activate(LPC24XX_TIMER::getIntNo(controller), (uint32_t*)&LPC24_Counter_InterruptHandler, (void*)controller);
+
+    TIMER.TCR = LPC24XX_TIMER::TCR_TEN;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC24_Counter_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(controller);
+    auto& state = g_LPC24_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    TIMER.TCR = 0;
+    TIMER.MCR = 0;
+    TIMER.CTCR = 0;
+    TIMER.IR = 0xFFFFFFFF;
+
+    LPC24_Interrupt_Deactivate(LPC24XX_TIMER::getIntNo(controller));
+
+    LPC24XX::SYSCON().PCONP &= ~LPC24_Counter_GetPower(controller);
+
+    auto& pin = g_LPC24_Counter_Pins[controller];
+
+    LPC24_Gpio_ConfigurePin(pin.number, LPC24_Gpio_Direction::Input, LPC24_Gpio_PinFunction::PinFunction0, LPC24_Gpio_PinMode::Inactive);
+    LPC24_Gpio_ClosePin(pin.number);
+
+    state.acquired = false;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC24_Counter_GetCount(int32_t controller, uint64_t& count) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC24_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    count = LPC24_Counter_Update(LPC24XX::TIMER(controller), state);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC24_Counter_ClearCount(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC24_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(controller);
+
+    TIMER.MCR &= ~LPC24_COUNTER_MCR_MR0I; // a pending compare refers to the old count
+
+    LPC24_Counter_Update(TIMER, state);
+
+    state.count = 0;
+
+    return TinyCLR_Result::Success;
+}
+
+// handler runs in interrupt context once the count reaches compare, no interrupt is taken per edge
+TinyCLR_Result LPC24_Counter_SetCompare(int32_t controller, uint64_t compare, LPC24_Counter_CompareHandler handler) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC24_Counter_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(controller);
+
+    TIMER.MCR &= ~LPC24_COUNTER_MCR_MR0I;
+
+    if (handler == nullptr)
+        return TinyCLR_Result::Success;
+
+    auto count = LPC24_Counter_Update(TIMER, state);
+
+    if (compare <= count)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    state.compare = compare;
+    state.handler = handler;
+
+    TIMER.MR0 = state.lastCount + (uint32_t)(compare - count);
+    TIMER.IR = LPC24_COUNTER_IR_MR0;
+    TIMER.MCR |= LPC24_COUNTER_MCR_MR0I;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
@@ -21,6 +21,11 @@
 #define LPC24_DAC_PRECISION_BITS 	10	// Number of Bits in the DAC Convertion
 #define LPC24_DAC_MAX_VALUE 	(1<<LPC24_DAC_PRECISION_BITS)
 
+// The LPC24 DAC has no counter or DMA request, playback is paced by a timer match interrupt instead
+#define LPC24_DAC_TIMER LPC24XX_TIMER::c_Timer_1
+#define LPC24_DAC_TIMER_CLOCK_HZ SYSTEM_CLOCK_HZ
+#define LPC24_DAC_TIMER_MR0_INT_RESET 0x3 // interrupt and reset on MR0
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static TinyCLR_Dac_Provider dacProvider;
@@ -28,6 +33,18 @@ static TinyCLR_Api_Info dacApi;
 
 static const LPC24_Gpio_Pin g_LPC24_Dac_Pins[] = LPC24_DAC_PINS;
 
+struct LPC24_Dac_Playback {
+    const uint32_t* buffer;
+    size_t length;
+    size_t index;
+    LPC24_Dac_PlaybackHandler handler;
+    bool circular;
+    bool active;
+    bool poweredOn;
+};
+
+static LPC24_Dac_Playback g_LPC24_Dac_Playback;
+
 const TinyCLR_Api_Info* LPC24_Dac_GetApi() {
     dacProvider.Parent = &dacApi;
     dacProvider.Index = 0;
@@ -83,6 +100,8 @@ TinyCLR_Result LPC24_Dac_ReleaseChannel(const TinyCLR_Dac_Provider* self, int32_
     if (channel >= LPC24_Dac_GetChannelCount(self))
         return TinyCLR_Result::ArgumentOutOfRange;
 
+    LPC24_Dac_StopPlayback(self, channel);
+
     LPC24_Gpio_ClosePin(g_LPC24_Dac_Pins[channel].number);
 
     return TinyCLR_Result::Success;
@@ -92,6 +111,9 @@ TinyCLR_Result LPC24_Dac_WriteValue(const TinyCLR_Dac_Provider* self, int32_t ch
     if (channel >= LPC24_Dac_GetChannelCount(self))
         return TinyCLR_Result::ArgumentOutOfRange;
 
+    if (g_LPC24_Dac_Playback.active)
+        return TinyCLR_Result::InvalidOperation;
+
     if (value > LPC24_DAC_MAX_VALUE) {
         value = LPC24_DAC_MAX_VALUE;
     }
@@ -105,6 +127,99 @@ TinyCLR_Result LPC24_Dac_WriteValue(const TinyCLR_Dac_Provider* self, int32_t ch
     return TinyCLR_Result::Success;
 }
 
+void LPC24_Dac_TimerInterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(LPC24_DAC_TIMER);
+    auto& playback = g_LPC24_Dac_Playback;
+
+    TIMER.IR = LPC24XX_TIMER::MR0_RESET;
+
+    DACR = playback.buffer[playback.index++];
+
+    if (playback.circular && playback.index == playback.length / 2) {
+        if (playback.handler != nullptr)
+            playback.handler(0, LPC24_Dac_PlaybackEvent::HalfTransfer);
+    }
+    else if (playback.index == playback.length) {
+        playback.index = 0;
+
+        if (!playback.circular)
+            LPC24_Dac_StopPlayback(nullptr, 0);
+
+        if (playback.handler != nullptr)
+            playback.handler(0, LPC24_Dac_PlaybackEvent::TransferComplete);
+    }
+}
+
+// buffer holds DACR words, the sample value in bits 6..15
+TinyCLR_Result LPC24_Dac_StartPlayback(const TinyCLR_Dac_Provider* self, int32_t channel, const uint32_t* buffer, size_t length, uint32_t& sampleRate, bool circular, LPC24_Dac_PlaybackHandler handler) {
+    if (buffer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (channel < 0 || channel >= LPC24_Dac_GetChannelCount(self) || length == 0 || sampleRate == 0 || sampleRate > LPC24_DAC_TIMER_CLOCK_HZ)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (g_LPC24_Dac_Playback.active)
+        return TinyCLR_Result::InvalidOperation;
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(LPC24_DAC_TIMER);
+
+    auto powered = (LPC24XX::SYSCON().PCONP & PCONP_PCTIM1) != 0;
+
+    if (powered && (TIMER.TCR & LPC24XX_TIMER::TCR_TEN)) // timer used by a counter or one pulse
+        return TinyCLR_Result::SharingViolation;
+
+    uint32_t divider = LPC24_DAC_TIMER_CLOCK_HZ / sampleRate;
+
+    g_LPC24_Dac_Playback.buffer = buffer;
+    g_LPC24_Dac_Playback.length = length;
+    g_LPC24_Dac_Playback.index = 0;
+    g_LPC24_Dac_Playback.handler = handler;
+    g_LPC24_Dac_Playback.circular = circular;
+    g_LPC24_Dac_Playback.active = true;
+    g_LPC24_Dac_Playback.poweredOn = !powered;
+
+    LPC24XX::SYSCON().PCONP |= PCONP_PCTIM1;
+
+    TIMER.TCR = 0x2; // reset
+    TIMER.PR = 0;
+    TIMER.MR0 = divider - 1;
+    TIMER.MCR = LPC24_DAC_TIMER_MR0_INT_RESET;
+    TIMER.IR = LPC24XX_TIMER::MR0_RESET;
+
+    LPC24_Interrupt_Activate(LPC24XX_TIMER::getIntNo(LPC24_DAC_TIMER), (uint32_t*)&LPC24_Dac_TimerInterruptHandler, 0);
+
+    TIMER.TCR = LPC24XX_TIMER::TCR_TEN;
+
+    sampleRate = LPC24_DAC_TIMER_CLOCK_HZ / divider;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC24_Dac_StopPlayback(const TinyCLR_Dac_Provider* self, int32_t channel) {
+    if (channel < 0 || channel >= LPC24_Dac_GetChannelCount(&dacProvider))
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!g_LPC24_Dac_Playback.active)
+        return TinyCLR_Result::Success;
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(LPC24_DAC_TIMER);
+
+    TIMER.TCR = 0;
+    TIMER.MCR = 0;
+    TIMER.IR = LPC24XX_TIMER::MR0_RESET;
+
+    LPC24_Interrupt_Deactivate(LPC24XX_TIMER::getIntNo(LPC24_DAC_TIMER));
+
+    if (g_LPC24_Dac_Playback.poweredOn) // leave the timer powered as playback found it
+        LPC24XX::SYSCON().PCONP &= ~PCONP_PCTIM1;
+
+    g_LPC24_Dac_Playback.active = false;
+
+    return TinyCLR_Result::Success;
+}
+
 int32_t LPC24_Dac_GetChannelCount(const TinyCLR_Dac_Provider* self) {
     return SIZEOF_ARRAY(g_LPC24_Dac_Pins);
 }
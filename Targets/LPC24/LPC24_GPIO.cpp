@@ -43,6 +43,8 @@
 #define FIO0PIN0 (*(volatile unsigned char *)0x3FFFC014)
 #define FIO0PIN0_OFFSET 0x14
 
+#define FIO0MASK_OFFSET 0x10
+
 #define FIO0SET (*(volatile unsigned long *)0x3FFFC018)
 #define FIO0SET_OFFSET 0x18
 
@@ -363,6 +365,135 @@ TinyCLR_Result LPC24_Gpio_Write(const TinyCLR_Gpio_Provider* self, int32_t pin,
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result LPC24_Gpio_ReadPort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t& value) {
+    if (port < 0 || port >= (LPC24_Gpio_MaxPins + 31) / 32)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    value = *((volatile uint32_t *)(FIO_BASE + FIO0PIN_OFFSET + port * 0x20));
+
+    return TinyCLR_Result::Success;
+}
+
+// pins in mask take their bit from value in a single FIOPIN write, FIOMASK keeps the others untouched
+TinyCLR_Result LPC24_Gpio_WritePort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t mask, uint32_t value) {
+    if (port < 0 || port >= (LPC24_Gpio_MaxPins + 31) / 32)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    volatile uint32_t* fioMask = (volatile uint32_t *)(FIO_BASE + FIO0MASK_OFFSET + port * 0x20);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    *fioMask = ~mask;
+    *((volatile uint32_t *)(FIO_BASE + FIO0PIN_OFFSET + port * 0x20)) = value;
+    *fioMask = 0; // single pin access relies on an open mask
+
+    return TinyCLR_Result::Success;
+}
+
+// waveforms are timed by the free running system timer and run with interrupts disabled
+#define LPC24_Gpio_WaveformTimer 0 // system timer
+#define LPC24_Gpio_WaveformClockHz (SYSTEM_CLOCK_HZ)
+
+struct LPC24_Gpio_WaveformClock {
+    uint32_t last;
+    uint32_t ticks;
+};
+
+static uint32_t LPC24_Gpio_WaveformNanosecondsToTicks(uint32_t nanoseconds) {
+    return ((uint64_t)nanoseconds * LPC24_Gpio_WaveformClockHz) / 1000000000;
+}
+
+// extends the counter to 32 bit, it has to be read at least once per lap
+static uint32_t LPC24_Gpio_WaveformNow(LPC24_Gpio_WaveformClock& clock) {
+    uint32_t counter = LPC24XX::TIMER(LPC24_Gpio_WaveformTimer).TC;
+
+    clock.ticks += (counter - clock.last) & 0xFFFFFFFF;
+    clock.last = counter;
+
+    return clock.ticks;
+}
+
+// each step holds its level for its duration, the edges are placed against the start so the delays do not add up
+TinyCLR_Result LPC24_Gpio_WriteWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, const LPC24_Gpio_WaveformStep* steps, size_t count) {
+    if (pin < 0 || pin >= LPC24_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (steps == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    volatile uint32_t* fioSet = (volatile uint32_t *)(FIO_BASE + FIO0SET_OFFSET + (pin / 32) * 0x20);
+    volatile uint32_t* fioClr = (volatile uint32_t *)(FIO_BASE + FIO0CLR_OFFSET + (pin / 32) * 0x20);
+    uint32_t mask = 1 << (pin % 32);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    LPC24_Gpio_WaveformClock clock = { LPC24XX::TIMER(LPC24_Gpio_WaveformTimer).TC, 0 };
+    uint32_t deadline = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (steps[i].value == TinyCLR_Gpio_PinValue::High)
+            *fioSet = mask;
+        else
+            *fioClr = mask;
+
+        deadline += LPC24_Gpio_WaveformNanosecondsToTicks(steps[i].duration);
+
+        while ((int32_t)(LPC24_Gpio_WaveformNow(clock) - deadline) < 0);
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+// durations receives the time between edges, starting from the call, until count edges are seen or
+// the pin stays unchanged for timeout nanoseconds. count returns the number of edges.
+TinyCLR_Result LPC24_Gpio_CaptureWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& initialValue, uint32_t* durations, size_t& count, uint32_t timeout) {
+    if (pin < 0 || pin >= LPC24_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (durations == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    volatile uint32_t* fioPin = (volatile uint32_t *)(FIO_BASE + FIO0PIN_OFFSET + (pin / 32) * 0x20);
+    uint32_t mask = 1 << (pin % 32);
+
+    uint32_t timeoutTicks = LPC24_Gpio_WaveformNanosecondsToTicks(timeout);
+    size_t captured = 0;
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        uint32_t level = (*fioPin & mask);
+
+        LPC24_Gpio_WaveformClock clock = { LPC24XX::TIMER(LPC24_Gpio_WaveformTimer).TC, 0 };
+        uint32_t last = 0;
+
+        initialValue = level ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+
+        while (captured < count) {
+            uint32_t now = LPC24_Gpio_WaveformNow(clock);
+
+            if (((*fioPin & mask)) == level) {
+                if (now - last >= timeoutTicks)
+                    break;
+
+                continue;
+            }
+
+            level ^= mask;
+
+            durations[captured++] = now - last; // ticks for now, converted once the capture is over
+            last = now;
+        }
+    }
+
+    for (size_t i = 0; i < captured; i++)
+        durations[i] = ((uint64_t)durations[i] * 1000000000) / LPC24_Gpio_WaveformClockHz;
+
+    count = captured;
+
+    return TinyCLR_Result::Success;
+}
+
 TinyCLR_Result LPC24_Gpio_AcquirePin(const TinyCLR_Gpio_Provider* self, int32_t pin) {
 
     DISABLE_INTERRUPTS_SCOPED(irq);
@@ -0,0 +1,275 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "LPC24.h"
+
+#ifdef INCLUDE_ONEPULSE
+///////////////////////////////////////////////////////////////////////////////
+
+// controller x is timer x: CAPx.0 triggers and the pulse is output on MATx.0. Timer 0 is the system timer.
+// The trigger edge is captured in hardware and both pulse edges are match events relative to it,
+// so the interrupt only reloads MR0 and the pulse jitter is that of the timer, not of the interrupt.
+#define LPC24_ONEPULSE_TRIGGER_PIN 0
+#define LPC24_ONEPULSE_OUTPUT_PIN 1
+#define LPC24_ONEPULSE_TIMER_CLOCK_HZ SYSTEM_CLOCK_HZ
+#define LPC24_ONEPULSE_MIN_TICKS (LPC24_ONEPULSE_TIMER_CLOCK_HZ / 200000) // 5us, MR0 must be reloaded before it is reached
+
+#define LPC24_ONEPULSE_MCR_MR0I (1 << 0)
+#define LPC24_ONEPULSE_IR_MR0 (1 << 0)
+#define LPC24_ONEPULSE_IR_CR0 (1 << 4)
+#define LPC24_ONEPULSE_CCR_RE (1 << 0)
+#define LPC24_ONEPULSE_CCR_FE (1 << 1)
+#define LPC24_ONEPULSE_CCR_I (1 << 2)
+#define LPC24_ONEPULSE_EMR_EM0 (1 << 0)
+#define LPC24_ONEPULSE_EMR_EMC0_CLEAR (1 << 4)
+#define LPC24_ONEPULSE_EMR_EMC0_SET (2 << 4)
+
+enum class LPC24_OnePulse_Phase : uint8_t {
+    Idle = 0,
+    Delay = 1,
+    Width = 2,
+};
+
+struct LPC24_OnePulse_Controller {
+    bool acquired;
+    bool configured;
+    bool invert;
+    LPC24_OnePulse_Trigger trigger;
+    LPC24_OnePulse_Phase phase;
+
+    uint32_t delay;
+    uint32_t width;
+};
+
+static const LPC24_Gpio_Pin g_LPC24_OnePulse_Pins[][2] = LPC24_ONEPULSE_PINS;
+
+static const int TOTAL_ONEPULSE_CONTROLLERS = SIZEOF_ARRAY(g_LPC24_OnePulse_Pins);
+
+static LPC24_OnePulse_Controller g_LPC24_OnePulse_Controller[TOTAL_ONEPULSE_CONTROLLERS];
+
+static uint32_t LPC24_OnePulse_GetPower(int32_t controller) {
+    static const uint32_t power[] = { PCONP_PCTIM0, PCONP_PCTIM1, PCONP_PCTIM2, PCONP_PCTIM3 };
+
+    return power[controller];
+}
+
+// MAT0 goes to the pulse level at start + delay
+static void LPC24_OnePulse_Start(LPC24XX_TIMER& TIMER, LPC24_OnePulse_Controller& state, uint32_t start) {
+    TIMER.MR0 = start + state.delay;
+    TIMER.EMR = (state.invert ? LPC24_ONEPULSE_EMR_EM0 | LPC24_ONEPULSE_EMR_EMC0_CLEAR : LPC24_ONEPULSE_EMR_EMC0_SET);
+    TIMER.IR = LPC24_ONEPULSE_IR_MR0;
+    TIMER.MCR = LPC24_ONEPULSE_MCR_MR0I;
+
+    state.phase = LPC24_OnePulse_Phase::Delay;
+}
+
+void LPC24_OnePulse_InterruptHandler(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    int32_t controller = (int32_t)param;
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(controller);
+    auto& state = g_LPC24_OnePulse_Controller[controller];
+    auto ir = TIMER.IR & (LPC24_ONEPULSE_IR_MR0 | LPC24_ONEPULSE_IR_CR0);
+
+    TIMER.IR = ir; // clear
+
+    if (ir & LPC24_ONEPULSE_IR_MR0) {
+        if (state.phase == LPC24_OnePulse_Phase::Delay) {
+            // pulse started, the next match ends it
+            TIMER.MR0 += state.width;
+            TIMER.EMR = (state.invert ? LPC24_ONEPULSE_EMR_EMC0_SET : LPC24_ONEPULSE_EMR_EM0 | LPC24_ONEPULSE_EMR_EMC0_CLEAR);
+
+            state.phase = LPC24_OnePulse_Phase::Width;
+        }
+        else if (state.phase == LPC24_OnePulse_Phase::Width) {
+            TIMER.MCR = 0;
+            TIMER.EMR = state.invert ? LPC24_ONEPULSE_EMR_EM0 : 0;
+
+            state.phase = LPC24_OnePulse_Phase::Idle;
+        }
+    }
+
+    if ((ir & LPC24_ONEPULSE_IR_CR0) && state.configured && state.phase == LPC24_OnePulse_Phase::Idle) // edges during a pulse are ignored
+        LPC24_OnePulse_Start(TIMER, state, TIMER.CR0);
+}
+
+static TinyCLR_Result LPC24_OnePulse_OpenPin(int32_t controller, int32_t index, LPC24_Gpio_Direction direction) {
+    auto& pin = g_LPC24_OnePulse_Pins[controller][index];
+
+    if (pin.number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+    if (!LPC24_Gpio_OpenPin(pin.number))
+        return TinyCLR_Result::SharingViolation;
+
+    LPC24_Gpio_ConfigurePin(pin.number, direction, pin.pinFunction, LPC24_Gpio_PinMode::Inactive);
+
+    return TinyCLR_Result::Success;
+}
+
+static void LPC24_OnePulse_ClosePin(int32_t controller, int32_t index) {
+    auto& pin = g_LPC24_OnePulse_Pins[controller][index];
+
+    LPC24_Gpio_ConfigurePin(pin.number, LPC24_Gpio_Direction::Input, LPC24_Gpio_PinFunction::PinFunction0, LPC24_Gpio_PinMode::Inactive);
+    LPC24_Gpio_ClosePin(pin.number);
+}
+
+// invert makes the pulse low on an idle high output
+TinyCLR_Result LPC24_OnePulse_Acquire(int32_t controller, LPC24_OnePulse_Trigger trigger, bool invert) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(controller);
+    auto& state = g_LPC24_OnePulse_Controller[controller];
+
+    if (state.acquired || ((LPC24XX::SYSCON().PCONP & LPC24_OnePulse_GetPower(controller)) && (TIMER.TCR & LPC24XX_TIMER::TCR_TEN))) // timer used by the DAC, the counter or the system timer
+        return TinyCLR_Result::SharingViolation;
+
+    auto result = LPC24_OnePulse_OpenPin(controller, LPC24_ONEPULSE_OUTPUT_PIN, LPC24_Gpio_Direction::Output);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    if (trigger != LPC24_OnePulse_Trigger::Software) {
+        result = LPC24_OnePulse_OpenPin(controller, LPC24_ONEPULSE_TRIGGER_PIN, LPC24_Gpio_Direction::Input);
+
+        if (result != TinyCLR_Result::Success) {
+            LPC24_OnePulse_ClosePin(controller, LPC24_ONEPULSE_OUTPUT_PIN);
+
+            return result;
+        }
+    }
+
+    state.acquired = true;
+    state.configured = false;
+    state.invert = invert;
+    state.trigger = trigger;
+    state.phase = LPC24_OnePulse_Phase::Idle;
+
+    LPC24XX::SYSCON().PCONP |= LPC24_OnePulse_GetPower(controller);
+
+    TIMER.TCR = 0x2; // hold in reset
+    TIMER.CTCR = 0; // timer mode
+    TIMER.PR = 0;
+    TIMER.MCR = 0;
+    TIMER.EMR = invert ? LPC24_ONEPULSE_EMR_EM0 : 0; // idle level
+    TIMER.CCR = 0;
+    TIMER.IR = 0xFFFFFFFF;
+
+    if (trigger != LPC24_OnePulse_Trigger::Software)
+        TIMER.CCR = (trigger == LPC24_OnePulse_Trigger::FallingEdge ? LPC24_ONEPULSE_CCR_FE : LPC24_ONEPULSE_CCR_RE) | LPC24_ONEPULSE_CCR_I;
+
+    LPC24_Interrupt_Activate(LPC24XX_TIMER::getIntNo(controller), (uint32_t*)&LPC24_OnePulse_InterruptHandler, (void*)controller);
+
+    TIMER.TCR = LPC24XX_TIMER::TCR_TEN; // free running, pulses are scheduled relative to TC
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC24_OnePulse_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(controller);
+    auto& state = g_LPC24_OnePulse_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    TIMER.TCR = 0;
+    TIMER.MCR = 0;
+    TIMER.CCR = 0;
+    TIMER.EMR = 0;
+    TIMER.IR = 0xFFFFFFFF;
+
+    LPC24_Interrupt_Deactivate(LPC24XX_TIMER::getIntNo(controller));
+
+    LPC24XX::SYSCON().PCONP &= ~LPC24_OnePulse_GetPower(controller);
+
+    LPC24_OnePulse_ClosePin(controller, LPC24_ONEPULSE_OUTPUT_PIN);
+
+    if (state.trigger != LPC24_OnePulse_Trigger::Software)
+        LPC24_OnePulse_ClosePin(controller, LPC24_ONEPULSE_TRIGGER_PIN);
+
+    state.acquired = false;
+
+    return TinyCLR_Result::Success;
+}
+
+// delay is from the trigger to the pulse start, both must be at least 5us
+TinyCLR_Result LPC24_OnePulse_SetPulse(int32_t controller, uint32_t delayNanoseconds, uint32_t widthNanoseconds) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC24_OnePulse_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    uint64_t delay = ((uint64_t)delayNanoseconds * LPC24_ONEPULSE_TIMER_CLOCK_HZ) / 1000000000;
+    uint64_t width = ((uint64_t)widthNanoseconds * LPC24_ONEPULSE_TIMER_CLOCK_HZ) / 1000000000;
+
+    if (delay < LPC24_ONEPULSE_MIN_TICKS || width < LPC24_ONEPULSE_MIN_TICKS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (state.phase != LPC24_OnePulse_Phase::Idle)
+        return TinyCLR_Result::Busy;
+
+    state.delay = delay;
+    state.width = width;
+    state.configured = true;
+
+    return TinyCLR_Result::Success;
+}
+
+// starts the pulse now, edge triggered controllers start on each edge by themselves
+TinyCLR_Result LPC24_OnePulse_Fire(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC24_OnePulse_Controller[controller];
+
+    if (!state.acquired || !state.configured)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (state.phase != LPC24_OnePulse_Phase::Idle)
+        return TinyCLR_Result::Busy;
+
+    LPC24XX_TIMER& TIMER = LPC24XX::TIMER(controller);
+
+    LPC24_OnePulse_Start(TIMER, state, TIMER.TC);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC24_OnePulse_IsBusy(int32_t controller, bool& busy) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_LPC24_OnePulse_Controller[controller];
+
+    if (!state.acquired)
+        return TinyCLR_Result::InvalidOperation;
+
+    busy = state.phase != LPC24_OnePulse_Phase::Idle;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
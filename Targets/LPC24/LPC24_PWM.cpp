@@ -122,7 +122,8 @@ TinyCLR_Result LPC24_Pwm_AcquirePin(const TinyCLR_Pwm_Provider* self, int32_t pi
         PWM0TCR |= (1 << 1);
         *g_PwmController[self->Index].matchAddress[pin] = 0;
         PWM0MCR = (1 << 1); // Reset on MAT0
-        PWM0TCR = 1; // Enable
+        PWM0TCR = (1 << 0) | (1 << 3); // Enable, PWM mode so match registers are shadowed until latched
+        PWM0LER |= (1 << (g_PwmController[self->Index].match[pin] + 1));
         PWM0PCR |= (1 << (9 + g_PwmController[self->Index].match[pin])); // To enable output on the proper channel
     }
     else if (g_PwmController[self->Index].channel[pin] == 1) {
@@ -134,7 +135,8 @@ TinyCLR_Result LPC24_Pwm_AcquirePin(const TinyCLR_Pwm_Provider* self, int32_t pi
         PWM1TCR |= (1 << 1);
         *g_PwmController[self->Index].matchAddress[pin] = 0;
         PWM1MCR = (1 << 1); // Reset on MAT0
-        PWM1TCR = 1; // Enable
+        PWM1TCR = (1 << 0) | (1 << 3); // Enable, PWM mode so match registers are shadowed until latched
+        PWM1LER |= (1 << (g_PwmController[self->Index].match[pin] + 1));
         PWM1PCR |= (1 << (9 + (g_PwmController[self->Index].match[pin]))); // To enable output on the proper channel
     }
 
@@ -248,108 +250,69 @@ double LPC24_Pwm_GetMinFrequency(const TinyCLR_Pwm_Provider* self) {
     return LPC24_MIN_PWM_FREQUENCY;
 }
 
-TinyCLR_Result LPC24_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity) {
-
+static uint32_t LPC24_Pwm_GetPeriodTicks(double frequency) {
     uint32_t period = 0;
-    uint32_t duration = 0;
     uint32_t scale = 0;
 
-    uint32_t periodInNanoSeconds = 0;
-    uint32_t durationInNanoSeconds = 0;
-
-    double frequency = g_PwmController[self->Index].frequency;
+    if (frequency <= 0.0)
+        return 0;
 
     LPC24_Pwm_GetScaleFactor(frequency, period, scale);
 
-    duration = (uint32_t)(dutyCycle * period);
-
-    // Work on actual period and duration after update.
-    // Repeat calculation again to genarate periodTicks and highTicks. G120 convert from period and duration to ticks.
-    switch (scale) {
-    case PWM_MILLISECONDS:
-        periodInNanoSeconds = (period * 1000000);
-        durationInNanoSeconds = (duration * 1000000);
-        break;
-
-    case PWM_MICROSECONDS:
-        periodInNanoSeconds = (period * 1000);
-        durationInNanoSeconds = (duration * 1000);
-        break;
-
-    case PWM_NANOSECONDS:
-        periodInNanoSeconds = period;
-        durationInNanoSeconds = duration;
-        break;
-
-    default:
-        return TinyCLR_Result::InvalidOperation;
-    }
+    uint32_t periodInNanoSeconds = period * (PWM_NANOSECONDS / scale);
 
     // 18M/M = 18 * period / 1000 to get legal value.
     uint32_t periodTicks = (uint64_t)((SYSTEM_CLOCK_HZ / 1000000)) * periodInNanoSeconds / 1000;
-    uint32_t highTicks = (uint64_t)((SYSTEM_CLOCK_HZ / 1000000)) * durationInNanoSeconds / 1000;
 
     // A strange instance where if the periodInNanoSeconds would have ended in infinite 3 (calculated with float in NETMF), periodTicks are not computed correctly
     if (0 == ((periodInNanoSeconds - 3) % 10))
         periodTicks += 1;
 
-    if (0 == ((highTicks - 3) % 10))
-        highTicks += 1;
-
-    periodTicks -= 1;
-    highTicks -= 1;
-
-    if ((int)periodTicks < 0)
-        periodTicks = 0;
+    return periodTicks;
+}
 
-    if ((int)highTicks < 0)
-        highTicks = 0;
+// Writes the shadowed match registers, returns the latch enable bits needed to apply them
+static uint32_t LPC24_Pwm_StageChannel(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity) {
+    uint32_t periodTicks = g_PwmController[self->Index].periodTicks;
+    uint32_t latch = 0;
 
-    if (highTicks > periodTicks)
-        highTicks = periodTicks;
+    if (dutyCycle > LPC24_PWM_DUTY_CYCLE_FULL)
+        dutyCycle = LPC24_PWM_DUTY_CYCLE_FULL;
 
-    if (invertPolarity)
-        highTicks = periodTicks - highTicks;
+    uint32_t highTicks = (uint32_t)(((uint64_t)dutyCycle * periodTicks) >> 16);
 
-    if (period == 0 || duration == 0) {
+    if (periodTicks == 0 || highTicks == 0) {
         LPC24_Gpio_EnableOutputPin(g_PwmController[self->Index].gpioPin[pin].number, false);
         g_PwmController[self->Index].outputEnabled[pin] = true;
-
-        return TinyCLR_Result::Success;
     }
-    else if (duration >= period) {
+    else if (highTicks >= periodTicks) {
         LPC24_Gpio_EnableOutputPin(g_PwmController[self->Index].gpioPin[pin].number, true);
         g_PwmController[self->Index].outputEnabled[pin] = true;
-
-        return TinyCLR_Result::Success;
     }
     else {
+        periodTicks -= 1;
+        highTicks -= 1;
+
+        if (invertPolarity)
+            highTicks = periodTicks - highTicks;
+
+        // Re-scale with new frequency! Takes effect at the end of the current period.
         if (g_PwmController[self->Index].channel[pin] == 0) {
-            // Re-scale with new frequency!
             if ((PWM0MR0 != periodTicks)) {
-
-                // Reset Timer Counter
-                PWM0TCR |= (1 << 1);
                 PWM0MR0 = periodTicks;
-                PWM0MCR = (1 << 1); // Reset on MAT0
-                PWM0TCR = 1; // Enable
+                latch |= (1 << 0);
             }
-
-            *g_PwmController[self->Index].matchAddress[pin] = highTicks;
         }
         else if (g_PwmController[self->Index].channel[pin] == 1) {
-            // Re-scale with new frequency!
             if ((PWM1MR0 != periodTicks)) {
-                // Reset Timer Counter
-                PWM1TCR |= (1 << 1);
                 PWM1MR0 = periodTicks;
-                PWM1MCR = (1 << 1); // Reset on MAT0
-                PWM1TCR = 1; // Enable
+                latch |= (1 << 0);
             }
-
-            *g_PwmController[self->Index].matchAddress[pin] = highTicks;
         }
 
+        *g_PwmController[self->Index].matchAddress[pin] = highTicks;
+        latch |= (1 << (g_PwmController[self->Index].match[pin] + 1));
+
         if (g_PwmController[self->Index].outputEnabled[pin] == true) {
             LPC24_Pwm_EnablePin(self, pin);
 
@@ -360,22 +323,77 @@ TinyCLR_Result LPC24_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, in
     g_PwmController[self->Index].invert[pin] = invertPolarity;
     g_PwmController[self->Index].dutyCycle[pin] = dutyCycle;
 
+    return latch;
+}
+
+static void LPC24_Pwm_Latch(const TinyCLR_Pwm_Provider* self, uint32_t latch) {
+    // Shadow registers move to the match registers together on the next MR0 match
+    if (self->Index == 0)
+        PWM0LER |= latch;
+    else
+        PWM1LER |= latch;
+}
+
+TinyCLR_Result LPC24_Pwm_SetPulseParametersFixed(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity) {
+    LPC24_Pwm_Latch(self, LPC24_Pwm_StageChannel(self, pin, dutyCycle, invertPolarity));
+
     return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC24_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Provider* self, const int32_t* pins, const uint32_t* dutyCycles, const bool* invertPolarity, size_t count) {
+    uint32_t latch = 0;
+
+    if (pins == nullptr || dutyCycles == nullptr || invertPolarity == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    for (size_t i = 0; i < count; i++)
+        if (pins[i] < 0 || pins[i] >= MAX_PWM_PER_CONTROLLER || g_PwmController[self->Index].gpioPin[pins[i]].number == PIN_NONE)
+            return TinyCLR_Result::ArgumentOutOfRange;
 
+    for (size_t i = 0; i < count; i++)
+        latch |= LPC24_Pwm_StageChannel(self, pins[i], dutyCycles[i], invertPolarity[i]);
+
+    LPC24_Pwm_Latch(self, latch);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC24_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity) {
+    uint32_t fixed = 0;
+
+    if (dutyCycle >= 1.0)
+        fixed = LPC24_PWM_DUTY_CYCLE_FULL;
+    else if (dutyCycle > 0.0)
+        fixed = (uint32_t)(dutyCycle * LPC24_PWM_DUTY_CYCLE_FULL + 0.5);
+
+    return LPC24_Pwm_SetPulseParametersFixed(self, pin, fixed, invertPolarity);
 }
 
 TinyCLR_Result LPC24_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Provider* self, double& frequency) {
     g_PwmController[self->Index].frequency = frequency;
+    g_PwmController[self->Index].periodTicks = LPC24_Pwm_GetPeriodTicks(frequency);
 
     // Calculate actual frequency
     frequency = LPC24_Pwm_GetActualFrequency(self);
 
 
-    for (int p = 0; p < MAX_PWM_PER_CONTROLLER; p++)
-        if (g_PwmController[self->Index].gpioPin[p].number != PIN_NONE)
-            if (LPC24_Pwm_SetPulseParameters(self, p, g_PwmController[self->Index].dutyCycle[p], g_PwmController[self->Index].invert[p]) != TinyCLR_Result::Success)
-                return TinyCLR_Result::InvalidOperation;
+    // Re-apply all channels, new period and duty cycles are latched together
+    int32_t pins[MAX_PWM_PER_CONTROLLER];
+    uint32_t dutyCycles[MAX_PWM_PER_CONTROLLER];
+    bool invert[MAX_PWM_PER_CONTROLLER];
+    size_t count = 0;
+
+    for (int p = 0; p < MAX_PWM_PER_CONTROLLER; p++) {
+        if (g_PwmController[self->Index].gpioPin[p].number != PIN_NONE) {
+            pins[count] = p;
+            dutyCycles[count] = g_PwmController[self->Index].dutyCycle[p];
+            invert[count] = g_PwmController[self->Index].invert[p];
+            count++;
+        }
+    }
 
+    if (LPC24_Pwm_SetPulseParametersBatch(self, pins, dutyCycles, invert, count) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
 
     return TinyCLR_Result::Success;
 }
@@ -427,7 +445,8 @@ void LPC24_Pwm_ResetController(int32_t controller) {
             g_PwmController[pwmProviders[controller]->Index].outputEnabled[p] = false;
             g_PwmController[pwmProviders[controller]->Index].invert[p] = false;
             g_PwmController[pwmProviders[controller]->Index].frequency = 0.0;
-            g_PwmController[pwmProviders[controller]->Index].dutyCycle[p] = 0.0;
+            g_PwmController[pwmProviders[controller]->Index].periodTicks = 0;
+            g_PwmController[pwmProviders[controller]->Index].dutyCycle[p] = 0;
         }
     }
 }
@@ -17,6 +17,7 @@
 
 #define CORTEXM_SLEEP_USEC_FIXED_OVERHEAD_CLOCKS 3
 #define  LPC24_TIME_OVERFLOW_FLAG 0x80000000
+#define TIMER_IDLE_VALUE 0x0000FFFFFFFFFFFFull
 
 
 #define CLOCK_COMMON_FACTOR                  1000000 // GCD(SYSTEM_CLOCK_HZ, 1M)
@@ -31,7 +32,7 @@
 struct LPC24_Timer_Controller {
     bool m_configured;
 
-    uint64_t m_lastRead;
+    volatile uint64_t m_lastRead; // written by the interrupt, which also runs on every half lap
     uint64_t m_nextCompare;
 
     TinyCLR_Time_TickCallback m_DequeuAndExecute;
@@ -145,6 +146,9 @@ uint32_t __section("SectionForFlashOperations") LPC24_Timer_Controller::ReadCoun
 #pragma arm section code
 //--//
 
+static void LPC24_Time_ScheduleCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks);
+static void LPC24_Time_Dispatch(const TinyCLR_Time_Provider* self);
+
 void LPC24_Time_InterruptHandler(void* Param) {
     TinyCLR_Time_Provider *provider = (TinyCLR_Time_Provider*)Param;
 
@@ -161,14 +165,14 @@ void LPC24_Time_InterruptHandler(void* Param) {
 
     if (g_LPC24_Timer_Controller.m_lastRead >= g_LPC24_Timer_Controller.m_nextCompare) {
         // this also schedules the next one, if there is one
-        g_LPC24_Timer_Controller.m_DequeuAndExecute();
+        LPC24_Time_Dispatch(provider);
     }
     else {
         //
         // Because we are limited in the resolution of timer,
         // resetting the compare will properly configure the next interrupt.
         //
-        LPC24_Time_SetCompare(provider, g_LPC24_Timer_Controller.m_nextCompare);
+        LPC24_Time_ScheduleCompare(provider, g_LPC24_Timer_Controller.m_nextCompare);
     }
 }
 
@@ -247,7 +251,12 @@ uint64_t LPC24_Time_GetCurrentTicks(const TinyCLR_Time_Provider* self) {
     if (self != nullptr)
         timer = self->Index;
 
-    uint64_t lastValue = g_LPC24_Timer_Controller.m_lastRead;
+    uint64_t lastValue;
+
+    // the interrupt can update the snapshot between its two halves, read it again until it is stable
+    do {
+        lastValue = g_LPC24_Timer_Controller.m_lastRead;
+    } while (lastValue != g_LPC24_Timer_Controller.m_lastRead);
 
     uint32_t value = LPC24_Timer_Controller::ReadCounter(timer);
 
@@ -263,7 +272,8 @@ uint64_t LPC24_Time_GetCurrentTicks(const TinyCLR_Time_Provider* self) {
     return (uint64_t)resHigh << 32 | value;
 }
 
-TinyCLR_Result LPC24_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
+// programs the hardware compare, a passed processorTicks forces the interrupt
+static void LPC24_Time_ScheduleCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
     int32_t timer = 0;
 
     if (self != nullptr)
@@ -327,6 +337,173 @@ TinyCLR_Result LPC24_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t
         // Force interrupt to process this.
         LPC24_Timer_Controller::ForceInterrupt(timer);
     }
+}
+
+//******************** Timer service ********************
+
+// native timers share the hardware compare with the runtime: a min heap on the deadline keeps the earliest
+// timer at the top, and the compare is set to the earlier of it and the runtime event
+#define LPC24_Time_MaxTimers 32
+
+static LPC24_Time_Timer* g_LPC24_Time_Timers[LPC24_Time_MaxTimers];
+static int32_t g_LPC24_Time_TimerCount;
+
+static uint64_t g_runtimeEvent = TIMER_IDLE_VALUE; // next event asked for by the runtime
+
+static void LPC24_Time_TimerSwap(int32_t a, int32_t b) {
+    auto timer = g_LPC24_Time_Timers[a];
+
+    g_LPC24_Time_Timers[a] = g_LPC24_Time_Timers[b];
+    g_LPC24_Time_Timers[b] = timer;
+
+    g_LPC24_Time_Timers[a]->index = a;
+    g_LPC24_Time_Timers[b]->index = b;
+}
+
+static void LPC24_Time_TimerSiftUp(int32_t index) {
+    while (index > 0 && g_LPC24_Time_Timers[(index - 1) / 2]->deadline > g_LPC24_Time_Timers[index]->deadline) {
+        LPC24_Time_TimerSwap(index, (index - 1) / 2);
+
+        index = (index - 1) / 2;
+    }
+}
+
+static void LPC24_Time_TimerSiftDown(int32_t index) {
+    while (true) {
+        auto smallest = index;
+        auto left = index * 2 + 1;
+        auto right = index * 2 + 2;
+
+        if (left < g_LPC24_Time_TimerCount && g_LPC24_Time_Timers[left]->deadline < g_LPC24_Time_Timers[smallest]->deadline)
+            smallest = left;
+
+        if (right < g_LPC24_Time_TimerCount && g_LPC24_Time_Timers[right]->deadline < g_LPC24_Time_Timers[smallest]->deadline)
+            smallest = right;
+
+        if (smallest == index)
+            return;
+
+        LPC24_Time_TimerSwap(index, smallest);
+
+        index = smallest;
+    }
+}
+
+static bool LPC24_Time_TimerIsActive(LPC24_Time_Timer* timer) {
+    return timer->index >= 0 && timer->index < g_LPC24_Time_TimerCount && g_LPC24_Time_Timers[timer->index] == timer;
+}
+
+static void LPC24_Time_TimerInsert(LPC24_Time_Timer* timer) {
+    timer->index = g_LPC24_Time_TimerCount++;
+
+    g_LPC24_Time_Timers[timer->index] = timer;
+
+    LPC24_Time_TimerSiftUp(timer->index);
+}
+
+static void LPC24_Time_TimerRemove(LPC24_Time_Timer* timer) {
+    auto index = timer->index;
+
+    timer->index = -1;
+
+    if (index == --g_LPC24_Time_TimerCount)
+        return;
+
+    g_LPC24_Time_Timers[index] = g_LPC24_Time_Timers[g_LPC24_Time_TimerCount];
+    g_LPC24_Time_Timers[index]->index = index;
+
+    LPC24_Time_TimerSiftDown(index);
+    LPC24_Time_TimerSiftUp(index);
+}
+
+static uint64_t LPC24_Time_GetNextCompare() {
+    if (g_LPC24_Time_TimerCount > 0 && g_LPC24_Time_Timers[0]->deadline < g_runtimeEvent)
+        return g_LPC24_Time_Timers[0]->deadline;
+
+    return g_runtimeEvent;
+}
+
+// runs the timers that are due, a periodic timer is queued again before its callback so the callback can stop it
+static void LPC24_Time_ExecuteTimers(const TinyCLR_Time_Provider* self) {
+    auto now = LPC24_Time_GetCurrentTicks(self);
+
+    while (g_LPC24_Time_TimerCount > 0 && g_LPC24_Time_Timers[0]->deadline <= now) {
+        auto timer = g_LPC24_Time_Timers[0];
+
+        LPC24_Time_TimerRemove(timer);
+
+        if (timer->period != 0) {
+            timer->deadline += timer->period;
+
+            if (timer->deadline <= now) // missed periods are skipped, not run in a burst
+                timer->deadline = now + timer->period;
+
+            LPC24_Time_TimerInsert(timer);
+        }
+
+        timer->callback(timer->param);
+    }
+}
+
+static void LPC24_Time_Dispatch(const TinyCLR_Time_Provider* self) {
+    LPC24_Time_ExecuteTimers(self);
+
+    if (LPC24_Time_GetCurrentTicks(self) >= g_runtimeEvent) {
+        g_runtimeEvent = TIMER_IDLE_VALUE;
+
+        g_LPC24_Timer_Controller.m_DequeuAndExecute(); // schedules the next runtime event, if there is one
+    }
+
+    LPC24_Time_ScheduleCompare(self, LPC24_Time_GetNextCompare());
+}
+
+// timeout and period are in microseconds, a period of 0 makes a one shot timer. The callback runs in interrupt
+// context with interrupts disabled. The timer is owned by the caller and must stay valid while it is started.
+TinyCLR_Result LPC24_Time_StartTimer(const TinyCLR_Time_Provider* self, LPC24_Time_Timer* timer, uint64_t timeout, uint64_t period) {
+    if (timer == nullptr || timer->callback == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (LPC24_Time_TimerIsActive(timer))
+        LPC24_Time_TimerRemove(timer);
+
+    if (g_LPC24_Time_TimerCount == LPC24_Time_MaxTimers)
+        return TinyCLR_Result::NotAvailable;
+
+    timer->deadline = LPC24_Time_GetCurrentTicks(self) + LPC24_Time_MicrosecondsToTicks(self, timeout);
+    timer->period = LPC24_Time_MicrosecondsToTicks(self, period);
+
+    if (period != 0 && timer->period == 0)
+        timer->period = 1;
+
+    LPC24_Time_TimerInsert(timer);
+
+    if (timer->index == 0)
+        LPC24_Time_ScheduleCompare(self, LPC24_Time_GetNextCompare());
+
+    return TinyCLR_Result::Success;
+}
+
+// a stopped timer can leave one early compare interrupt behind, which finds nothing to run
+TinyCLR_Result LPC24_Time_StopTimer(const TinyCLR_Time_Provider* self, LPC24_Time_Timer* timer) {
+    if (timer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (LPC24_Time_TimerIsActive(timer))
+        LPC24_Time_TimerRemove(timer);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result LPC24_Time_SetCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    g_runtimeEvent = processorTicks;
+
+    LPC24_Time_ScheduleCompare(self, LPC24_Time_GetNextCompare());
 
     return TinyCLR_Result::Success;
 }
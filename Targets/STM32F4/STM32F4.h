@@ -59,6 +59,7 @@ TinyCLR_Result STM32F4_Power_Acquire(const TinyCLR_Power_Provider* self);
 TinyCLR_Result STM32F4_Power_Release(const TinyCLR_Power_Provider* self);
 void STM32F4_Power_Reset(const TinyCLR_Power_Provider* self, bool runCoreAfter);
 void STM32F4_Power_Sleep(const TinyCLR_Power_Provider* self, TinyCLR_Power_Sleep_Level level);
+TinyCLR_Result STM32F4_Power_SetTicklessIdle(const TinyCLR_Power_Provider* self, bool enabled);
 
 ////////////////////////////////////////////////////////////////////////////////
 //Time
@@ -74,6 +75,23 @@ TinyCLR_Result STM32F4_Time_SetTickCallback(const TinyCLR_Time_Provider* self, T
 TinyCLR_Result STM32F4_Time_SetNextTickCallbackTime(const TinyCLR_Time_Provider* self, uint64_t processorTicks);
 void STM32F4_Time_Delay(const TinyCLR_Time_Provider* self, uint64_t microseconds);
 void STM32F4_Time_DelayNoInterrupt(const TinyCLR_Time_Provider* self, uint64_t microseconds);
+uint64_t STM32F4_Time_GetNextEventTicks(const TinyCLR_Time_Provider* self);
+void STM32F4_Time_SetProcessorTicks(const TinyCLR_Time_Provider* self, uint64_t ticks);
+uint32_t STM32F4_Time_MeasureLsiClock(const TinyCLR_Time_Provider* self);
+
+typedef void(*STM32F4_Time_TimerCallback)(void* param);
+
+struct STM32F4_Time_Timer {
+    STM32F4_Time_TimerCallback callback;
+    void* param;
+
+    uint64_t deadline; // processor ticks
+    uint64_t period; // processor ticks, 0 for one shot
+    int32_t index; // position in the timer heap
+};
+
+TinyCLR_Result STM32F4_Time_StartTimer(const TinyCLR_Time_Provider* self, STM32F4_Time_Timer* timer, uint64_t timeout, uint64_t period);
+TinyCLR_Result STM32F4_Time_StopTimer(const TinyCLR_Time_Provider* self, STM32F4_Time_Timer* timer);
 
 ////////////////////////////////////////////////////////////////////////////////
 //Startup
@@ -86,6 +104,13 @@ void STM32F4_Startup_GetRunApp(bool& runApp);
 ////////////////////////////////////////////////////////////////////////////////
 //ADC
 ////////////////////////////////////////////////////////////////////////////////
+enum class STM32F4_Adc_FilterMode : uint8_t {
+    None = 0,
+    Average = 1, // parameter: samples per reading
+    Oversample = 2, // parameter: extra bits, 4^bits samples per reading, rounded back to 12 bits
+    Iir = 3, // parameter: shift, y += (x - y) / 2^shift
+};
+
 const TinyCLR_Api_Info* STM32F4_Adc_GetApi();
 TinyCLR_Result STM32F4_Adc_Acquire(const TinyCLR_Adc_Provider* self);
 TinyCLR_Result STM32F4_Adc_Release(const TinyCLR_Adc_Provider* self);
@@ -99,10 +124,22 @@ int32_t STM32F4_Adc_GetMinValue(const TinyCLR_Adc_Provider* self);
 int32_t STM32F4_Adc_GetMaxValue(const TinyCLR_Adc_Provider* self);
 int32_t STM32F4_Adc_GetResolutionInBits(const TinyCLR_Adc_Provider* self);
 int32_t STM32F4_Adc_GetChannelCount(const TinyCLR_Adc_Provider* self);
+TinyCLR_Result STM32F4_Adc_SetFilter(const TinyCLR_Adc_Provider* self, int32_t channel, STM32F4_Adc_FilterMode mode, uint32_t parameter);
+TinyCLR_Result STM32F4_Adc_ReadChannels(const TinyCLR_Adc_Provider* self, const int32_t* channels, int32_t* values, size_t count);
+TinyCLR_Result STM32F4_Adc_ReadInterleaved(const TinyCLR_Adc_Provider* self, int32_t channel, int32_t adcCount, uint16_t* buffer, size_t& length);
+int32_t STM32F4_Adc_GetInterleavedSampleRate(const TinyCLR_Adc_Provider* self, int32_t adcCount);
 
 ////////////////////////////////////////////////////////////////////////////////
 //DAC
 ////////////////////////////////////////////////////////////////////////////////
+enum class STM32F4_Dac_PlaybackEvent : uint8_t {
+    HalfTransfer = 0,
+    TransferComplete = 1,
+    Error = 2,
+};
+
+typedef void(*STM32F4_Dac_PlaybackHandler)(int32_t channel, STM32F4_Dac_PlaybackEvent event);
+
 const TinyCLR_Api_Info* STM32F4_Dac_GetApi();
 TinyCLR_Result STM32F4_Dac_Acquire(const TinyCLR_Dac_Provider* self);
 TinyCLR_Result STM32F4_Dac_Release(const TinyCLR_Dac_Provider* self);
@@ -113,6 +150,10 @@ int32_t STM32F4_Dac_GetMinValue(const TinyCLR_Dac_Provider* self);
 int32_t STM32F4_Dac_GetMaxValue(const TinyCLR_Dac_Provider* self);
 int32_t STM32F4_Dac_GetResolutionInBits(const TinyCLR_Dac_Provider* self);
 int32_t STM32F4_Dac_GetChannelCount(const TinyCLR_Dac_Provider* self);
+TinyCLR_Result STM32F4_Dac_StartPlayback(const TinyCLR_Dac_Provider* self, int32_t channel, const uint16_t* buffer, size_t length, uint32_t& sampleRate, bool circular, STM32F4_Dac_PlaybackHandler handler);
+TinyCLR_Result STM32F4_Dac_WriteDualValue(const TinyCLR_Dac_Provider* self, int32_t value1, int32_t value2);
+TinyCLR_Result STM32F4_Dac_StartDualPlayback(const TinyCLR_Dac_Provider* self, const uint32_t* buffer, size_t length, uint32_t& sampleRate, bool circular, STM32F4_Dac_PlaybackHandler handler);
+TinyCLR_Result STM32F4_Dac_StopPlayback(const TinyCLR_Dac_Provider* self, int32_t channel);
 
 ////////////////////////////////////////////////////////////////////////////////
 //GPIO
@@ -124,6 +165,41 @@ TinyCLR_Result STM32F4_Gpio_AcquirePin(const TinyCLR_Gpio_Provider* self, int32_
 TinyCLR_Result STM32F4_Gpio_ReleasePin(const TinyCLR_Gpio_Provider* self, int32_t pin);
 TinyCLR_Result STM32F4_Gpio_Read(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& value);
 TinyCLR_Result STM32F4_Gpio_Write(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue value);
+TinyCLR_Result STM32F4_Gpio_ReadPort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t& value);
+TinyCLR_Result STM32F4_Gpio_WritePort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t mask, uint32_t value);
+
+struct STM32F4_Gpio_Event {
+    int32_t pin;
+    TinyCLR_Gpio_PinValue value;
+    uint64_t ticks; // processor ticks at the edge
+};
+
+TinyCLR_Result STM32F4_Gpio_SetEventQueueEnabled(const TinyCLR_Gpio_Provider* self, int32_t pin, bool enabled);
+TinyCLR_Result STM32F4_Gpio_ReadEvents(const TinyCLR_Gpio_Provider* self, STM32F4_Gpio_Event* events, size_t& count);
+TinyCLR_Result STM32F4_Gpio_DispatchEvents(const TinyCLR_Gpio_Provider* self);
+uint32_t STM32F4_Gpio_GetLostEventCount(const TinyCLR_Gpio_Provider* self);
+
+struct STM32F4_Gpio_WaveformStep {
+    TinyCLR_Gpio_PinValue value;
+    uint32_t duration; // nanoseconds
+};
+
+TinyCLR_Result STM32F4_Gpio_WriteWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, const STM32F4_Gpio_WaveformStep* steps, size_t count);
+TinyCLR_Result STM32F4_Gpio_CaptureWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& initialValue, uint32_t* durations, size_t& count, uint32_t timeout);
+
+// bit-band alias words of one pin, the macros below are a single load or store without validation
+struct STM32F4_Gpio_FastPin {
+    volatile uint32_t* input;
+    volatile uint32_t* output;
+    volatile uint32_t* set;
+    volatile uint32_t* clear;
+};
+
+TinyCLR_Result STM32F4_Gpio_GetFastPin(const TinyCLR_Gpio_Provider* self, int32_t pin, STM32F4_Gpio_FastPin& fastPin);
+
+#define STM32F4_Gpio_FastRead(fastPin) (*(fastPin).input != 0)
+#define STM32F4_Gpio_FastWrite(fastPin, value) (*((value) ? (fastPin).set : (fastPin).clear) = 1)
+#define STM32F4_Gpio_FastToggle(fastPin) (*(*(fastPin).output ? (fastPin).clear : (fastPin).set) = 1)
 bool STM32F4_Gpio_IsDriveModeSupported(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinDriveMode mode);
 TinyCLR_Gpio_PinDriveMode STM32F4_Gpio_GetDriveMode(const TinyCLR_Gpio_Provider* self, int32_t pin);
 TinyCLR_Result STM32F4_Gpio_SetDriveMode(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinDriveMode mode);
@@ -146,6 +222,16 @@ TinyCLR_Result STM32F4_I2c_WriteRead(const TinyCLR_I2c_Provider* self, const uin
 ////////////////////////////////////////////////////////////////////////////////
 //PWM
 ////////////////////////////////////////////////////////////////////////////////
+#define STM32F4_PWM_DUTY_CYCLE_FULL 0x10000 // 1.0 in Q16
+
+enum class STM32F4_Pwm_SequenceEvent : uint8_t {
+    HalfTransfer,
+    TransferComplete,
+    Error
+};
+
+typedef void(*STM32F4_Pwm_SequenceHandler)(int32_t controller, STM32F4_Pwm_SequenceEvent event);
+
 const TinyCLR_Api_Info* STM32F4_Pwm_GetApi();
 TinyCLR_Result STM32F4_Pwm_Acquire(const TinyCLR_Pwm_Provider* self);
 TinyCLR_Result STM32F4_Pwm_Release(const TinyCLR_Pwm_Provider* self);
@@ -154,12 +240,95 @@ TinyCLR_Result STM32F4_Pwm_ReleasePin(const TinyCLR_Pwm_Provider* self, int32_t
 TinyCLR_Result STM32F4_Pwm_EnablePin(const TinyCLR_Pwm_Provider* self, int32_t pin);
 TinyCLR_Result STM32F4_Pwm_DisablePin(const TinyCLR_Pwm_Provider* self, int32_t pin);
 TinyCLR_Result STM32F4_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity);
+TinyCLR_Result STM32F4_Pwm_SetPulseParametersFixed(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity);
+TinyCLR_Result STM32F4_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Provider* self, const int32_t* pins, const uint32_t* dutyCycles, const bool* invertPolarity, size_t count);
+uint32_t STM32F4_Pwm_GetPeriodTicks(const TinyCLR_Pwm_Provider* self);
+TinyCLR_Result STM32F4_Pwm_StartSequence(const TinyCLR_Pwm_Provider* self, int32_t pin, const uint16_t* compareValues, size_t length, bool circular, STM32F4_Pwm_SequenceHandler handler);
+TinyCLR_Result STM32F4_Pwm_StopSequence(const TinyCLR_Pwm_Provider* self);
 TinyCLR_Result STM32F4_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Provider* self, double& frequency);
 double STM32F4_Pwm_GetMinFrequency(const TinyCLR_Pwm_Provider* self);
 double STM32F4_Pwm_GetMaxFrequency(const TinyCLR_Pwm_Provider* self);
 double STM32F4_Pwm_GetActualFrequency(const TinyCLR_Pwm_Provider* self);
 int32_t STM32F4_Pwm_GetPinCount(const TinyCLR_Pwm_Provider* self);
 
+////////////////////////////////////////////////////////////////////////////////
+//Capture
+////////////////////////////////////////////////////////////////////////////////
+enum class STM32F4_Capture_Edge : uint8_t {
+    Rising,
+    Falling,
+    Both
+};
+
+enum class STM32F4_Capture_BufferEvent : uint8_t {
+    HalfTransfer,
+    TransferComplete,
+    Error
+};
+
+typedef void(*STM32F4_Capture_BufferHandler)(int32_t controller, STM32F4_Capture_BufferEvent event);
+
+TinyCLR_Result STM32F4_Capture_Acquire(int32_t controller, uint32_t& frequency);
+TinyCLR_Result STM32F4_Capture_Release(int32_t controller);
+uint32_t STM32F4_Capture_GetCounterMask(int32_t controller);
+TinyCLR_Result STM32F4_Capture_AcquireChannel(int32_t controller, int32_t channel, STM32F4_Capture_Edge edge);
+TinyCLR_Result STM32F4_Capture_ReleaseChannel(int32_t controller, int32_t channel);
+TinyCLR_Result STM32F4_Capture_ReadTimestamp(int32_t controller, int32_t channel, uint32_t& timestamp, bool& overcapture);
+TinyCLR_Result STM32F4_Capture_StartBuffer(int32_t controller, int32_t channel, uint32_t* timestamps, size_t length, bool circular, STM32F4_Capture_BufferHandler handler);
+TinyCLR_Result STM32F4_Capture_StopBuffer(int32_t controller, size_t& captured);
+TinyCLR_Result STM32F4_Capture_AcquirePulse(int32_t controller, int32_t channel);
+TinyCLR_Result STM32F4_Capture_ReadPulse(int32_t controller, uint32_t& period, uint32_t& highTime);
+
+////////////////////////////////////////////////////////////////////////////////
+//Encoder
+////////////////////////////////////////////////////////////////////////////////
+enum class STM32F4_Encoder_Mode : uint8_t {
+    X2,
+    X4
+};
+
+typedef void(*STM32F4_Encoder_IndexHandler)(int32_t controller, int64_t position);
+
+TinyCLR_Result STM32F4_Encoder_Acquire(int32_t controller, STM32F4_Encoder_Mode mode, bool useIndex);
+TinyCLR_Result STM32F4_Encoder_Release(int32_t controller);
+TinyCLR_Result STM32F4_Encoder_GetPosition(int32_t controller, int64_t& position);
+TinyCLR_Result STM32F4_Encoder_SetPosition(int32_t controller, int64_t position);
+TinyCLR_Result STM32F4_Encoder_GetDirection(int32_t controller, bool& forward);
+TinyCLR_Result STM32F4_Encoder_GetVelocity(int32_t controller, int32_t& countsPerSecond);
+TinyCLR_Result STM32F4_Encoder_SetIndexHandler(int32_t controller, STM32F4_Encoder_IndexHandler handler);
+
+////////////////////////////////////////////////////////////////////////////////
+//Counter
+////////////////////////////////////////////////////////////////////////////////
+enum class STM32F4_Counter_Edge : uint8_t {
+    Rising,
+    Falling,
+    Both
+};
+
+typedef void(*STM32F4_Counter_CompareHandler)(int32_t controller, uint64_t count);
+
+TinyCLR_Result STM32F4_Counter_Acquire(int32_t controller, STM32F4_Counter_Edge edge);
+TinyCLR_Result STM32F4_Counter_Release(int32_t controller);
+TinyCLR_Result STM32F4_Counter_GetCount(int32_t controller, uint64_t& count);
+TinyCLR_Result STM32F4_Counter_ClearCount(int32_t controller);
+TinyCLR_Result STM32F4_Counter_SetCompare(int32_t controller, uint64_t compare, STM32F4_Counter_CompareHandler handler);
+
+////////////////////////////////////////////////////////////////////////////////
+//OnePulse
+////////////////////////////////////////////////////////////////////////////////
+enum class STM32F4_OnePulse_Trigger : uint8_t {
+    Software,
+    RisingEdge,
+    FallingEdge
+};
+
+TinyCLR_Result STM32F4_OnePulse_Acquire(int32_t controller, STM32F4_OnePulse_Trigger trigger, bool invert);
+TinyCLR_Result STM32F4_OnePulse_Release(int32_t controller);
+TinyCLR_Result STM32F4_OnePulse_SetPulse(int32_t controller, uint32_t delayNanoseconds, uint32_t widthNanoseconds);
+TinyCLR_Result STM32F4_OnePulse_Fire(int32_t controller);
+TinyCLR_Result STM32F4_OnePulse_IsBusy(int32_t controller, bool& busy);
+
 ////////////////////////////////////////////////////////////////////////////////
 //SPI
 ////////////////////////////////////////////////////////////////////////////////
@@ -219,6 +388,7 @@ TinyCLR_Result STM32F4_UsbClient_SetOsExtendedPropertyHandler(const TinyCLR_UsbC
 ////////////////////////////////////////////////////////////////////////////////
 //Interrupt Internal
 ////////////////////////////////////////////////////////////////////////////////
+// masks interrupts at or below the kernel priority through BASEPRI, more urgent ones keep running
 class STM32F4_DisableInterrupts_RaiiHelper {
     uint32_t state;
 
@@ -231,6 +401,15 @@ public:
     void Release();
 };
 
+// masks every interrupt through PRIMASK, for WFI paths that must wake on interrupts they keep pending
+class STM32F4_DisableAllInterrupts_RaiiHelper {
+    uint32_t state;
+
+public:
+    STM32F4_DisableAllInterrupts_RaiiHelper();
+    ~STM32F4_DisableAllInterrupts_RaiiHelper();
+};
+
 class STM32F4_InterruptStarted_RaiiHelper {
 public:
     STM32F4_InterruptStarted_RaiiHelper();
@@ -238,10 +417,75 @@ public:
 };
 
 #define DISABLE_INTERRUPTS_SCOPED(name) STM32F4_DisableInterrupts_RaiiHelper name
+#define DISABLE_ALL_INTERRUPTS_SCOPED(name) STM32F4_DisableAllInterrupts_RaiiHelper name
 #define INTERRUPT_STARTED_SCOPED(name) STM32F4_InterruptStarted_RaiiHelper name
 
-bool STM32F4_InterruptInternal_Activate(uint32_t index, uint32_t* isr, void* isrParam);
+// NVIC priorities use the 4 implemented bits, 0 is the most urgent and preempts everything above it
+#define STM32F4_INTERRUPT_PRIORITY_BITS 4
+#define STM32F4_INTERRUPT_PRIORITY_LOWEST ((1 << STM32F4_INTERRUPT_PRIORITY_BITS) - 1)
+
+// critical sections mask this priority and everything less urgent, interrupts above it are zero latency
+// and must not touch runtime or driver state
+#ifndef STM32F4_INTERRUPT_PRIORITY_KERNEL
+#define STM32F4_INTERRUPT_PRIORITY_KERNEL 1
+#endif
+
+// default priority per driver, a board can override any of them in Device.h
+#ifndef STM32F4_INTERRUPT_PRIORITY_TIME
+#define STM32F4_INTERRUPT_PRIORITY_TIME 1
+#endif
+#ifndef STM32F4_INTERRUPT_PRIORITY_UART
+#define STM32F4_INTERRUPT_PRIORITY_UART 2
+#endif
+#ifndef STM32F4_INTERRUPT_PRIORITY_GPIO
+#define STM32F4_INTERRUPT_PRIORITY_GPIO 4
+#endif
+#ifndef STM32F4_INTERRUPT_PRIORITY_COUNTER
+#define STM32F4_INTERRUPT_PRIORITY_COUNTER 5
+#endif
+#ifndef STM32F4_INTERRUPT_PRIORITY_CAPTURE
+#define STM32F4_INTERRUPT_PRIORITY_CAPTURE 5
+#endif
+#ifndef STM32F4_INTERRUPT_PRIORITY_POWER
+#define STM32F4_INTERRUPT_PRIORITY_POWER 6
+#endif
+#ifndef STM32F4_INTERRUPT_PRIORITY_I2C
+#define STM32F4_INTERRUPT_PRIORITY_I2C 7
+#endif
+#ifndef STM32F4_INTERRUPT_PRIORITY_DAC
+#define STM32F4_INTERRUPT_PRIORITY_DAC 8
+#endif
+#ifndef STM32F4_INTERRUPT_PRIORITY_PWM
+#define STM32F4_INTERRUPT_PRIORITY_PWM 8
+#endif
+#ifndef STM32F4_INTERRUPT_PRIORITY_USB
+#define STM32F4_INTERRUPT_PRIORITY_USB 12
+#endif
+
+bool STM32F4_InterruptInternal_Activate(uint32_t index, uint32_t* isr, void* isrParam, uint32_t priority);
 bool STM32F4_InterruptInternal_Deactivate(uint32_t index);
+bool STM32F4_InterruptInternal_SetPriority(uint32_t index, uint32_t priority);
+uint32_t STM32F4_InterruptInternal_GetPriority(uint32_t index);
+
+////////////////////////////////////////////////////////////////////////////////
+//Timer Internal
+////////////////////////////////////////////////////////////////////////////////
+enum class STM32F4_Timer_Owner : uint8_t {
+    None = 0,
+    Time = 1,
+    Pwm = 2,
+    Capture = 3,
+    Counter = 4,
+    Encoder = 5,
+    OnePulse = 6,
+    Debounce = 7,
+    Dac = 8,
+};
+
+// acquire enables the timer clock, it fails if another driver owns the timer
+bool STM32F4_TimerInternal_Acquire(TIM_TypeDef* treg, STM32F4_Timer_Owner owner);
+void STM32F4_TimerInternal_Release(TIM_TypeDef* treg, STM32F4_Timer_Owner owner);
+STM32F4_Timer_Owner STM32F4_TimerInternal_GetOwner(TIM_TypeDef* treg);
 
 ////////////////////////////////////////////////////////////////////////////////
 //GPIO Internal
@@ -44,6 +44,54 @@ static const uint8_t g_STM32F4_AD_Pins[18] = STM32F4_ADC_PINS;
 
 #define STM32F4_AD_NUM SIZEOF_ARRAY(g_STM32F4_AD_Channel)  // number of channels
 
+// Regular conversions are moved by DMA2 stream 0 (channel 0 for ADC1, channel 2 for ADC3)
+#define STM32F4_ADC_DMA_STREAM DMA2_Stream0
+#define STM32F4_ADC_DMA_FLAGS (DMA_LIFCR_CFEIF0 | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CTEIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTCIF0)
+#if STM32F4_ADC == 1
+#define STM32F4_ADC_DMA_CHANNEL 0
+#else
+#define STM32F4_ADC_DMA_CHANNEL (DMA_SxCR_CHSEL_1)
+#endif
+
+// Interleaved multi ADC mode, ADC1 is the master and its DMA request moves ADC->CDR
+#if STM32F4_ADC == 1 && defined(ADC2)
+#define STM32F4_ADC_INTERLEAVED
+#define STM32F4_ADC_DUAL_INTERLEAVED (ADC_CCR_MULTI_2 | ADC_CCR_MULTI_1 | ADC_CCR_MULTI_0)
+#define STM32F4_ADC_TRIPLE_INTERLEAVED (ADC_CCR_MULTI_4 | ADC_CCR_MULTI_2 | ADC_CCR_MULTI_1 | ADC_CCR_MULTI_0)
+#define STM32F4_ADC_DUAL_DELAY 7   // cycles between ADC1 and ADC2 sampling
+#define STM32F4_ADC_TRIPLE_DELAY 5 // cycles between ADC1, ADC2 and ADC3 sampling
+#define STM32F4_ADC_CONVERSION_CYCLES 15 // 3 cycles sampling + 12 bits
+
+// ADC clock must not exceed 36MHz in the fast modes
+#if STM32F4_APB2_CLOCK_HZ / 2 <= 36000000
+#define STM32F4_ADC_FAST_PRESCALER 0
+#define STM32F4_ADC_FAST_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ / 2)
+#elif STM32F4_APB2_CLOCK_HZ / 4 <= 36000000
+#define STM32F4_ADC_FAST_PRESCALER ADC_CCR_ADCPRE_0
+#define STM32F4_ADC_FAST_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ / 4)
+#elif STM32F4_APB2_CLOCK_HZ / 6 <= 36000000
+#define STM32F4_ADC_FAST_PRESCALER ADC_CCR_ADCPRE_1
+#define STM32F4_ADC_FAST_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ / 6)
+#else
+#define STM32F4_ADC_FAST_PRESCALER ADC_CCR_ADCPRE
+#define STM32F4_ADC_FAST_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ / 8)
+#endif
+#endif
+
+#define STM32F4_AD_MAX_SAMPLES 256 // per filtered reading
+#define STM32F4_AD_MAX_OVERSAMPLE_BITS 4 // 4^4 samples for 16 bit results
+#define STM32F4_AD_MAX_IIR_SHIFT 8
+
+struct STM32F4_Adc_Filter {
+    STM32F4_Adc_FilterMode mode;
+    uint32_t parameter;
+    uint32_t state; // IIR accumulator, value << parameter
+    bool primed;
+};
+
+static STM32F4_Adc_Filter g_STM32F4_AD_Filter[STM32F4_AD_NUM];
+static uint32_t g_STM32F4_AD_Samples[STM32F4_AD_MAX_SAMPLES / 2]; // word aligned for paired access
+
 static TinyCLR_Adc_Provider adcProvider;
 static TinyCLR_Api_Info adcApi;
 
@@ -147,6 +195,8 @@ TinyCLR_Result STM32F4_Adc_AcquireChannel(const TinyCLR_Adc_Provider* self, int3
 TinyCLR_Result STM32F4_Adc_ReleaseChannel(const TinyCLR_Adc_Provider* self, int32_t channel) {
     int chNum = g_STM32F4_AD_Channel[channel];
 
+    g_STM32F4_AD_Filter[channel].mode = STM32F4_Adc_FilterMode::None;
+
     // free GPIO pin if this channel is listed in the STM32F4_AD_CHANNELS array
     // and if it's not one of the internally connected ones as these channels don't take any GPIO pins
     if (chNum < STM32F4_AD_NUM)
@@ -155,6 +205,179 @@ TinyCLR_Result STM32F4_Adc_ReleaseChannel(const TinyCLR_Adc_Provider* self, int3
     return TinyCLR_Result::Success;
 }
 
+static void STM32F4_Adc_StartDma(volatile uint32_t* source, uint16_t* buffer, size_t count, bool packed) {
+    DMA_Stream_TypeDef* stream = STM32F4_ADC_DMA_STREAM;
+
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+
+    stream->CR = 0;
+    while (stream->CR & DMA_SxCR_EN);
+
+    DMA2->LIFCR = STM32F4_ADC_DMA_FLAGS;
+
+    stream->PAR = (uint32_t)source;
+    stream->M0AR = (uint32_t)buffer;
+    stream->NDTR = count;
+
+    if (packed) {
+        stream->FCR = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH; // FIFO unpacks each word into two samples
+        stream->CR = STM32F4_ADC_DMA_CHANNEL | DMA_SxCR_PSIZE_1 | DMA_SxCR_MSIZE_0 | DMA_SxCR_MINC | DMA_SxCR_PL | DMA_SxCR_EN;
+    }
+    else {
+        stream->FCR = 0; // direct mode
+        stream->CR = STM32F4_ADC_DMA_CHANNEL | DMA_SxCR_PSIZE_0 | DMA_SxCR_MSIZE_0 | DMA_SxCR_MINC | DMA_SxCR_PL | DMA_SxCR_EN;
+    }
+}
+
+static bool STM32F4_Adc_WaitDma() {
+    // DMA requests stop on overrun, so do not wait for the transfer in that case
+    while (!(DMA2->LISR & (DMA_LISR_TCIF0 | DMA_LISR_TEIF0)) && !(ADCx->SR & ADC_SR_OVR));
+
+    return (DMA2->LISR & DMA_LISR_TCIF0) != 0;
+}
+
+static size_t STM32F4_Adc_StopDma() {
+    DMA_Stream_TypeDef* stream = STM32F4_ADC_DMA_STREAM;
+
+    stream->CR = 0;
+    while (stream->CR & DMA_SxCR_EN);
+
+    DMA2->LIFCR = STM32F4_ADC_DMA_FLAGS;
+
+    return stream->NDTR; // not transferred
+}
+
+static uint32_t STM32F4_Adc_Sum(const uint32_t* pairs, size_t count) {
+    uint32_t sum = 0;
+
+    // each word holds two samples, SMLAD adds both halves to the sum in one instruction
+    for (size_t i = 0; i < count / 2; i++)
+        sum = __SMLAD(pairs[i], 0x00010001, sum);
+
+    if (count & 1)
+        sum += ((const uint16_t*)pairs)[count - 1];
+
+    return sum;
+}
+
+static TinyCLR_Result STM32F4_Adc_Capture(int32_t chNum, uint16_t* buffer, size_t count) {
+    if (chNum == 16 || chNum == 17)
+        ADC->CCR |= ADC_CCR_TSVREFE;
+
+    ADCx->SQR3 = chNum;
+    ADCx->SR = 0;
+    ADCx->CR2 = ADC_CR2_ADON | ADC_CR2_CONT | ADC_CR2_DMA;
+
+    STM32F4_Adc_StartDma(&ADCx->DR, buffer, count, false);
+
+    ADCx->CR2 |= ADC_CR2_SWSTART;
+
+    bool completed = STM32F4_Adc_WaitDma();
+
+    ADCx->CR2 = ADC_CR2_ADON;
+
+    STM32F4_Adc_StopDma();
+
+    ADCx->SR = 0;
+
+    if (chNum == 16 || chNum == 17)
+        ADC->CCR &= ~ADC_CCR_TSVREFE;
+
+    return completed ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
+}
+
+static TinyCLR_Result STM32F4_Adc_ReadFilteredValue(int32_t channel, int32_t chNum, int32_t& value) {
+    auto& filter = g_STM32F4_AD_Filter[channel];
+    auto samples = (uint16_t*)g_STM32F4_AD_Samples;
+    size_t count;
+
+    switch (filter.mode) {
+        case STM32F4_Adc_FilterMode::Average:
+            count = filter.parameter;
+            break;
+
+        case STM32F4_Adc_FilterMode::Oversample:
+            count = 1 << (2 * filter.parameter); // 4^n samples for n extra bits
+            break;
+
+        default:
+            count = 1;
+            break;
+    }
+
+    auto result = STM32F4_Adc_Capture(chNum, samples, count);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    switch (filter.mode) {
+        case STM32F4_Adc_FilterMode::Average:
+            value = STM32F4_Adc_Sum(g_STM32F4_AD_Samples, count) / count;
+            break;
+
+        case STM32F4_Adc_FilterMode::Oversample:
+            // the provider reports 12 bits, the 12 + n bit result is rounded back to that
+            value = (STM32F4_Adc_Sum(g_STM32F4_AD_Samples, count) + (count >> 1)) >> (2 * filter.parameter);
+            break;
+
+        case STM32F4_Adc_FilterMode::Iir:
+            if (!filter.primed) {
+                filter.state = samples[0] << filter.parameter;
+                filter.primed = true;
+            }
+            else {
+                filter.state = filter.state - (filter.state >> filter.parameter) + samples[0];
+            }
+
+            value = filter.state >> filter.parameter;
+            break;
+
+        default:
+            value = samples[0];
+            break;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Adc_SetFilter(const TinyCLR_Adc_Provider* self, int32_t channel, STM32F4_Adc_FilterMode mode, uint32_t parameter) {
+    if (channel < 0 || channel >= STM32F4_AD_NUM)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    switch (mode) {
+        case STM32F4_Adc_FilterMode::None:
+            break;
+
+        case STM32F4_Adc_FilterMode::Average:
+            if (parameter < 2 || parameter > STM32F4_AD_MAX_SAMPLES)
+                return TinyCLR_Result::ArgumentOutOfRange;
+
+            break;
+
+        case STM32F4_Adc_FilterMode::Oversample:
+            if (parameter < 1 || parameter > STM32F4_AD_MAX_OVERSAMPLE_BITS)
+                return TinyCLR_Result::ArgumentOutOfRange;
+
+            break;
+
+        case STM32F4_Adc_FilterMode::Iir:
+            if (parameter < 1 || parameter > STM32F4_AD_MAX_IIR_SHIFT)
+                return TinyCLR_Result::ArgumentOutOfRange;
+
+            break;
+
+        default:
+            return TinyCLR_Result::NotSupported;
+    }
+
+    g_STM32F4_AD_Filter[channel].mode = mode;
+    g_STM32F4_AD_Filter[channel].parameter = parameter;
+    g_STM32F4_AD_Filter[channel].state = 0;
+    g_STM32F4_AD_Filter[channel].primed = false;
+
+    return TinyCLR_Result::Success;
+}
+
 TinyCLR_Result STM32F4_Adc_ReadValue(const TinyCLR_Adc_Provider* self, int32_t channel, int32_t& value) {
     int chNum = g_STM32F4_AD_Channel[channel];
 
@@ -162,6 +385,9 @@ TinyCLR_Result STM32F4_Adc_ReadValue(const TinyCLR_Adc_Provider* self, int32_t c
     for (int i = 0; i < STM32F4_AD_NUM; i++) {
         if (g_STM32F4_AD_Channel[i] == chNum) {
             // valid channel
+            if (g_STM32F4_AD_Filter[channel].mode != STM32F4_Adc_FilterMode::None)
+                return STM32F4_Adc_ReadFilteredValue(channel, chNum, value);
+
             int x = ADCx->DR; // clear EOC flag
 
             ADCx->SQR3 = chNum; // select channel
@@ -189,6 +415,193 @@ TinyCLR_Result STM32F4_Adc_ReadValue(const TinyCLR_Adc_Provider* self, int32_t c
     return TinyCLR_Result::ArgumentOutOfRange;
 }
 
+TinyCLR_Result STM32F4_Adc_ReadChannels(const TinyCLR_Adc_Provider* self, const int32_t* channels, int32_t* values, size_t count) {
+    if (channels == nullptr || values == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    bool internal = false;
+
+    for (size_t i = 0; i < count; i++) {
+        if (channels[i] < 0 || channels[i] >= STM32F4_AD_NUM || g_STM32F4_AD_Channel[channels[i]] >= STM32F4_AD_NUM)
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+        if (g_STM32F4_AD_Channel[channels[i]] > 15)
+            internal = true;
+    }
+
+    if (!(RCC->APB2ENR & RCC_APB2ENR_ADCxEN)) // no channel acquired
+        return TinyCLR_Result::InvalidOperation;
+
+    uint16_t samples[16]; // regular sequence length
+    auto result = TinyCLR_Result::Success;
+
+    if (internal)
+        ADC->CCR |= ADC_CCR_TSVREFE;
+
+    ADCx->CR1 = ADC_CR1_SCAN;
+
+    for (size_t offset = 0; offset < count; offset += SIZEOF_ARRAY(samples)) {
+        size_t length = count - offset;
+
+        if (length > SIZEOF_ARRAY(samples))
+            length = SIZEOF_ARRAY(samples);
+
+        uint32_t sqr[3] = { 0, 0, 0 }; // SQR3: 1..6, SQR2: 7..12, SQR1: 13..16
+
+        for (size_t i = 0; i < length; i++)
+            sqr[i / 6] |= g_STM32F4_AD_Channel[channels[offset + i]] << ((i % 6) * 5);
+
+        ADCx->SQR3 = sqr[0];
+        ADCx->SQR2 = sqr[1];
+        ADCx->SQR1 = sqr[2] | ((length - 1) << ADC_SQR1_L_Pos);
+        ADCx->SR = 0;
+
+        ADCx->CR2 = ADC_CR2_ADON; // DMA has to be re-enabled for every sequence
+        ADCx->CR2 = ADC_CR2_ADON | ADC_CR2_DMA;
+
+        STM32F4_Adc_StartDma(&ADCx->DR, samples, length, false);
+
+        ADCx->CR2 |= ADC_CR2_SWSTART;
+
+        if (!STM32F4_Adc_WaitDma()) {
+            result = TinyCLR_Result::InvalidOperation;
+            break;
+        }
+
+        for (size_t i = 0; i < length; i++)
+            values[offset + i] = samples[i];
+    }
+
+    STM32F4_Adc_StopDma();
+
+    // back to single conversion mode
+    ADCx->SR = 0;
+    ADCx->CR1 = 0;
+    ADCx->SQR1 = 0;
+    ADCx->SQR2 = 0;
+    ADCx->CR2 = ADC_CR2_ADON;
+
+    if (internal)
+        ADC->CCR &= ~ADC_CCR_TSVREFE;
+
+    return result;
+}
+
+int32_t STM32F4_Adc_GetInterleavedSampleRate(const TinyCLR_Adc_Provider* self, int32_t adcCount) {
+#ifdef STM32F4_ADC_INTERLEAVED
+    if (adcCount == 2)
+        return STM32F4_ADC_FAST_CLOCK_HZ * 2 / STM32F4_ADC_CONVERSION_CYCLES;
+
+#ifdef ADC3
+    if (adcCount == 3)
+        return STM32F4_ADC_FAST_CLOCK_HZ / STM32F4_ADC_TRIPLE_DELAY;
+#endif
+#endif
+
+    return 0;
+}
+
+TinyCLR_Result STM32F4_Adc_ReadInterleaved(const TinyCLR_Adc_Provider* self, int32_t channel, int32_t adcCount, uint16_t* buffer, size_t& length) {
+#ifdef STM32F4_ADC_INTERLEAVED
+    if (buffer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    // every DMA request moves two samples packed in ADC->CDR
+    if (channel < 0 || channel >= STM32F4_AD_NUM || length == 0 || (length & 1) != 0 || (length / 2) > 0xFFFF)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    int32_t chNum = g_STM32F4_AD_Channel[channel];
+
+    // internally connected channels are on ADC1 only
+    if (chNum > 15)
+        return TinyCLR_Result::NotSupported;
+
+    uint32_t mode;
+    uint32_t delay;
+    uint32_t slaveClocks;
+
+    switch (adcCount) {
+        case 2:
+            mode = STM32F4_ADC_DUAL_INTERLEAVED;
+            delay = STM32F4_ADC_DUAL_DELAY;
+            slaveClocks = RCC_APB2ENR_ADC2EN;
+            break;
+
+#ifdef ADC3
+        case 3:
+            // only IN0..IN3 and IN10..IN13 are shared by all three ADCs
+            if (chNum > 3 && (chNum < 10 || chNum > 13))
+                return TinyCLR_Result::NotSupported;
+
+            mode = STM32F4_ADC_TRIPLE_INTERLEAVED;
+            delay = STM32F4_ADC_TRIPLE_DELAY;
+            slaveClocks = RCC_APB2ENR_ADC2EN | RCC_APB2ENR_ADC3EN;
+            break;
+#endif
+
+        default:
+            return TinyCLR_Result::NotSupported;
+    }
+
+    if (!(RCC->APB2ENR & RCC_APB2ENR_ADCxEN)) // no channel acquired
+        return TinyCLR_Result::InvalidOperation;
+
+#ifdef ADC3
+    ADC_TypeDef* adc[] = { ADC1, ADC2, ADC3 };
+#else
+    ADC_TypeDef* adc[] = { ADC1, ADC2 };
+#endif
+
+    RCC->APB2ENR |= slaveClocks;
+
+    for (auto i = 0; i < adcCount; i++) {
+        adc[i]->CR2 = 0;
+        adc[i]->CR1 = 0; // 12 bit
+        adc[i]->SQR1 = 0; // 1 conversion
+        adc[i]->SQR3 = chNum;
+        adc[i]->SMPR1 = 0; // 3 cycles sample time
+        adc[i]->SMPR2 = 0;
+        adc[i]->SR = 0;
+        adc[i]->CR2 = ADC_CR2_ADON | ADC_CR2_CONT;
+    }
+
+    STM32F4_Time_Delay(nullptr, 3); // ADC stabilization time
+
+    STM32F4_Adc_StartDma(&ADC->CDR, buffer, length / 2, true);
+
+    uint32_t ccr = ADC->CCR;
+
+    ADC->CCR = (ccr & ~(ADC_CCR_MULTI | ADC_CCR_DELAY | ADC_CCR_DDS | ADC_CCR_DMA | ADC_CCR_ADCPRE))
+        | mode
+        | ((delay - 5) << ADC_CCR_DELAY_Pos)
+        | ADC_CCR_DMA_1 // DMA mode 2, two half words per request
+        | STM32F4_ADC_FAST_PRESCALER;
+
+    ADC1->CR2 |= ADC_CR2_SWSTART; // ADC1 triggers the others
+
+    bool completed = STM32F4_Adc_WaitDma();
+
+    for (auto i = 0; i < adcCount; i++)
+        adc[i]->CR2 = 0;
+
+    length -= STM32F4_Adc_StopDma() * 2;
+
+    ADC->CCR = ccr;
+
+    RCC->APB2ENR &= ~slaveClocks;
+
+    // back to single conversion mode
+    ADCx->SR = 0;
+    ADCx->SMPR1 = 0x01249249 * STM32F4_AD_SAMPLE_TIME;
+    ADCx->SMPR2 = 0x09249249 * STM32F4_AD_SAMPLE_TIME;
+    ADCx->CR2 = ADC_CR2_ADON;
+
+    return completed ? TinyCLR_Result::Success : TinyCLR_Result::InvalidOperation;
+#else
+    return TinyCLR_Result::NotSupported;
+#endif
+}
+
 int32_t STM32F4_Adc_GetChannelCount(const TinyCLR_Adc_Provider* self) {
     return STM32F4_AD_NUM;
 }
@@ -0,0 +1,518 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "STM32F4.h"
+
+#ifdef INCLUDE_PWM
+///////////////////////////////////////////////////////////////////////////////
+
+// input capture runs on the PWM timers and pins: controller x is TIM(x + 1), channel y is CC(y + 1)
+#define STM32F4_CAPTURE_CHANNELS 4
+#define STM32F4_CAPTURE_MAX_LENGTH 0xFFFF
+#define STM32F4_CAPTURE_DEFAULT_FREQUENCY 1000000
+
+#if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_CAPTURE_APB1_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ)
+#else
+#define STM32F4_CAPTURE_APB1_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
+#endif
+
+#if STM32F4_APB2_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_CAPTURE_APB2_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ)
+#else
+#define STM32F4_CAPTURE_APB2_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ * 2)
+#endif
+
+struct STM32F4_Capture_Dma {
+    DMA_TypeDef* dma;
+    DMA_Stream_TypeDef* stream;
+    uint32_t irq;
+    uint32_t channel; // CHSEL
+    uint32_t shift; // stream flag offset in xISR/xIFCR
+    bool high; // stream 4..7 flags live in HISR/HIFCR
+};
+
+struct STM32F4_Capture_Controller {
+    TIM_TypeDef* timer;
+    uint32_t channels; // acquired channel mask
+    bool pulse;
+    bool pulseValid;
+    int32_t pulseChannel;
+
+    int32_t bufferChannel; // -1 when idle
+    size_t bufferLength;
+    STM32F4_Capture_Dma dma;
+    STM32F4_Capture_BufferHandler handler;
+};
+
+static STM32F4_Gpio_Pin g_STM32F4_Capture_Pins[][STM32F4_CAPTURE_CHANNELS] = STM32F4_PWM_PINS;
+
+static const int TOTAL_CAPTURE_CONTROLLERS = SIZEOF_ARRAY(g_STM32F4_Capture_Pins);
+
+static STM32F4_Capture_Controller g_STM32F4_Capture_Controller[TOTAL_CAPTURE_CONTROLLERS];
+
+static TIM_TypeDef* STM32F4_Capture_GetTimer(int32_t controller) {
+    switch (controller) {
+    case 0: return TIM1;
+    case 1: return TIM2;
+    case 2: return TIM3;
+    case 3: return TIM4;
+#if !defined(STM32F401xE) && !defined(STM32F411xE)
+    case 4: return TIM5;
+    case 7: return TIM8;
+#endif
+    default: return nullptr; // basic timers and the 1-2 channel timers are not supported
+    }
+}
+
+static void STM32F4_Capture_ConfigureChannel(TIM_TypeDef* treg, int32_t channel, uint32_t selection, STM32F4_Capture_Edge edge) {
+    auto reg = (channel & 2) ? &treg->CCMR2 : &treg->CCMR1;
+    auto shift = (channel & 1) * 8;
+
+    *reg = (*reg & ~(0xFF << shift)) | ((selection & TIM_CCMR1_CC1S) << shift); // no filter, no prescaler
+
+    uint32_t polarity = 0;
+
+    if (edge == STM32F4_Capture_Edge::Falling) polarity = TIM_CCER_CC1P;
+    if (edge == STM32F4_Capture_Edge::Both) polarity = TIM_CCER_CC1P | TIM_CCER_CC1NP;
+
+    treg->CCER = (treg->CCER & ~((TIM_CCER_CC1P | TIM_CCER_CC1NP) << (4 * channel))) | ((polarity | TIM_CCER_CC1E) << (4 * channel));
+}
+
+static TinyCLR_Result STM32F4_Capture_OpenPin(int32_t controller, int32_t channel) {
+    auto& pin = g_STM32F4_Capture_Pins[controller][channel];
+
+    if (pin.number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+    if (!STM32F4_GpioInternal_OpenPin(pin.number))
+        return TinyCLR_Result::SharingViolation;
+
+    STM32F4_GpioInternal_ConfigurePin(pin.number, STM32F4_Gpio_PortMode::AlternateFunction, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, pin.alternateFunction);
+
+    return TinyCLR_Result::Success;
+}
+
+static void STM32F4_Capture_ClosePin(int32_t controller, int32_t channel) {
+    auto& pin = g_STM32F4_Capture_Pins[controller][channel];
+
+    STM32F4_GpioInternal_ConfigurePin(pin.number, STM32F4_Gpio_PortMode::Input, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, STM32F4_Gpio_AlternateFunction::AF0);
+    STM32F4_GpioInternal_ClosePin(pin.number);
+}
+
+static bool STM32F4_Capture_GetDma(int32_t controller, int32_t channel, STM32F4_Capture_Dma& dma) {
+    // TIMx_CHy requests, (dma, stream, channel)
+    static const uint8_t map[8][STM32F4_CAPTURE_CHANNELS][3] = {
+        { { 2, 1, 6 }, { 2, 2, 6 }, { 2, 6, 6 }, { 2, 4, 6 } }, // TIM1
+        { { 1, 5, 3 }, { 1, 6, 3 }, { 1, 1, 3 }, { 1, 7, 3 } }, // TIM2
+        { { 1, 4, 5 }, { 1, 5, 5 }, { 1, 7, 5 }, { 1, 2, 5 } }, // TIM3
+        { { 1, 0, 2 }, { 1, 3, 2 }, { 1, 7, 2 }, { 0, 0, 0 } }, // TIM4
+        { { 1, 2, 6 }, { 1, 4, 6 }, { 1, 0, 6 }, { 1, 1, 6 } }, // TIM5
+        { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } },
+        { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } },
+        { { 2, 2, 7 }, { 2, 3, 7 }, { 2, 4, 7 }, { 2, 7, 7 } }, // TIM8
+    };
+
+    static DMA_Stream_TypeDef* const dma1Streams[] = { DMA1_Stream0, DMA1_Stream1, DMA1_Stream2, DMA1_Stream3, DMA1_Stream4, DMA1_Stream5, DMA1_Stream6, DMA1_Stream7 };
+    static DMA_Stream_TypeDef* const dma2Streams[] = { DMA2_Stream0, DMA2_Stream1, DMA2_Stream2, DMA2_Stream3, DMA2_Stream4, DMA2_Stream5, DMA2_Stream6, DMA2_Stream7 };
+    static const IRQn_Type dma1Irqs[] = { DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn, DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn };
+    static const IRQn_Type dma2Irqs[] = { DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn, DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn };
+    static const uint8_t shifts[] = { 0, 6, 16, 22 };
+
+    if (controller >= 8 || map[controller][channel][0] == 0)
+        return false;
+
+    auto stream = map[controller][channel][1];
+
+    dma.dma = map[controller][channel][0] == 1 ? DMA1 : DMA2;
+    dma.stream = map[controller][channel][0] == 1 ? dma1Streams[stream] : dma2Streams[stream];
+    dma.irq = map[controller][channel][0] == 1 ? dma1Irqs[stream] : dma2Irqs[stream];
+    dma.channel = map[controller][channel][2];
+    dma.shift = shifts[stream & 3];
+    dma.high = stream > 3;
+
+    return true;
+}
+
+static void STM32F4_Capture_ReleaseBuffer(int32_t controller) {
+    auto& state = g_STM32F4_Capture_Controller[controller];
+
+    if (state.bufferChannel < 0)
+        return;
+
+    state.timer->DIER &= ~(TIM_DIER_CC1DE << state.bufferChannel);
+    state.dma.stream->CR = 0;
+
+    if (state.dma.high)
+        state.dma.dma->HIFCR = 0x3D << state.dma.shift;
+    else
+        state.dma.dma->LIFCR = 0x3D << state.dma.shift;
+
+    STM32F4_InterruptInternal_Deactivate(state.dma.irq);
+
+    state.bufferChannel = -1;
+}
+
+static void STM32F4_Capture_BufferInterrupt(int32_t controller) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& state = g_STM32F4_Capture_Controller[controller];
+    auto& dma = state.dma;
+    auto status = ((dma.high ? dma.dma->HISR : dma.dma->LISR) >> dma.shift) & 0x3D;
+
+    if (dma.high)
+        dma.dma->HIFCR = status << dma.shift; // clear
+    else
+        dma.dma->LIFCR = status << dma.shift;
+
+    if (status & DMA_LISR_TEIF0) {
+        STM32F4_Capture_ReleaseBuffer(controller);
+
+        if (state.handler != nullptr)
+            state.handler(controller, STM32F4_Capture_BufferEvent::Error);
+
+        return;
+    }
+
+    if (status & DMA_LISR_HTIF0) {
+        if (state.handler != nullptr)
+            state.handler(controller, STM32F4_Capture_BufferEvent::HalfTransfer);
+    }
+
+    if (status & DMA_LISR_TCIF0) {
+        if (!(dma.stream->CR & DMA_SxCR_CIRC))
+            STM32F4_Capture_ReleaseBuffer(controller);
+
+        if (state.handler != nullptr)
+            state.handler(controller, STM32F4_Capture_BufferEvent::TransferComplete);
+    }
+}
+
+void STM32F4_Capture_BufferInterrupt1(void* param) { STM32F4_Capture_BufferInterrupt(0); }
+void STM32F4_Capture_BufferInterrupt2(void* param) { STM32F4_Capture_BufferInterrupt(1); }
+void STM32F4_Capture_BufferInterrupt3(void* param) { STM32F4_Capture_BufferInterrupt(2); }
+void STM32F4_Capture_BufferInterrupt4(void* param) { STM32F4_Capture_BufferInterrupt(3); }
+void STM32F4_Capture_BufferInterrupt5(void* param) { STM32F4_Capture_BufferInterrupt(4); }
+void STM32F4_Capture_BufferInterrupt8(void* param) { STM32F4_Capture_BufferInterrupt(7); }
+
+static void (* const g_STM32F4_Capture_BufferIsr[])(void*) = {
+    &STM32F4_Capture_BufferInterrupt1, &STM32F4_Capture_BufferInterrupt2, &STM32F4_Capture_BufferInterrupt3, &STM32F4_Capture_BufferInterrupt4,
+    &STM32F4_Capture_BufferInterrupt5, nullptr, nullptr, &STM32F4_Capture_BufferInterrupt8
+};
+
+// frequency is the requested counter tick rate in Hz and returns the actual rate
+TinyCLR_Result STM32F4_Capture_Acquire(int32_t controller, uint32_t& frequency) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto treg = STM32F4_Capture_GetTimer(controller);
+
+    if (treg == nullptr)
+        return TinyCLR_Result::NotSupported;
+
+    uint32_t clock = ((uint32_t)treg & 0x10000) ? STM32F4_CAPTURE_APB2_CLOCK_HZ : STM32F4_CAPTURE_APB1_CLOCK_HZ;
+
+    if (frequency == 0)
+        frequency = STM32F4_CAPTURE_DEFAULT_FREQUENCY;
+
+    uint32_t prescaler = clock / frequency;
+
+    if (prescaler == 0) prescaler = 1;
+    if (prescaler > 0x10000) prescaler = 0x10000;
+
+    frequency = clock / prescaler;
+
+    auto& state = g_STM32F4_Capture_Controller[controller];
+
+    if (!STM32F4_TimerInternal_Acquire(treg, STM32F4_Timer_Owner::Capture)) // timer used by PWM or another driver
+        return TinyCLR_Result::SharingViolation;
+
+    state.timer = treg;
+    state.channels = 0;
+    state.pulse = false;
+    state.pulseValid = false;
+    state.bufferChannel = -1;
+    state.handler = nullptr;
+
+    treg->CR1 = TIM_CR1_URS; // only overflow raises UIF
+    treg->SMCR = 0;
+    treg->CCMR1 = 0;
+    treg->CCMR2 = 0;
+    treg->CCER = 0;
+    treg->DIER = 0;
+    treg->PSC = prescaler - 1;
+    treg->ARR = (controller == 1 || controller == 4) ? 0xFFFFFFFF : 0xFFFF; // TIM2 and TIM5 are 32 bit
+    treg->EGR = TIM_EGR_UG; // load prescaler
+    treg->SR = 0;
+    treg->CR1 |= TIM_CR1_CEN; // free running
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Capture_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Capture_Controller[controller];
+
+    if (state.timer == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    STM32F4_Capture_ReleaseBuffer(controller);
+
+    for (auto channel = 0; channel < STM32F4_CAPTURE_CHANNELS; channel++)
+        if (state.channels & (1 << channel))
+            STM32F4_Capture_ReleaseChannel(controller, channel);
+
+    state.timer->CR1 = 0;
+    state.timer->SMCR = 0;
+
+    STM32F4_TimerInternal_Release(state.timer, STM32F4_Timer_Owner::Capture);
+
+    state.timer = nullptr;
+
+    return TinyCLR_Result::Success;
+}
+
+uint32_t STM32F4_Capture_GetCounterMask(int32_t controller) {
+    return (controller == 1 || controller == 4) ? 0xFFFFFFFF : 0xFFFF;
+}
+
+TinyCLR_Result STM32F4_Capture_AcquireChannel(int32_t controller, int32_t channel, STM32F4_Capture_Edge edge) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS || channel < 0 || channel >= STM32F4_CAPTURE_CHANNELS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Capture_Controller[controller];
+
+    if (state.timer == nullptr || state.pulse)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (state.channels & (1 << channel))
+        return TinyCLR_Result::SharingViolation;
+
+    auto result = STM32F4_Capture_OpenPin(controller, channel);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    STM32F4_Capture_ConfigureChannel(state.timer, channel, TIM_CCMR1_CC1S_0, edge); // ICx mapped on TIx
+
+    state.timer->SR = ~((TIM_SR_CC1IF | TIM_SR_CC1OF) << channel);
+    state.channels |= 1 << channel;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Capture_ReleaseChannel(int32_t controller, int32_t channel) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS || channel < 0 || channel >= STM32F4_CAPTURE_CHANNELS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Capture_Controller[controller];
+
+    if (state.timer == nullptr || !(state.channels & (1 << channel)))
+        return TinyCLR_Result::InvalidOperation;
+
+    if (state.pulse) { // either channel of the pair releases both, only the input pin was opened
+        state.timer->CCER &= ~0xFF;
+        state.timer->CCMR1 = 0;
+        state.timer->SMCR = 0;
+        state.channels = 0;
+        state.pulse = false;
+
+        STM32F4_Capture_ClosePin(controller, state.pulseChannel);
+
+        return TinyCLR_Result::Success;
+    }
+
+    if (state.bufferChannel == channel)
+        STM32F4_Capture_ReleaseBuffer(controller);
+
+    state.timer->CCER &= ~(0xF << (4 * channel));
+
+    auto reg = (channel & 2) ? &state.timer->CCMR2 : &state.timer->CCMR1;
+
+    *reg &= ~(0xFF << ((channel & 1) * 8));
+
+    state.channels &= ~(1 << channel);
+
+    STM32F4_Capture_ClosePin(controller, channel);
+
+    return TinyCLR_Result::Success;
+}
+
+// timestamp is the raw counter value latched by the last edge, wrapping at GetCounterMask
+TinyCLR_Result STM32F4_Capture_ReadTimestamp(int32_t controller, int32_t channel, uint32_t& timestamp, bool& overcapture) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS || channel < 0 || channel >= STM32F4_CAPTURE_CHANNELS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Capture_Controller[controller];
+
+    if (state.timer == nullptr || !(state.channels & (1 << channel)) || state.bufferChannel == channel)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto sr = state.timer->SR;
+
+    if (!(sr & (TIM_SR_CC1IF << channel)))
+        return TinyCLR_Result::NotAvailable;
+
+    timestamp = ((__IO uint32_t*)&state.timer->CCR1)[channel]; // clears CCxIF
+    overcapture = (sr & (TIM_SR_CC1OF << channel)) != 0; // edges were lost since the last read
+
+    if (overcapture)
+        state.timer->SR = ~(TIM_SR_CC1OF << channel);
+
+    return TinyCLR_Result::Success;
+}
+
+// each edge is written to timestamps by DMA without CPU involvement
+TinyCLR_Result STM32F4_Capture_StartBuffer(int32_t controller, int32_t channel, uint32_t* timestamps, size_t length, bool circular, STM32F4_Capture_BufferHandler handler) {
+    if (timestamps == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS || channel < 0 || channel >= STM32F4_CAPTURE_CHANNELS || length == 0 || length > STM32F4_CAPTURE_MAX_LENGTH)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Capture_Controller[controller];
+
+    if (state.timer == nullptr || !(state.channels & (1 << channel)) || state.bufferChannel >= 0)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (!STM32F4_Capture_GetDma(controller, channel, state.dma))
+        return TinyCLR_Result::NotSupported;
+
+    auto& dma = state.dma;
+
+    if (dma.stream->CR & DMA_SxCR_EN) // stream used by another driver
+        return TinyCLR_Result::SharingViolation;
+
+    RCC->AHB1ENR |= dma.dma == DMA1 ? RCC_AHB1ENR_DMA1EN : RCC_AHB1ENR_DMA2EN;
+
+    if (dma.high)
+        dma.dma->HIFCR = 0x3D << dma.shift;
+    else
+        dma.dma->LIFCR = 0x3D << dma.shift;
+
+    dma.stream->PAR = (uint32_t)&((__IO uint32_t*)&state.timer->CCR1)[channel];
+    dma.stream->M0AR = (uint32_t)timestamps;
+    dma.stream->NDTR = length;
+    dma.stream->FCR = 0; // direct mode
+    dma.stream->CR = (dma.channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 | DMA_SxCR_MINC | DMA_SxCR_TCIE | DMA_SxCR_TEIE
+        | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1
+        | (circular ? (DMA_SxCR_CIRC | DMA_SxCR_HTIE) : 0);
+
+    state.bufferChannel = channel;
+    state.bufferLength = length;
+    state.handler = handler;
+
+    STM32F4_InterruptInternal_Activate(dma.irq, (uint32_t*)g_STM32F4_Capture_BufferIsr[controller], 0, STM32F4_INTERRUPT_PRIORITY_CAPTURE);
+
+    dma.stream->CR |= DMA_SxCR_EN;
+
+    state.timer->SR = ~((TIM_SR_CC1IF | TIM_SR_CC1OF) << channel);
+    state.timer->DIER |= TIM_DIER_CC1DE << channel;
+
+    return TinyCLR_Result::Success;
+}
+
+// captured returns the number of timestamps written in the current pass over the buffer
+TinyCLR_Result STM32F4_Capture_StopBuffer(int32_t controller, size_t& captured) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Capture_Controller[controller];
+
+    captured = 0;
+
+    if (state.timer == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (state.bufferChannel < 0)
+        return TinyCLR_Result::Success;
+
+    state.timer->DIER &= ~(TIM_DIER_CC1DE << state.bufferChannel);
+
+    captured = state.bufferLength - state.dma.stream->NDTR;
+
+    STM32F4_Capture_ReleaseBuffer(controller);
+
+    return TinyCLR_Result::Success;
+}
+
+// PWM input mode: the rising edge on channel resets the counter, its partner channel latches the falling edge
+TinyCLR_Result STM32F4_Capture_AcquirePulse(int32_t controller, int32_t channel) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS || channel < 0 || channel > 1)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Capture_Controller[controller];
+
+    if (state.timer == nullptr || state.channels != 0)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto result = STM32F4_Capture_OpenPin(controller, channel);
+
+    if (result != TinyCLR_Result::Success)
+        return result;
+
+    auto treg = state.timer;
+
+    STM32F4_Capture_ConfigureChannel(treg, channel, TIM_CCMR1_CC1S_0, STM32F4_Capture_Edge::Rising); // ICx on TIx
+    STM32F4_Capture_ConfigureChannel(treg, channel ^ 1, TIM_CCMR1_CC1S_1, STM32F4_Capture_Edge::Falling); // partner on the same TIx
+
+    // trigger TI1FP1 or TI2FP2, slave reset mode
+    treg->SMCR = (channel == 0 ? (TIM_SMCR_TS_2 | TIM_SMCR_TS_0) : (TIM_SMCR_TS_2 | TIM_SMCR_TS_1)) | TIM_SMCR_SMS_2;
+    treg->SR = 0;
+
+    state.channels = 3;
+    state.pulse = true;
+    state.pulseValid = false;
+    state.pulseChannel = channel;
+
+    return TinyCLR_Result::Success;
+}
+
+// period and highTime are in counter ticks of the last complete cycle
+TinyCLR_Result STM32F4_Capture_ReadPulse(int32_t controller, uint32_t& period, uint32_t& highTime) {
+    if (controller < 0 || controller >= TOTAL_CAPTURE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Capture_Controller[controller];
+
+    if (state.timer == nullptr || !state.pulse)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto treg = state.timer;
+    auto rising = state.pulseChannel;
+    auto ccr = (__IO uint32_t*)&treg->CCR1;
+
+    if (treg->SR & TIM_SR_UIF) { // counter overflowed, the input is slower than the counter range or stopped
+        treg->SR = ~TIM_SR_UIF;
+        state.pulseValid = false;
+    }
+
+    if (!(treg->SR & (TIM_SR_CC1IF << rising)))
+        return TinyCLR_Result::NotAvailable;
+
+    period = ccr[rising];
+    highTime = ccr[rising ^ 1];
+
+    if (!state.pulseValid) { // the first edge after acquire or an overflow ends a partial period
+        state.pulseValid = true;
+
+        return TinyCLR_Result::NotAvailable;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
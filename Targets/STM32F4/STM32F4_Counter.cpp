@@ -0,0 +1,272 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "STM32F4.h"
+
+#ifdef INCLUDE_PWM
+///////////////////////////////////////////////////////////////////////////////
+
+// pulse counting runs on the PWM timers: controller x is TIM(x + 1) clocked by the CH1 pin, CC2 holds the compare value
+#define STM32F4_COUNTER_CHANNELS 4
+#define STM32F4_COUNTER_PIN 0
+
+struct STM32F4_Counter_Controller {
+    TIM_TypeDef* timer;
+    uint32_t updateIrq;
+    uint32_t captureIrq;
+    uint32_t mask; // counter range - 1
+
+    uint64_t wraps; // counter overflows, extends the count to 64 bit
+
+    uint64_t compare;
+    STM32F4_Counter_CompareHandler handler;
+};
+
+static STM32F4_Gpio_Pin g_STM32F4_Counter_Pins[][STM32F4_COUNTER_CHANNELS] = STM32F4_PWM_PINS;
+
+static const int TOTAL_COUNTER_CONTROLLERS = SIZEOF_ARRAY(g_STM32F4_Counter_Pins);
+
+static STM32F4_Counter_Controller g_STM32F4_Counter_Controller[TOTAL_COUNTER_CONTROLLERS];
+
+static bool STM32F4_Counter_GetTimer(int32_t controller, STM32F4_Counter_Controller& state) {
+    switch (controller) {
+    case 0: state.timer = TIM1; state.updateIrq = TIM1_UP_TIM10_IRQn; state.captureIrq = TIM1_CC_IRQn; break;
+    case 1: state.timer = TIM2; state.updateIrq = state.captureIrq = TIM2_IRQn; break;
+    case 2: state.timer = TIM3; state.updateIrq = state.captureIrq = TIM3_IRQn; break;
+    case 3: state.timer = TIM4; state.updateIrq = state.captureIrq = TIM4_IRQn; break;
+#if !defined(STM32F401xE) && !defined(STM32F411xE)
+    case 4: state.timer = TIM5; state.updateIrq = state.captureIrq = TIM5_IRQn; break;
+    case 7: state.timer = TIM8; state.updateIrq = TIM8_UP_TIM13_IRQn; state.captureIrq = TIM8_CC_IRQn; break;
+#endif
+    default:
+        return false;
+    }
+
+    state.mask = (controller == 1 || controller == 4) ? 0xFFFFFFFF : 0xFFFF; // TIM2 and TIM5 are 32 bit
+
+    return true;
+}
+
+static uint64_t STM32F4_Counter_ReadCount(STM32F4_Counter_Controller& state) {
+    auto treg = state.timer;
+    uint32_t count = treg->CNT & state.mask;
+    uint64_t wraps = state.wraps;
+
+    if (treg->SR & TIM_SR_UIF) { // overflow not yet seen by the interrupt
+        count = treg->CNT & state.mask;
+        wraps++;
+    }
+
+    return wraps * ((uint64_t)state.mask + 1) + count;
+}
+
+static void STM32F4_Counter_InterruptHandler(int32_t controller) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& state = g_STM32F4_Counter_Controller[controller];
+    auto treg = state.timer;
+
+    if (treg->SR & TIM_SR_UIF) {
+        treg->SR = ~TIM_SR_UIF;
+
+        state.wraps++;
+    }
+
+    if ((treg->SR & TIM_SR_CC2IF) && (treg->DIER & TIM_DIER_CC2IE)) {
+        treg->SR = ~TIM_SR_CC2IF;
+
+        auto count = STM32F4_Counter_ReadCount(state);
+
+        if (count >= state.compare) { // earlier matches are previous laps of the 16 bit counter
+            treg->DIER &= ~TIM_DIER_CC2IE;
+
+            if (state.handler != nullptr)
+                state.handler(controller, count);
+        }
+    }
+}
+
+void STM32F4_Counter_InterruptHandler1(void* param) { STM32F4_Counter_InterruptHandler(0); }
+void STM32F4_Counter_InterruptHandler2(void* param) { STM32F4_Counter_InterruptHandler(1); }
+void STM32F4_Counter_InterruptHandler3(void* param) { STM32F4_Counter_InterruptHandler(2); }
+void STM32F4_Counter_InterruptHandler4(void* param) { STM32F4_Counter_InterruptHandler(3); }
+void STM32F4_Counter_InterruptHandler5(void* param) { STM32F4_Counter_InterruptHandler(4); }
+void STM32F4_Counter_InterruptHandler8(void* param) { STM32F4_Counter_InterruptHandler(7); }
+
+static void (* const g_STM32F4_Counter_Isr[])(void*) = {
+    &STM32F4_Counter_InterruptHandler1, &STM32F4_Counter_InterruptHandler2, &STM32F4_Counter_InterruptHandler3, &STM32F4_Counter_InterruptHandler4,
+    &STM32F4_Counter_InterruptHandler5, nullptr, nullptr, &STM32F4_Counter_InterruptHandler8
+};
+
+TinyCLR_Result STM32F4_Counter_Acquire(int32_t controller, STM32F4_Counter_Edge edge) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Counter_Controller[controller];
+
+    if (state.timer != nullptr)
+        return TinyCLR_Result::SharingViolation;
+
+    STM32F4_Counter_Controller config;
+
+    if (!STM32F4_Counter_GetTimer(controller, config))
+        return TinyCLR_Result::NotSupported;
+
+    auto treg = config.timer;
+    auto& pin = g_STM32F4_Counter_Pins[controller][STM32F4_COUNTER_PIN];
+
+    if (pin.number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+    if (!STM32F4_TimerInternal_Acquire(treg, STM32F4_Timer_Owner::Counter)) // timer used by PWM or another driver
+        return TinyCLR_Result::SharingViolation;
+
+    if (!STM32F4_GpioInternal_OpenPin(pin.number)) {
+        STM32F4_TimerInternal_Release(treg, STM32F4_Timer_Owner::Counter);
+
+        return TinyCLR_Result::SharingViolation;
+    }
+
+    STM32F4_GpioInternal_ConfigurePin(pin.number, STM32F4_Gpio_PortMode::AlternateFunction, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, pin.alternateFunction);
+
+    state = config;
+    state.wraps = 0;
+    state.compare = 0;
+    state.handler = nullptr;
+
+    treg->CR1 = TIM_CR1_URS; // only overflow raises UIF
+    treg->CCER = 0;
+    treg->CCMR1 = TIM_CCMR1_CC1S_0; // IC1 on TI1, CC2 frozen output compare
+    treg->CCMR2 = 0;
+    treg->CCER = edge == STM32F4_Counter_Edge::Falling ? TIM_CCER_CC1P : 0;
+
+    // external clock mode 1 from TI1FP1, or from the TI1 edge detector to count both edges
+    treg->SMCR = (edge == STM32F4_Counter_Edge::Both ? TIM_SMCR_TS_2 : (TIM_SMCR_TS_2 | TIM_SMCR_TS_0)) | TIM_SMCR_SMS;
+
+    treg->PSC = 0;
+    treg->ARR = state.mask;
+    treg->EGR = TIM_EGR_UG;
+    treg->CNT = 0;
+    treg->SR = 0;
+    treg->DIER = TIM_DIER_UIE;
+
+    STM32F4_InterruptInternal_Activate(state.updateIrq, (uint32_t*)g_STM32F4_Counter_Isr[controller], 0, STM32F4_INTERRUPT_PRIORITY_COUNTER);
+
+    if (state.captureIrq != state.updateIrq)
+        STM32F4_InterruptInternal_Activate(state.captureIrq, (uint32_t*)g_STM32F4_Counter_Isr[controller], 0, STM32F4_INTERRUPT_PRIORITY_COUNTER);
+
+    treg->CR1 |= TIM_CR1_CEN;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Counter_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Counter_Controller[controller];
+    auto treg = state.timer;
+
+    if (treg == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    treg->CR1 = 0;
+    treg->DIER = 0;
+    treg->SMCR = 0;
+    treg->CCER = 0;
+
+    STM32F4_InterruptInternal_Deactivate(state.updateIrq);
+
+    if (state.captureIrq != state.updateIrq)
+        STM32F4_InterruptInternal_Deactivate(state.captureIrq);
+
+    STM32F4_TimerInternal_Release(treg, STM32F4_Timer_Owner::Counter);
+
+    auto& pin = g_STM32F4_Counter_Pins[controller][STM32F4_COUNTER_PIN];
+
+    STM32F4_GpioInternal_ConfigurePin(pin.number, STM32F4_Gpio_PortMode::Input, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, STM32F4_Gpio_AlternateFunction::AF0);
+    STM32F4_GpioInternal_ClosePin(pin.number);
+
+    state.timer = nullptr;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Counter_GetCount(int32_t controller, uint64_t& count) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Counter_Controller[controller];
+
+    if (state.timer == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    count = STM32F4_Counter_ReadCount(state);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Counter_ClearCount(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Counter_Controller[controller];
+
+    if (state.timer == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    state.timer->DIER &= ~TIM_DIER_CC2IE; // a pending compare refers to the old count
+    state.timer->CNT = 0;
+    state.timer->SR = ~TIM_SR_UIF;
+    state.wraps = 0;
+
+    return TinyCLR_Result::Success;
+}
+
+// handler runs in interrupt context once the count reaches compare, no interrupt is taken per edge
+TinyCLR_Result STM32F4_Counter_SetCompare(int32_t controller, uint64_t compare, STM32F4_Counter_CompareHandler handler) {
+    if (controller < 0 || controller >= TOTAL_COUNTER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Counter_Controller[controller];
+    auto treg = state.timer;
+
+    if (treg == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    treg->DIER &= ~TIM_DIER_CC2IE;
+
+    if (handler == nullptr)
+        return TinyCLR_Result::Success;
+
+    if (compare <= STM32F4_Counter_ReadCount(state))
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    state.compare = compare;
+    state.handler = handler;
+
+    treg->CCR2 = (uint32_t)compare & state.mask;
+    treg->SR = ~TIM_SR_CC2IF;
+    treg->DIER |= TIM_DIER_CC2IE;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
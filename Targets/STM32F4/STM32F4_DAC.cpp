@@ -23,6 +23,33 @@
 #define STM32F4_DAC_FIRST_PIN           4       // channel 0 pin (A4)
 #define STM32F4_DAC_RESOLUTION_INT_BIT    12      // max resolution in bit
 
+// streaming: channel 1 is triggered by TIM6 and fed by DMA1 stream 5, channel 2 by TIM7 and DMA1 stream 6, both on DMA channel 7
+#define STM32F4_DAC_DMA_CHANNEL (DMA_SxCR_CHSEL_2 | DMA_SxCR_CHSEL_1 | DMA_SxCR_CHSEL_0)
+#define STM32F4_DAC_DMA_MAX_LENGTH 0xFFFF
+
+#if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_DAC_TIMER_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ)
+#else
+#define STM32F4_DAC_TIMER_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
+#endif
+
+struct STM32F4_Dac_Playback {
+    DMA_Stream_TypeDef* stream;
+    TIM_TypeDef* timer;
+    IRQn_Type irq;
+    uint32_t trigger; // TSELx | TENx | DMAENx
+    uint32_t transferComplete;
+    uint32_t halfTransfer;
+    uint32_t transferError;
+    uint32_t flags; // every stream flag in DMA1->HISR
+
+    STM32F4_Dac_PlaybackHandler handler;
+    bool dual; // both channels from DHR12RD
+    bool active;
+};
+
+static STM32F4_Dac_Playback g_STM32F4_Dac_Playback[STM32F4_DAC_CHANNELS];
+
 static TinyCLR_Dac_Provider dacProvider;
 static TinyCLR_Api_Info dacApi;
 
@@ -88,6 +115,8 @@ TinyCLR_Result STM32F4_Dac_AcquireChannel(const TinyCLR_Dac_Provider* self, int3
 }
 
 TinyCLR_Result STM32F4_Dac_ReleaseChannel(const TinyCLR_Dac_Provider* self, int32_t channel) {
+    STM32F4_Dac_StopPlayback(self, channel);
+
     TinyCLR_Result releasePin = STM32F4_Gpio_ReleasePin(nullptr, STM32F4_DAC_FIRST_PIN + channel);
 
     if (releasePin != TinyCLR_Result::Success)
@@ -112,6 +141,9 @@ TinyCLR_Result STM32F4_Dac_ReleaseChannel(const TinyCLR_Dac_Provider* self, int3
 }
 
 TinyCLR_Result STM32F4_Dac_WriteValue(const TinyCLR_Dac_Provider* self, int32_t channel, int32_t value) {
+    if (g_STM32F4_Dac_Playback[channel ? 1 : 0].active || g_STM32F4_Dac_Playback[0].dual)
+        return TinyCLR_Result::InvalidOperation;
+
     value &= 0x00000FFF;
 
     if (channel)
@@ -122,6 +154,188 @@ TinyCLR_Result STM32F4_Dac_WriteValue(const TinyCLR_Dac_Provider* self, int32_t
     return TinyCLR_Result::Success;
 }
 
+static void STM32F4_Dac_DmaInterrupt(int32_t channel) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& playback = g_STM32F4_Dac_Playback[channel];
+    auto status = DMA1->HISR & playback.flags;
+
+    DMA1->HIFCR = status; // clear
+
+    if (status & playback.transferError) {
+        STM32F4_Dac_StopPlayback(nullptr, channel);
+
+        if (playback.handler != nullptr)
+            playback.handler(channel, STM32F4_Dac_PlaybackEvent::Error);
+
+        return;
+    }
+
+    if (status & playback.halfTransfer) {
+        if (playback.handler != nullptr)
+            playback.handler(channel, STM32F4_Dac_PlaybackEvent::HalfTransfer);
+    }
+
+    if (status & playback.transferComplete) {
+        if (!(playback.stream->CR & DMA_SxCR_CIRC)) // single shot is done
+            STM32F4_Dac_StopPlayback(nullptr, channel);
+
+        if (playback.handler != nullptr)
+            playback.handler(channel, STM32F4_Dac_PlaybackEvent::TransferComplete);
+    }
+}
+
+void STM32F4_Dac_Interrupt1(void* param) { // DMA1 stream 5
+    STM32F4_Dac_DmaInterrupt(0);
+}
+
+void STM32F4_Dac_Interrupt2(void* param) { // DMA1 stream 6
+    STM32F4_Dac_DmaInterrupt(1);
+}
+
+static TinyCLR_Result STM32F4_Dac_StartStream(int32_t channel, bool dual, const void* buffer, size_t length, uint32_t& sampleRate, bool circular, STM32F4_Dac_PlaybackHandler handler) {
+    if (buffer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    // a sample clock divider of 1 would leave ARR at 0
+    if (channel < 0 || channel >= STM32F4_DAC_CHANNELS || length == 0 || length > STM32F4_DAC_DMA_MAX_LENGTH || sampleRate == 0 || sampleRate > STM32F4_DAC_TIMER_CLOCK_HZ / 2)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& playback = g_STM32F4_Dac_Playback[channel];
+
+    uint32_t enabled = dual ? (DAC_CR_EN1 | DAC_CR_EN2) : (channel ? DAC_CR_EN2 : DAC_CR_EN1);
+
+    if ((DAC->CR & enabled) != enabled) // channel not acquired
+        return TinyCLR_Result::InvalidOperation;
+
+    // checked before the fields below are filled, they belong to a running playback
+    if (playback.active || g_STM32F4_Dac_Playback[0].dual || (dual && g_STM32F4_Dac_Playback[1].active))
+        return TinyCLR_Result::InvalidOperation;
+
+    if (channel) {
+#ifdef TIM7
+        playback.stream = DMA1_Stream6;
+        playback.timer = TIM7;
+        playback.irq = DMA1_Stream6_IRQn;
+        playback.trigger = DAC_CR_TSEL2_1 | DAC_CR_TEN2 | DAC_CR_DMAEN2; // TIM7 TRGO
+        playback.transferComplete = DMA_HISR_TCIF6;
+        playback.halfTransfer = DMA_HISR_HTIF6;
+        playback.transferError = DMA_HISR_TEIF6;
+        playback.flags = DMA_HISR_TCIF6 | DMA_HISR_HTIF6 | DMA_HISR_TEIF6 | DMA_HISR_DMEIF6 | DMA_HISR_FEIF6;
+#else
+        return TinyCLR_Result::NotSupported;
+#endif
+    }
+    else {
+        playback.stream = DMA1_Stream5;
+        playback.timer = TIM6;
+        playback.irq = DMA1_Stream5_IRQn;
+        playback.trigger = DAC_CR_TEN1 | DAC_CR_DMAEN1 | (dual ? DAC_CR_TEN2 : 0); // TIM6 TRGO
+        playback.transferComplete = DMA_HISR_TCIF5;
+        playback.halfTransfer = DMA_HISR_HTIF5;
+        playback.transferError = DMA_HISR_TEIF5;
+        playback.flags = DMA_HISR_TCIF5 | DMA_HISR_HTIF5 | DMA_HISR_TEIF5 | DMA_HISR_DMEIF5 | DMA_HISR_FEIF5;
+    }
+
+    auto timer = playback.timer;
+    auto stream = playback.stream;
+
+    if (stream->CR & DMA_SxCR_EN) // stream taken by a PWM sequence or capture
+        return TinyCLR_Result::SharingViolation;
+
+    if (!STM32F4_TimerInternal_Acquire(timer, STM32F4_Timer_Owner::Dac)) // timer used by PWM or another driver
+        return TinyCLR_Result::SharingViolation;
+
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+
+    // sample clock
+    uint32_t divider = STM32F4_DAC_TIMER_CLOCK_HZ / sampleRate;
+    uint32_t prescaler = (divider - 1) / 0x10000;
+    uint32_t period = divider / (prescaler + 1);
+
+    timer->CR1 = 0;
+    timer->PSC = prescaler;
+    timer->ARR = period - 1;
+    timer->CR2 = TIM_CR2_MMS_1; // update event as TRGO
+    timer->EGR = TIM_EGR_UG; // load prescaler
+
+    sampleRate = STM32F4_DAC_TIMER_CLOCK_HZ / ((prescaler + 1) * period);
+
+    DMA1->HIFCR = playback.flags;
+
+    stream->PAR = (uint32_t)(dual ? &DAC->DHR12RD : (channel ? &DAC->DHR12R2 : &DAC->DHR12R1));
+    stream->M0AR = (uint32_t)buffer;
+    stream->NDTR = length;
+    stream->FCR = 0; // direct mode
+    stream->CR = STM32F4_DAC_DMA_CHANNEL | DMA_SxCR_PL_1 | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_TCIE | DMA_SxCR_TEIE
+        | (dual ? (DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1) : (DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0)) // one word carries both channels
+        | (circular ? (DMA_SxCR_CIRC | DMA_SxCR_HTIE) : 0);
+
+    playback.handler = handler;
+    playback.dual = dual;
+    playback.active = true;
+
+    STM32F4_InterruptInternal_Activate(playback.irq, channel ? (uint32_t*)&STM32F4_Dac_Interrupt2 : (uint32_t*)&STM32F4_Dac_Interrupt1, 0, STM32F4_INTERRUPT_PRIORITY_DAC);
+
+    stream->CR |= DMA_SxCR_EN;
+
+    DAC->SR = channel ? DAC_SR_DMAUDR2 : DAC_SR_DMAUDR1;
+    DAC->CR |= playback.trigger;
+
+    timer->CR1 = TIM_CR1_CEN;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Dac_StartPlayback(const TinyCLR_Dac_Provider* self, int32_t channel, const uint16_t* buffer, size_t length, uint32_t& sampleRate, bool circular, STM32F4_Dac_PlaybackHandler handler) {
+    return STM32F4_Dac_StartStream(channel, false, buffer, length, sampleRate, circular, handler);
+}
+
+// each word is one sample pair, channel 1 in bits 0..11 and channel 2 in bits 16..27
+TinyCLR_Result STM32F4_Dac_StartDualPlayback(const TinyCLR_Dac_Provider* self, const uint32_t* buffer, size_t length, uint32_t& sampleRate, bool circular, STM32F4_Dac_PlaybackHandler handler) {
+    return STM32F4_Dac_StartStream(0, true, buffer, length, sampleRate, circular, handler);
+}
+
+TinyCLR_Result STM32F4_Dac_StopPlayback(const TinyCLR_Dac_Provider* self, int32_t channel) {
+    if (channel < 0 || channel >= STM32F4_DAC_CHANNELS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (g_STM32F4_Dac_Playback[0].dual) // dual playback runs on channel 1 resources
+        channel = 0;
+
+    auto& playback = g_STM32F4_Dac_Playback[channel];
+
+    if (!playback.active)
+        return TinyCLR_Result::Success;
+
+    playback.timer->CR1 = 0;
+    playback.stream->CR = 0;
+
+    DAC->CR &= ~playback.trigger;
+    DMA1->HIFCR = playback.flags;
+
+    STM32F4_InterruptInternal_Deactivate(playback.irq);
+
+    STM32F4_TimerInternal_Release(playback.timer, STM32F4_Timer_Owner::Dac);
+
+    playback.dual = false;
+    playback.active = false;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Dac_WriteDualValue(const TinyCLR_Dac_Provider* self, int32_t value1, int32_t value2) {
+    if ((DAC->CR & (DAC_CR_EN1 | DAC_CR_EN2)) != (DAC_CR_EN1 | DAC_CR_EN2))
+        return TinyCLR_Result::InvalidOperation;
+
+    if (g_STM32F4_Dac_Playback[0].active || g_STM32F4_Dac_Playback[1].active)
+        return TinyCLR_Result::InvalidOperation;
+
+    DAC->DHR12RD = ((value2 & 0x00000FFF) << 16) | (value1 & 0x00000FFF); // both outputs latch together
+
+    return TinyCLR_Result::Success;
+}
+
 int32_t STM32F4_Dac_GetChannelCount(const TinyCLR_Dac_Provider* self) {
     return STM32F4_DAC_CHANNELS;
 }
@@ -0,0 +1,331 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "STM32F4.h"
+
+#ifdef INCLUDE_PWM
+///////////////////////////////////////////////////////////////////////////////
+
+// encoder mode runs on the PWM timers and pins: controller x is TIM(x + 1), A on CH1, B on CH2, index on CH3
+#define STM32F4_ENCODER_CHANNELS 4
+#define STM32F4_ENCODER_PIN_A 0
+#define STM32F4_ENCODER_PIN_B 1
+#define STM32F4_ENCODER_PIN_INDEX 2
+#define STM32F4_ENCODER_INPUT_FILTER 3 // fCK_INT, N = 8
+
+struct STM32F4_Encoder_Controller {
+    TIM_TypeDef* timer;
+    uint32_t updateIrq;
+    uint32_t captureIrq;
+    uint32_t mask; // counter range - 1
+    bool useIndex;
+
+    int64_t wraps; // counter over/underflows, extends the count to 64 bit
+    int64_t offset;
+
+    int64_t lastPosition; // velocity sample
+    uint64_t lastTicks;
+
+    STM32F4_Encoder_IndexHandler handler;
+};
+
+static STM32F4_Gpio_Pin g_STM32F4_Encoder_Pins[][STM32F4_ENCODER_CHANNELS] = STM32F4_PWM_PINS;
+
+static const int TOTAL_ENCODER_CONTROLLERS = SIZEOF_ARRAY(g_STM32F4_Encoder_Pins);
+
+static STM32F4_Encoder_Controller g_STM32F4_Encoder_Controller[TOTAL_ENCODER_CONTROLLERS];
+
+static bool STM32F4_Encoder_GetTimer(int32_t controller, STM32F4_Encoder_Controller& state) {
+    switch (controller) {
+    case 0: state.timer = TIM1; state.updateIrq = TIM1_UP_TIM10_IRQn; state.captureIrq = TIM1_CC_IRQn; break;
+    case 1: state.timer = TIM2; state.updateIrq = state.captureIrq = TIM2_IRQn; break;
+    case 2: state.timer = TIM3; state.updateIrq = state.captureIrq = TIM3_IRQn; break;
+    case 3: state.timer = TIM4; state.updateIrq = state.captureIrq = TIM4_IRQn; break;
+#if !defined(STM32F401xE) && !defined(STM32F411xE)
+    case 4: state.timer = TIM5; state.updateIrq = state.captureIrq = TIM5_IRQn; break;
+    case 7: state.timer = TIM8; state.updateIrq = TIM8_UP_TIM13_IRQn; state.captureIrq = TIM8_CC_IRQn; break;
+#endif
+    default:
+        return false;
+    }
+
+    state.mask = (controller == 1 || controller == 4) ? 0xFFFFFFFF : 0xFFFF; // TIM2 and TIM5 are 32 bit
+
+    return true;
+}
+
+// the counter starts at half range so an encoder dithering around its start never crosses the wrap point
+static uint32_t STM32F4_Encoder_GetCenter(STM32F4_Encoder_Controller& state) {
+    return (state.mask >> 1) + 1;
+}
+
+static int64_t STM32F4_Encoder_GetWrap(STM32F4_Encoder_Controller& state, uint32_t count) {
+    // the counter sits near 0 after an overflow and near the top after an underflow,
+    // it only gets back to the wrap point after moving half a range
+    return count <= (state.mask >> 1) ? 1 : -1;
+}
+
+static int64_t STM32F4_Encoder_ReadPosition(STM32F4_Encoder_Controller& state) {
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto treg = state.timer;
+    uint32_t count = treg->CNT & state.mask;
+    int64_t wraps = state.wraps;
+
+    if (treg->SR & TIM_SR_UIF) { // wrap not yet seen by the interrupt
+        count = treg->CNT & state.mask;
+        wraps += STM32F4_Encoder_GetWrap(state, count);
+    }
+
+    return wraps * ((int64_t)state.mask + 1) + count + state.offset;
+}
+
+static void STM32F4_Encoder_InterruptHandler(int32_t controller) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& state = g_STM32F4_Encoder_Controller[controller];
+    auto treg = state.timer;
+    auto sr = treg->SR;
+
+    if (sr & TIM_SR_UIF) {
+        treg->SR = ~TIM_SR_UIF;
+
+        state.wraps += STM32F4_Encoder_GetWrap(state, treg->CNT & state.mask);
+    }
+
+    if (sr & TIM_SR_CC3IF) {
+        uint32_t count = treg->CCR3; // clears CC3IF
+
+        treg->SR = ~TIM_SR_CC3OF;
+
+        if (state.handler != nullptr)
+            state.handler(controller, state.wraps * ((int64_t)state.mask + 1) + count + state.offset);
+    }
+}
+
+void STM32F4_Encoder_InterruptHandler1(void* param) { STM32F4_Encoder_InterruptHandler(0); }
+void STM32F4_Encoder_InterruptHandler2(void* param) { STM32F4_Encoder_InterruptHandler(1); }
+void STM32F4_Encoder_InterruptHandler3(void* param) { STM32F4_Encoder_InterruptHandler(2); }
+void STM32F4_Encoder_InterruptHandler4(void* param) { STM32F4_Encoder_InterruptHandler(3); }
+void STM32F4_Encoder_InterruptHandler5(void* param) { STM32F4_Encoder_InterruptHandler(4); }
+void STM32F4_Encoder_InterruptHandler8(void* param) { STM32F4_Encoder_InterruptHandler(7); }
+
+static void (* const g_STM32F4_Encoder_Isr[])(void*) = {
+    &STM32F4_Encoder_InterruptHandler1, &STM32F4_Encoder_InterruptHandler2, &STM32F4_Encoder_InterruptHandler3, &STM32F4_Encoder_InterruptHandler4,
+    &STM32F4_Encoder_InterruptHandler5, nullptr, nullptr, &STM32F4_Encoder_InterruptHandler8
+};
+
+static void STM32F4_Encoder_ClosePins(int32_t controller, int32_t count) {
+    for (auto i = 0; i < count; i++) {
+        auto& pin = g_STM32F4_Encoder_Pins[controller][i];
+
+        STM32F4_GpioInternal_ConfigurePin(pin.number, STM32F4_Gpio_PortMode::Input, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, STM32F4_Gpio_AlternateFunction::AF0);
+        STM32F4_GpioInternal_ClosePin(pin.number);
+    }
+}
+
+static TinyCLR_Result STM32F4_Encoder_OpenPins(int32_t controller, int32_t count) {
+    for (auto i = 0; i < count; i++) {
+        auto& pin = g_STM32F4_Encoder_Pins[controller][i];
+
+        if (pin.number == PIN_NONE || !STM32F4_GpioInternal_OpenPin(pin.number)) {
+            STM32F4_Encoder_ClosePins(controller, i);
+
+            return pin.number == PIN_NONE ? TinyCLR_Result::NotSupported : TinyCLR_Result::SharingViolation;
+        }
+
+        STM32F4_GpioInternal_ConfigurePin(pin.number, STM32F4_Gpio_PortMode::AlternateFunction, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::PullUp, pin.alternateFunction);
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Encoder_Acquire(int32_t controller, STM32F4_Encoder_Mode mode, bool useIndex) {
+    if (controller < 0 || controller >= TOTAL_ENCODER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Encoder_Controller[controller];
+
+    if (state.timer != nullptr)
+        return TinyCLR_Result::SharingViolation;
+
+    STM32F4_Encoder_Controller config;
+
+    if (!STM32F4_Encoder_GetTimer(controller, config))
+        return TinyCLR_Result::NotSupported;
+
+    auto treg = config.timer;
+
+    if (!STM32F4_TimerInternal_Acquire(treg, STM32F4_Timer_Owner::Encoder)) // timer used by PWM, capture or another driver
+        return TinyCLR_Result::SharingViolation;
+
+    auto result = STM32F4_Encoder_OpenPins(controller, useIndex ? 3 : 2);
+
+    if (result != TinyCLR_Result::Success) {
+        STM32F4_TimerInternal_Release(treg, STM32F4_Timer_Owner::Encoder);
+
+        return result;
+    }
+
+    state = config;
+    state.useIndex = useIndex;
+    state.wraps = 0;
+    state.offset = -(int64_t)STM32F4_Encoder_GetCenter(state);
+    state.lastPosition = 0;
+    state.lastTicks = STM32F4_Time_GetCurrentProcessorTicks(nullptr);
+    state.handler = nullptr;
+
+    treg->CR1 = TIM_CR1_URS; // only over/underflow raises UIF
+    treg->CCER = 0;
+    treg->CCMR1 = ((STM32F4_ENCODER_INPUT_FILTER << 4) | TIM_CCMR1_CC1S_0) | (((STM32F4_ENCODER_INPUT_FILTER << 4) | TIM_CCMR1_CC1S_0) << 8); // IC1 on TI1, IC2 on TI2
+    treg->CCMR2 = useIndex ? ((STM32F4_ENCODER_INPUT_FILTER << 4) | TIM_CCMR2_CC3S_0) : 0; // IC3 on TI3 latches the count at the index
+    treg->CCER = useIndex ? TIM_CCER_CC3E : 0;
+    treg->SMCR = mode == STM32F4_Encoder_Mode::X4 ? (TIM_SMCR_SMS_1 | TIM_SMCR_SMS_0) : TIM_SMCR_SMS_0; // encoder mode 3 or 1
+    treg->PSC = 0;
+    treg->ARR = state.mask;
+    treg->EGR = TIM_EGR_UG;
+    treg->CNT = STM32F4_Encoder_GetCenter(state);
+    treg->SR = 0;
+    treg->DIER = TIM_DIER_UIE | (useIndex ? TIM_DIER_CC3IE : 0);
+
+    STM32F4_InterruptInternal_Activate(state.updateIrq, (uint32_t*)g_STM32F4_Encoder_Isr[controller], 0, STM32F4_INTERRUPT_PRIORITY_COUNTER);
+
+    if (state.captureIrq != state.updateIrq)
+        STM32F4_InterruptInternal_Activate(state.captureIrq, (uint32_t*)g_STM32F4_Encoder_Isr[controller], 0, STM32F4_INTERRUPT_PRIORITY_COUNTER);
+
+    treg->CR1 |= TIM_CR1_CEN;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Encoder_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_ENCODER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Encoder_Controller[controller];
+    auto treg = state.timer;
+
+    if (treg == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    treg->CR1 = 0;
+    treg->DIER = 0;
+    treg->SMCR = 0;
+    treg->CCER = 0;
+
+    STM32F4_InterruptInternal_Deactivate(state.updateIrq);
+
+    if (state.captureIrq != state.updateIrq)
+        STM32F4_InterruptInternal_Deactivate(state.captureIrq);
+
+    STM32F4_TimerInternal_Release(treg, STM32F4_Timer_Owner::Encoder);
+
+    STM32F4_Encoder_ClosePins(controller, state.useIndex ? 3 : 2);
+
+    state.timer = nullptr;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Encoder_GetPosition(int32_t controller, int64_t& position) {
+    if (controller < 0 || controller >= TOTAL_ENCODER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Encoder_Controller[controller];
+
+    if (state.timer == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    position = STM32F4_Encoder_ReadPosition(state);
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Encoder_SetPosition(int32_t controller, int64_t position) {
+    if (controller < 0 || controller >= TOTAL_ENCODER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Encoder_Controller[controller];
+
+    if (state.timer == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    state.timer->CNT = STM32F4_Encoder_GetCenter(state);
+    state.timer->SR = ~TIM_SR_UIF;
+    state.wraps = 0;
+    state.offset = position - STM32F4_Encoder_GetCenter(state);
+    state.lastPosition = position;
+    state.lastTicks = STM32F4_Time_GetCurrentProcessorTicks(nullptr);
+
+    return TinyCLR_Result::Success;
+}
+
+// forward is true while the counter counts up
+TinyCLR_Result STM32F4_Encoder_GetDirection(int32_t controller, bool& forward) {
+    if (controller < 0 || controller >= TOTAL_ENCODER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Encoder_Controller[controller];
+
+    if (state.timer == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    forward = !(state.timer->CR1 & TIM_CR1_DIR);
+
+    return TinyCLR_Result::Success;
+}
+
+// counts per second averaged since the previous call
+TinyCLR_Result STM32F4_Encoder_GetVelocity(int32_t controller, int32_t& countsPerSecond) {
+    if (controller < 0 || controller >= TOTAL_ENCODER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Encoder_Controller[controller];
+
+    if (state.timer == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    auto ticks = STM32F4_Time_GetCurrentProcessorTicks(nullptr);
+    auto position = STM32F4_Encoder_ReadPosition(state);
+    auto elapsed = STM32F4_Time_GetTimeForProcessorTicks(nullptr, ticks - state.lastTicks); // 100ns units
+
+    if (elapsed == 0)
+        return TinyCLR_Result::NotAvailable;
+
+    countsPerSecond = (int32_t)((position - state.lastPosition) * 10000000 / (int64_t)elapsed);
+
+    state.lastPosition = position;
+    state.lastTicks = ticks;
+
+    return TinyCLR_Result::Success;
+}
+
+// handler runs in interrupt context with the position latched by the index pulse
+TinyCLR_Result STM32F4_Encoder_SetIndexHandler(int32_t controller, STM32F4_Encoder_IndexHandler handler) {
+    if (controller < 0 || controller >= TOTAL_ENCODER_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_Encoder_Controller[controller];
+
+    if (state.timer == nullptr || !state.useIndex)
+        return TinyCLR_Result::InvalidOperation;
+
+    state.handler = handler;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
@@ -29,6 +29,28 @@ void STM32F4_Gpio_Reset();
 // indexed port configuration access
 #define Port(port) ((GPIO_TypeDef *) (GPIOA_BASE + (port << 10)))
 
+// debounced lines are masked on their first edge and sampled again by one shared timer after the debounce time
+#if defined(TIM12)
+#define STM32F4_Gpio_DebounceTimer              TIM12
+#define STM32F4_Gpio_DebounceTimerIrq           TIM8_BRK_TIM12_IRQn
+#else
+#define STM32F4_Gpio_DebounceTimer              TIM11
+#define STM32F4_Gpio_DebounceTimerIrq           TIM1_TRG_COM_TIM11_IRQn
+#endif
+#define STM32F4_Gpio_DebounceTimerHz            2000 // 16 bit counter, deadlines up to 16s
+
+#if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_Gpio_APB1_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ)
+#else
+#define STM32F4_Gpio_APB1_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
+#endif
+
+#if STM32F4_APB2_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_Gpio_APB2_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ)
+#else
+#define STM32F4_Gpio_APB2_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ * 2)
+#endif
+
 struct STM32F4_Int_State {
     uint8_t                                pin;      // pin number
     uint32_t                               debounce; // debounce
@@ -37,12 +59,30 @@ struct STM32F4_Int_State {
     const TinyCLR_Gpio_Provider* controller; // controller
     TinyCLR_Gpio_ValueChangedHandler       ISR; // interrupt handler
     TinyCLR_Gpio_PinValue                  currentValue;
+    TinyCLR_Gpio_PinValue                  lastValue; // last value reported
+    uint16_t                               debounceDeadline; // debounce timer count
 };
 
 static bool                     g_pinReserved[STM32F4_Gpio_MaxPins]; //  1 bit per pin
 static uint32_t                         g_debounceTicksPin[STM32F4_Gpio_MaxPins];
 static STM32F4_Int_State            g_int_state[STM32F4_Gpio_MaxInt]; // interrupt state
 static TinyCLR_Gpio_PinDriveMode     g_pinDriveMode[STM32F4_Gpio_MaxPins];
+static uint16_t                         g_debounceTimerTicksPin[STM32F4_Gpio_MaxPins];
+static uint32_t                         g_debouncing; // 1 bit per masked line
+static bool                             g_debounceTimerOwned;
+
+// power of two, edges of queued pins are stored here by the interrupt and drained by ReadEvents or DispatchEvents
+#define STM32F4_Gpio_EventQueueSize                64
+
+struct STM32F4_Gpio_EventQueue {
+    volatile STM32F4_Gpio_Event                    events[STM32F4_Gpio_EventQueueSize];
+    volatile uint32_t                           head; // written by the interrupt only
+    volatile uint32_t                           tail; // written by the reader only
+    volatile uint32_t                           lost;
+};
+
+static bool                         g_eventQueued[STM32F4_Gpio_MaxPins];
+static STM32F4_Gpio_EventQueue          g_eventQueue;
 
 static TinyCLR_Gpio_Provider gpioProvider;
 static TinyCLR_Api_Info gpioApi;
@@ -88,6 +128,167 @@ TinyCLR_Result STM32F4_Gpio_Release(const TinyCLR_Gpio_Provider* self) {
     return TinyCLR_Result::Success;
 }
 
+// single producer: all pin interrupts run at the same priority and never preempt each other
+static void STM32F4_Gpio_PushEvent(int32_t pin, TinyCLR_Gpio_PinValue value) {
+    auto head = g_eventQueue.head;
+
+    if (head - g_eventQueue.tail >= STM32F4_Gpio_EventQueueSize) {
+        g_eventQueue.lost++;
+
+        return;
+    }
+
+    auto& event = g_eventQueue.events[head % STM32F4_Gpio_EventQueueSize];
+
+    event.pin = pin;
+    event.value = value;
+    event.ticks = STM32F4_Time_GetCurrentProcessorTicks(nullptr);
+
+    g_eventQueue.head = head + 1; // publish after the event is complete
+}
+
+static void STM32F4_Gpio_Report(STM32F4_Int_State* state) {
+    state->lastValue = state->currentValue;
+
+    if (g_eventQueued[state->pin])
+        STM32F4_Gpio_PushEvent(state->pin, state->currentValue);
+    else
+        state->ISR(state->controller, state->pin, state->currentValue);
+}
+
+// compare on the nearest deadline, called with interrupts disabled
+static void STM32F4_Gpio_DebounceSchedule() {
+    auto treg = STM32F4_Gpio_DebounceTimer;
+    uint16_t now = treg->CNT;
+    int32_t next = 0x8000;
+
+    for (auto pending = g_debouncing; pending; ) {
+        auto num = 31 - __CLZ(pending);
+
+        pending &= ~(1 << num);
+
+        int32_t remaining = (int16_t)(g_int_state[num].debounceDeadline - now);
+
+        if (remaining < next)
+            next = remaining;
+    }
+
+    if (next == 0x8000) {
+        treg->DIER = 0;
+
+        return;
+    }
+
+    if (next < 1)
+        next = 1;
+
+    uint16_t compare = now + next;
+
+    treg->CCR1 = compare;
+    treg->SR = ~TIM_SR_CC1IF;
+    treg->DIER = TIM_DIER_CC1IE;
+
+    if ((int16_t)((uint16_t)treg->CNT - compare) >= 0) // passed while programming
+        treg->EGR = TIM_EGR_CC1G;
+}
+
+static void STM32F4_Gpio_DebounceStart(int32_t num) {
+    auto state = &g_int_state[num];
+
+    state->debounceDeadline = (uint16_t)(STM32F4_Gpio_DebounceTimer->CNT + g_debounceTimerTicksPin[state->pin]);
+
+    g_debouncing |= 1 << num;
+
+    STM32F4_Gpio_DebounceSchedule();
+}
+
+void STM32F4_Gpio_DebounceInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    auto treg = STM32F4_Gpio_DebounceTimer;
+
+    treg->SR = ~TIM_SR_CC1IF;
+
+    uint16_t now = treg->CNT;
+
+    for (auto pending = g_debouncing; pending; ) {
+        auto num = 31 - __CLZ(pending);
+        uint32_t bit = 1 << num;
+
+        pending &= ~bit;
+
+        auto state = &g_int_state[num];
+
+        if ((int16_t)(now - state->debounceDeadline) < 0)
+            continue;
+
+        EXTI->PR = bit; // drop the bounces, an edge after the sample below is pending again
+
+        STM32F4_Gpio_Read(nullptr, state->pin, state->currentValue);
+
+        if (state->ISR && state->currentValue != state->lastValue) { // settled on the other level, that is an edge of its own
+            state->debounceDeadline = now + g_debounceTimerTicksPin[state->pin];
+
+            STM32F4_Gpio_Report(state);
+
+            continue;
+        }
+
+        g_debouncing &= ~bit;
+
+        if (state->ISR)
+            EXTI->IMR |= bit;
+    }
+
+    STM32F4_Gpio_DebounceSchedule();
+}
+
+// a busy timer leaves debounce to the tick compare in the edge interrupt
+static bool STM32F4_Gpio_DebounceTimerAcquire() {
+    if (g_debounceTimerOwned)
+        return true;
+
+    if (!STM32F4_TimerInternal_Acquire(STM32F4_Gpio_DebounceTimer, STM32F4_Timer_Owner::Debounce)) // timer used by PWM or another driver
+        return false;
+
+    auto treg = STM32F4_Gpio_DebounceTimer;
+    uint32_t clock = ((uint32_t)treg & 0x10000) ? STM32F4_Gpio_APB2_CLOCK_HZ : STM32F4_Gpio_APB1_CLOCK_HZ;
+
+    treg->CR1 = 0;
+    treg->DIER = 0;
+    treg->CCMR1 = 0; // CC1 frozen output compare
+    treg->PSC = clock / STM32F4_Gpio_DebounceTimerHz - 1;
+    treg->ARR = 0xFFFF;
+    treg->EGR = TIM_EGR_UG;
+    treg->SR = 0;
+
+    STM32F4_InterruptInternal_Activate(STM32F4_Gpio_DebounceTimerIrq, (uint32_t*)&STM32F4_Gpio_DebounceInterrupt, 0, STM32F4_INTERRUPT_PRIORITY_GPIO);
+
+    treg->CR1 = TIM_CR1_CEN;
+
+    g_debounceTimerOwned = true;
+
+    return true;
+}
+
+static void STM32F4_Gpio_DebounceTimerRelease() {
+    g_debouncing = 0;
+
+    if (!g_debounceTimerOwned)
+        return;
+
+    STM32F4_Gpio_DebounceTimer->CR1 = 0;
+    STM32F4_Gpio_DebounceTimer->DIER = 0;
+
+    STM32F4_InterruptInternal_Deactivate(STM32F4_Gpio_DebounceTimerIrq);
+
+    STM32F4_TimerInternal_Release(STM32F4_Gpio_DebounceTimer, STM32F4_Timer_Owner::Debounce);
+
+    g_debounceTimerOwned = false;
+}
+
 /*
  * Interrupt Handler
  */
@@ -108,6 +309,17 @@ void STM32F4_Gpio_ISR(int num)  // 0 <= num <= 15
     EXTI->PR = bit;   // reset pending bit
 
     if (state->ISR) {
+        if (state->debounce && g_debounceTimerOwned) {
+            EXTI->IMR &= ~bit; // no more edges until the line is sampled again
+
+            STM32F4_Gpio_DebounceStart(num);
+
+            if (state->currentValue != state->lastValue)
+                STM32F4_Gpio_Report(state);
+
+            return;
+        }
+
         if (state->debounce) {   // debounce enabled
             if ((STM32F4_Time_GetCurrentProcessorTicks(nullptr) - state->lastDebounceTicks) >= g_debounceTicksPin[state->pin]) {
                 state->lastDebounceTicks = STM32F4_Time_GetCurrentProcessorTicks(nullptr);
@@ -119,7 +331,7 @@ void STM32F4_Gpio_ISR(int num)  // 0 <= num <= 15
         }
 
         if (executeIsr)
-            state->ISR(state->controller, state->pin, state->currentValue);
+            STM32F4_Gpio_Report(state);
     }
 }
 
@@ -168,6 +380,67 @@ void STM32F4_Gpio_Interrupt10(void* param) // EXTI10 - EXTI15
     } while (pending);
 }
 
+// queued pins keep their value changed handler installed but it is no longer called from the interrupt,
+// the edges are timestamped and kept until the owner drains them from thread context
+TinyCLR_Result STM32F4_Gpio_SetEventQueueEnabled(const TinyCLR_Gpio_Provider* self, int32_t pin, bool enabled) {
+    if (pin < 0 || pin >= STM32F4_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    g_eventQueued[pin] = enabled;
+
+    return TinyCLR_Result::Success;
+}
+
+// single consumer: count is the capacity of events on entry and the number of events read on return
+TinyCLR_Result STM32F4_Gpio_ReadEvents(const TinyCLR_Gpio_Provider* self, STM32F4_Gpio_Event* events, size_t& count) {
+    auto tail = g_eventQueue.tail;
+    auto available = g_eventQueue.head - tail;
+    size_t read = 0;
+
+    while (read < count && read < available) {
+        auto& event = g_eventQueue.events[tail % STM32F4_Gpio_EventQueueSize];
+
+        events[read].pin = event.pin;
+        events[read].value = event.value;
+        events[read].ticks = event.ticks;
+
+        tail++;
+        read++;
+    }
+
+    g_eventQueue.tail = tail; // free the slots after they are copied
+
+    count = read;
+
+    return TinyCLR_Result::Success;
+}
+
+// calls the value changed handler of each queued edge in order, in the context of the caller
+TinyCLR_Result STM32F4_Gpio_DispatchEvents(const TinyCLR_Gpio_Provider* self) {
+    STM32F4_Gpio_Event events[8];
+    size_t count;
+
+    do {
+        count = SIZEOF_ARRAY(events);
+
+        STM32F4_Gpio_ReadEvents(self, events, count);
+
+        for (size_t i = 0; i < count; i++) {
+            auto state = &g_int_state[events[i].pin & 0x0F];
+
+            if (state->ISR && state->pin == events[i].pin)
+                state->ISR(state->controller, events[i].pin, events[i].value);
+        }
+    } while (count == SIZEOF_ARRAY(events));
+
+    return TinyCLR_Result::Success;
+}
+
+// edges dropped because the queue was full
+uint32_t STM32F4_Gpio_GetLostEventCount(const TinyCLR_Gpio_Provider* self) {
+    return g_eventQueue.lost;
+}
+
 TinyCLR_Result STM32F4_Gpio_SetValueChangedHandler(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_ValueChangedHandler isr) {
     uint32_t num = pin & 0x0F;
     uint32_t bit = 1 << num;
@@ -193,6 +466,13 @@ TinyCLR_Result STM32F4_Gpio_SetValueChangedHandler(const TinyCLR_Gpio_Provider*
         state->ISR = isr;
         state->lastDebounceTicks = STM32F4_Time_GetCurrentProcessorTicks(nullptr);
 
+        STM32F4_Gpio_Read(self, pin, state->lastValue);
+
+        g_debouncing &= ~bit;
+
+        if (state->debounce)
+            STM32F4_Gpio_DebounceTimerAcquire();
+
         EXTI->RTSR &= ~bit;
         EXTI->FTSR &= ~bit;
 
@@ -208,6 +488,7 @@ TinyCLR_Result STM32F4_Gpio_SetValueChangedHandler(const TinyCLR_Gpio_Provider*
     else if ((SYSCFG->EXTICR[idx] & mask) == config) {
         EXTI->IMR &= ~bit; // disable interrupt
         state->ISR = 0;
+        g_debouncing &= ~bit;
     }
     return TinyCLR_Result::Success;
 }
@@ -223,6 +504,7 @@ bool STM32F4_Gpio_DisableInterrupt(uint32_t pin) {
     if ((SYSCFG->EXTICR[idx] & mask) == config) {
         EXTI->IMR &= ~bit; // disable interrupt
         state->ISR = 0;
+        g_debouncing &= ~bit;
     }
     return true;
 }
@@ -327,6 +609,137 @@ TinyCLR_Result STM32F4_Gpio_Write(const TinyCLR_Gpio_Provider* self, int32_t pin
     return TinyCLR_Result::Success;
 }
 
+TinyCLR_Result STM32F4_Gpio_ReadPort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t& value) {
+    if (port < 0 || port >= (STM32F4_Gpio_MaxPins + 15) / 16)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    value = Port(port)->IDR & 0xFFFF;
+
+    return TinyCLR_Result::Success;
+}
+
+// pins in mask take their bit from value in a single BSRR write, the others are untouched
+TinyCLR_Result STM32F4_Gpio_WritePort(const TinyCLR_Gpio_Provider* self, int32_t port, uint32_t mask, uint32_t value) {
+    if (port < 0 || port >= (STM32F4_Gpio_MaxPins + 15) / 16 || mask > 0xFFFF)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    Port(port)->BSRR = (value & mask) | ((~value & mask) << 16);
+
+    return TinyCLR_Result::Success;
+}
+
+// waveforms are timed with the DWT cycle counter and run with interrupts disabled
+#define STM32F4_Gpio_WaveformClockHz (STM32F4_AHB_CLOCK_HZ)
+
+static uint32_t STM32F4_Gpio_WaveformNanosecondsToCycles(uint32_t nanoseconds) {
+    return ((uint64_t)nanoseconds * STM32F4_Gpio_WaveformClockHz) / 1000000000;
+}
+
+static void STM32F4_Gpio_WaveformStart() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+// each step holds its level for its duration, the edges are placed against the start so the delays do not add up
+TinyCLR_Result STM32F4_Gpio_WriteWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, const STM32F4_Gpio_WaveformStep* steps, size_t count) {
+    if (pin < 0 || pin >= STM32F4_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (steps == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    GPIO_TypeDef* port = Port(pin >> 4);
+    uint32_t mask = 1 << (pin & 0x0F);
+
+    STM32F4_Gpio_WaveformStart();
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    uint32_t deadline = DWT->CYCCNT;
+
+    for (size_t i = 0; i < count; i++) {
+        port->BSRR = steps[i].value == TinyCLR_Gpio_PinValue::High ? mask : (mask << 16);
+
+        deadline += STM32F4_Gpio_WaveformNanosecondsToCycles(steps[i].duration);
+
+        while ((int32_t)(DWT->CYCCNT - deadline) < 0);
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+// durations receives the time between edges, starting from the call, until count edges are seen or
+// the pin stays unchanged for timeout nanoseconds. count returns the number of edges.
+TinyCLR_Result STM32F4_Gpio_CaptureWaveform(const TinyCLR_Gpio_Provider* self, int32_t pin, TinyCLR_Gpio_PinValue& initialValue, uint32_t* durations, size_t& count, uint32_t timeout) {
+    if (pin < 0 || pin >= STM32F4_Gpio_MaxPins)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (durations == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    GPIO_TypeDef* port = Port(pin >> 4);
+    uint32_t mask = 1 << (pin & 0x0F);
+
+    uint32_t timeoutCycles = STM32F4_Gpio_WaveformNanosecondsToCycles(timeout);
+    size_t captured = 0;
+
+    STM32F4_Gpio_WaveformStart();
+
+    {
+        DISABLE_INTERRUPTS_SCOPED(irq);
+
+        uint32_t level = (port->IDR & mask);
+        uint32_t last = DWT->CYCCNT;
+
+        initialValue = level ? TinyCLR_Gpio_PinValue::High : TinyCLR_Gpio_PinValue::Low;
+
+        while (captured < count) {
+            uint32_t now = DWT->CYCCNT;
+
+            if (((port->IDR & mask)) == level) {
+                if (now - last >= timeoutCycles)
+                    break;
+
+                continue;
+            }
+
+            level ^= mask;
+
+            durations[captured++] = now - last; // cycles for now, converted once the capture is over
+            last = now;
+        }
+    }
+
+    for (size_t i = 0; i < captured; i++)
+        durations[i] = ((uint64_t)durations[i] * 1000000000) / STM32F4_Gpio_WaveformClockHz;
+
+    count = captured;
+
+    return TinyCLR_Result::Success;
+}
+
+// GPIO ports are in the peripheral bit-band region
+#define STM32F4_Gpio_BitBand(address, bit) ((volatile uint32_t*)(PERIPH_BB_BASE + (((uint32_t)(address) - PERIPH_BASE) * 32) + ((bit) * 4)))
+
+// the handle stays valid until the pin is released, a BSRR bit reads as zero so each store only touches its own pin
+TinyCLR_Result STM32F4_Gpio_GetFastPin(const TinyCLR_Gpio_Provider* self, int32_t pin, STM32F4_Gpio_FastPin& fastPin) {
+    if (pin >= STM32F4_Gpio_MaxPins || pin == PIN_NONE)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (!g_pinReserved[pin])
+        return TinyCLR_Result::InvalidOperation;
+
+    GPIO_TypeDef* port = Port(pin >> 4);
+    uint32_t bit = pin & 0x0F;
+
+    fastPin.input = STM32F4_Gpio_BitBand(&port->IDR, bit);
+    fastPin.output = STM32F4_Gpio_BitBand(&port->ODR, bit);
+    fastPin.set = STM32F4_Gpio_BitBand(&port->BSRR, bit);
+    fastPin.clear = STM32F4_Gpio_BitBand(&port->BSRR, bit + 16);
+
+    return TinyCLR_Result::Success;
+}
+
 TinyCLR_Result STM32F4_Gpio_AcquirePin(const TinyCLR_Gpio_Provider* self, int32_t pin) {
     DISABLE_INTERRUPTS_SCOPED(irq);
 
@@ -425,6 +838,7 @@ TinyCLR_Result STM32F4_Gpio_SetDebounceTimeout(const TinyCLR_Gpio_Provider* self
 
     if (debounceTime > 0 && debounceTime < 10000) {
         g_debounceTicksPin[pin] = (uint32_t)STM32F4_Time_GetProcessorTicksForTime(nullptr, (uint64_t)debounceTime * 1000 * 10);
+        g_debounceTimerTicksPin[pin] = (debounceTime * STM32F4_Gpio_DebounceTimerHz + 999) / 1000;
         return TinyCLR_Result::Success;
     }
 
@@ -441,6 +855,7 @@ void STM32F4_Gpio_Reset() {
         auto& p = pins[i];
 
         g_pinReserved[i] = 0;
+        g_eventQueued[i] = false;
         STM32F4_Gpio_SetDebounceTimeout(nullptr, i, STM32F4_Gpio_DebounceDefaultMilisecond);
         STM32F4_Gpio_DisableInterrupt(i);
 
@@ -453,13 +868,17 @@ void STM32F4_Gpio_Reset() {
     }
 
     EXTI->IMR = 0; // disable all external interrups;
-    STM32F4_InterruptInternal_Activate(EXTI0_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt0, 0);
-    STM32F4_InterruptInternal_Activate(EXTI1_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt1, 0);
-    STM32F4_InterruptInternal_Activate(EXTI2_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt2, 0);
-    STM32F4_InterruptInternal_Activate(EXTI3_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt3, 0);
-    STM32F4_InterruptInternal_Activate(EXTI4_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt4, 0);
-    STM32F4_InterruptInternal_Activate(EXTI9_5_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt5, 0);
-    STM32F4_InterruptInternal_Activate(EXTI15_10_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt10, 0);
+
+    STM32F4_Gpio_DebounceTimerRelease();
+
+    g_eventQueue.tail = g_eventQueue.head;
+    STM32F4_InterruptInternal_Activate(EXTI0_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt0, 0, STM32F4_INTERRUPT_PRIORITY_GPIO);
+    STM32F4_InterruptInternal_Activate(EXTI1_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt1, 0, STM32F4_INTERRUPT_PRIORITY_GPIO);
+    STM32F4_InterruptInternal_Activate(EXTI2_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt2, 0, STM32F4_INTERRUPT_PRIORITY_GPIO);
+    STM32F4_InterruptInternal_Activate(EXTI3_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt3, 0, STM32F4_INTERRUPT_PRIORITY_GPIO);
+    STM32F4_InterruptInternal_Activate(EXTI4_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt4, 0, STM32F4_INTERRUPT_PRIORITY_GPIO);
+    STM32F4_InterruptInternal_Activate(EXTI9_5_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt5, 0, STM32F4_INTERRUPT_PRIORITY_GPIO);
+    STM32F4_InterruptInternal_Activate(EXTI15_10_IRQn, (uint32_t*)&STM32F4_Gpio_Interrupt10, 0, STM32F4_INTERRUPT_PRIORITY_GPIO);
 }
 
 #if !defined(__GNUC__)
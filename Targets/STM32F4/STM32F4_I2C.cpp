@@ -406,8 +406,8 @@ TinyCLR_Result STM32F4_I2c_Acquire(const TinyCLR_I2c_Provider* self) {
 
     I2Cx->CR1 = I2C_CR1_PE; // enable peripheral
 
-    STM32F4_InterruptInternal_Activate(I2Cx_EV_IRQn, (uint32_t*)&STM32F4_I2C_EV_Interrupt, 0);
-    STM32F4_InterruptInternal_Activate(I2Cx_ER_IRQn, (uint32_t*)&STM32F4_I2C_ER_Interrupt, 0);
+    STM32F4_InterruptInternal_Activate(I2Cx_EV_IRQn, (uint32_t*)&STM32F4_I2C_EV_Interrupt, 0, STM32F4_INTERRUPT_PRIORITY_I2C);
+    STM32F4_InterruptInternal_Activate(I2Cx_ER_IRQn, (uint32_t*)&STM32F4_I2C_ER_Interrupt, 0, STM32F4_INTERRUPT_PRIORITY_I2C);
 
     return TinyCLR_Result::Success;
 }
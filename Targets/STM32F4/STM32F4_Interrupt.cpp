@@ -17,6 +17,16 @@
 #include "STM32F4.h"
 
 #define DISABLED_MASK  0x00000001
+#define KERNEL_BASEPRI (STM32F4_INTERRUPT_PRIORITY_KERNEL << (8 - STM32F4_INTERRUPT_PRIORITY_BITS))
+
+#if STM32F4_INTERRUPT_PRIORITY_KERNEL == 0
+#error "BASEPRI of 0 masks nothing, the kernel priority must be 1 or higher"
+#endif
+
+// BASEPRI of 0 masks nothing, anything else masks that priority and all less urgent ones
+static inline bool STM32F4_Interrupt_IsKernelMasked(uint32_t basepri) {
+    return basepri != 0 && basepri <= KERNEL_BASEPRI;
+}
 
 TinyCLR_Interrupt_StartStopHandler STM32F4_Interrupt_Started;
 TinyCLR_Interrupt_StartStopHandler STM32F4_Interrupt_Ended;
@@ -46,13 +56,10 @@ const TinyCLR_Api_Info* STM32F4_Interrupt_GetApi() {
 }
 
 extern "C" {
-    void SysTick_Handler(void *param);
     extern uint32_t __Vectors;
 }
 
 TinyCLR_Result STM32F4_Interrupt_Acquire(TinyCLR_Interrupt_StartStopHandler onInterruptStart, TinyCLR_Interrupt_StartStopHandler onInterruptEnd) {
-    uint32_t *irq_vectors = (uint32_t*)&__Vectors;
-
     // disable all interrupts
     NVIC->ICER[0] = 0xFFFFFFFF;
     NVIC->ICER[1] = 0xFFFFFFFF;
@@ -62,11 +69,8 @@ TinyCLR_Result STM32F4_Interrupt_Acquire(TinyCLR_Interrupt_StartStopHandler onIn
     NVIC->ICPR[1] = 0xFFFFFFFF;
     NVIC->ICPR[2] = 0xFFFFFFFF;
 
-    // force point to SysTick_Handler because GNU does not link to the function automatically
-    irq_vectors[15] = (uint32_t)&SysTick_Handler;
-
     SCB->AIRCR = (0x5FA << SCB_AIRCR_VECTKEY_Pos) // unlock key
-        | (7 << SCB_AIRCR_PRIGROUP_Pos);   // no priority group bits
+        | ((7 - STM32F4_INTERRUPT_PRIORITY_BITS) << SCB_AIRCR_PRIGROUP_Pos);   // all priority bits are group bits so lower values preempt
     SCB->VTOR = (uint32_t)&__Vectors; // vector table base
     SCB->SHCSR |= SCB_SHCSR_USGFAULTENA_Msk  // enable faults
         | SCB_SHCSR_BUSFAULTENA_Msk
@@ -82,12 +86,13 @@ TinyCLR_Result STM32F4_Interrupt_Release() {
     return TinyCLR_Result::Success;
 }
 
-bool STM32F4_InterruptInternal_Activate(uint32_t index, uint32_t *isr, void* isrParam) {
+bool STM32F4_InterruptInternal_Activate(uint32_t index, uint32_t *isr, void* isrParam, uint32_t priority) {
     int id = (int)index;
 
     uint32_t *irq_vectors = (uint32_t*)&__Vectors;
 
     irq_vectors[id + 16] = (uint32_t)isr; // exception = irq + 16
+    STM32F4_InterruptInternal_SetPriority(index, priority);
     NVIC->ICPR[id >> 5] = 1 << (id & 0x1F); // clear pending bit
     NVIC->ISER[id >> 5] = 1 << (id & 0x1F); // set enable bit
 
@@ -101,41 +106,61 @@ bool STM32F4_InterruptInternal_Deactivate(uint32_t index) {
 
     return true;
 }
+
+bool STM32F4_InterruptInternal_SetPriority(uint32_t index, uint32_t priority) {
+    if (priority > STM32F4_INTERRUPT_PRIORITY_LOWEST)
+        return false;
+
+    NVIC->IP[index] = priority << (8 - STM32F4_INTERRUPT_PRIORITY_BITS); // implemented bits are the high ones
+
+    return true;
+}
+
+uint32_t STM32F4_InterruptInternal_GetPriority(uint32_t index) {
+    return NVIC->IP[index] >> (8 - STM32F4_INTERRUPT_PRIORITY_BITS);
+}
 STM32F4_InterruptStarted_RaiiHelper::STM32F4_InterruptStarted_RaiiHelper() { STM32F4_Interrupt_Started(); };
 STM32F4_InterruptStarted_RaiiHelper::~STM32F4_InterruptStarted_RaiiHelper() { STM32F4_Interrupt_Ended(); };
 
 STM32F4_DisableInterrupts_RaiiHelper::STM32F4_DisableInterrupts_RaiiHelper() {
-    state = __get_PRIMASK();
+    state = __get_BASEPRI();
 
-    __disable_irq();
+    __set_BASEPRI_MAX(KERNEL_BASEPRI);
 }
 STM32F4_DisableInterrupts_RaiiHelper::~STM32F4_DisableInterrupts_RaiiHelper() {
-    uint32_t Cp = state;
-
-    if ((Cp & DISABLED_MASK) == 0) {
-        __enable_irq();
-    }
+    __set_BASEPRI(state);
 }
 
 bool STM32F4_DisableInterrupts_RaiiHelper::IsDisabled() {
-    return (state & DISABLED_MASK) == DISABLED_MASK;
+    return STM32F4_Interrupt_IsKernelMasked(state) || (__get_PRIMASK() & DISABLED_MASK) == DISABLED_MASK;
 }
 
 void STM32F4_DisableInterrupts_RaiiHelper::Acquire() {
     uint32_t Cp = state;
 
-    if ((Cp & DISABLED_MASK) == DISABLED_MASK) {
-        state = __get_PRIMASK();
+    if (STM32F4_Interrupt_IsKernelMasked(Cp)) {
+        state = __get_BASEPRI();
 
-        __disable_irq();
+        __set_BASEPRI_MAX(KERNEL_BASEPRI);
     }
 }
 
 void STM32F4_DisableInterrupts_RaiiHelper::Release() {
     uint32_t Cp = state;
 
-    if ((Cp & DISABLED_MASK) == 0) {
-        state = __get_PRIMASK();
+    if (!STM32F4_Interrupt_IsKernelMasked(Cp)) {
+        state = __get_BASEPRI();
+        __set_BASEPRI(Cp);
+    }
+}
+
+STM32F4_DisableAllInterrupts_RaiiHelper::STM32F4_DisableAllInterrupts_RaiiHelper() {
+    state = __get_PRIMASK();
+
+    __disable_irq();
+}
+STM32F4_DisableAllInterrupts_RaiiHelper::~STM32F4_DisableAllInterrupts_RaiiHelper() {
+    if ((state & DISABLED_MASK) == 0) {
         __enable_irq();
     }
 }
@@ -144,10 +169,11 @@ void STM32F4_DisableInterrupts_RaiiHelper::Release() {
 //Global Interrupt - Use in System Cote
 //////////////////////////////////////////////////////////////////////////////
 bool STM32F4_Interrupt_IsDisabled() {
-    return (__get_PRIMASK() & DISABLED_MASK) == DISABLED_MASK;
+    return STM32F4_Interrupt_IsKernelMasked(__get_BASEPRI()) || (__get_PRIMASK() & DISABLED_MASK) == DISABLED_MASK;
 }
 
 bool STM32F4_Interrupt_Enable(bool force) {
+    __set_BASEPRI(0);
     __enable_irq();
 
     return true;
@@ -156,7 +182,7 @@ bool STM32F4_Interrupt_Enable(bool force) {
 bool STM32F4_Interrupt_Disable(bool force) {
     bool wasDisable = STM32F4_Interrupt_IsDisabled();
 
-    __disable_irq();
+    __set_BASEPRI_MAX(KERNEL_BASEPRI);
 
     return wasDisable;
 }
@@ -164,7 +190,10 @@ bool STM32F4_Interrupt_Disable(bool force) {
 
 void STM32F4_Interrupt_WaitForInterrupt() {
     register uint32_t state = __get_PRIMASK();
+    register uint32_t basepri = __get_BASEPRI();
 
+    // interrupts masked by BASEPRI do not wake WFI
+    __set_BASEPRI(0);
     __enable_irq();
 
     // just to allow an interupt to an occur
@@ -172,8 +201,10 @@ void STM32F4_Interrupt_WaitForInterrupt() {
 
     // restore irq state
     __set_PRIMASK(state);
+    __set_BASEPRI(basepri);
 }
 
 void STM32F4_Interrupt_Restore() {
+    __set_BASEPRI(0);
     __enable_irq();
 }
\ No newline at end of file
@@ -0,0 +1,261 @@
+// Copyright GHI Electronics, LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "STM32F4.h"
+
+#ifdef INCLUDE_PWM
+///////////////////////////////////////////////////////////////////////////////
+
+// one pulse mode on the PWM timers: controller x is TIM(x + 1), the CH1 pin triggers and the pulse is output on CH2
+#define STM32F4_ONEPULSE_CHANNELS 4
+#define STM32F4_ONEPULSE_TRIGGER_PIN 0
+#define STM32F4_ONEPULSE_OUTPUT_PIN 1
+
+#if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_ONEPULSE_APB1_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ)
+#else
+#define STM32F4_ONEPULSE_APB1_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
+#endif
+
+#if STM32F4_APB2_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_ONEPULSE_APB2_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ)
+#else
+#define STM32F4_ONEPULSE_APB2_CLOCK_HZ (STM32F4_APB2_CLOCK_HZ * 2)
+#endif
+
+struct STM32F4_OnePulse_Controller {
+    TIM_TypeDef* timer;
+    uint32_t mask; // counter range - 1
+
+    STM32F4_OnePulse_Trigger trigger;
+    bool configured;
+};
+
+static STM32F4_Gpio_Pin g_STM32F4_OnePulse_Pins[][STM32F4_ONEPULSE_CHANNELS] = STM32F4_PWM_PINS;
+
+static const int TOTAL_ONEPULSE_CONTROLLERS = SIZEOF_ARRAY(g_STM32F4_OnePulse_Pins);
+
+static STM32F4_OnePulse_Controller g_STM32F4_OnePulse_Controller[TOTAL_ONEPULSE_CONTROLLERS];
+
+static TIM_TypeDef* STM32F4_OnePulse_GetTimer(int32_t controller) {
+    switch (controller) {
+    case 0: return TIM1;
+    case 1: return TIM2;
+    case 2: return TIM3;
+    case 3: return TIM4;
+#if !defined(STM32F401xE) && !defined(STM32F411xE)
+    case 4: return TIM5;
+    case 7: return TIM8;
+#endif
+    }
+
+    return nullptr;
+}
+
+static TinyCLR_Result STM32F4_OnePulse_OpenPin(int32_t controller, int32_t channel) {
+    auto& pin = g_STM32F4_OnePulse_Pins[controller][channel];
+
+    if (pin.number == PIN_NONE)
+        return TinyCLR_Result::NotSupported;
+
+    if (!STM32F4_GpioInternal_OpenPin(pin.number))
+        return TinyCLR_Result::SharingViolation;
+
+    STM32F4_GpioInternal_ConfigurePin(pin.number, STM32F4_Gpio_PortMode::AlternateFunction, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, pin.alternateFunction);
+
+    return TinyCLR_Result::Success;
+}
+
+static void STM32F4_OnePulse_ClosePin(int32_t controller, int32_t channel) {
+    auto& pin = g_STM32F4_OnePulse_Pins[controller][channel];
+
+    STM32F4_GpioInternal_ConfigurePin(pin.number, STM32F4_Gpio_PortMode::Input, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, STM32F4_Gpio_AlternateFunction::AF0);
+    STM32F4_GpioInternal_ClosePin(pin.number);
+}
+
+// invert makes the pulse low on an idle high output
+TinyCLR_Result STM32F4_OnePulse_Acquire(int32_t controller, STM32F4_OnePulse_Trigger trigger, bool invert) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_OnePulse_Controller[controller];
+
+    if (state.timer != nullptr)
+        return TinyCLR_Result::SharingViolation;
+
+    auto treg = STM32F4_OnePulse_GetTimer(controller);
+
+    if (treg == nullptr)
+        return TinyCLR_Result::NotSupported;
+
+    if (!STM32F4_TimerInternal_Acquire(treg, STM32F4_Timer_Owner::OnePulse)) // timer used by PWM or another driver
+        return TinyCLR_Result::SharingViolation;
+
+    auto result = STM32F4_OnePulse_OpenPin(controller, STM32F4_ONEPULSE_OUTPUT_PIN);
+
+    if (result != TinyCLR_Result::Success) {
+        STM32F4_TimerInternal_Release(treg, STM32F4_Timer_Owner::OnePulse);
+
+        return result;
+    }
+
+    if (trigger != STM32F4_OnePulse_Trigger::Software) {
+        result = STM32F4_OnePulse_OpenPin(controller, STM32F4_ONEPULSE_TRIGGER_PIN);
+
+        if (result != TinyCLR_Result::Success) {
+            STM32F4_OnePulse_ClosePin(controller, STM32F4_ONEPULSE_OUTPUT_PIN);
+            STM32F4_TimerInternal_Release(treg, STM32F4_Timer_Owner::OnePulse);
+
+            return result;
+        }
+    }
+
+    state.timer = treg;
+    state.mask = (controller == 1 || controller == 4) ? 0xFFFFFFFF : 0xFFFF; // TIM2 and TIM5 are 32 bit
+    state.trigger = trigger;
+    state.configured = false;
+
+    treg->CR1 = TIM_CR1_OPM | TIM_CR1_URS; // counter stops at the update event
+    treg->DIER = 0;
+    treg->CCER = 0;
+    treg->CCMR1 = TIM_CCMR1_OC2M | TIM_CCMR1_OC2PE; // PWM2: OC2 inactive until CCR2, active until ARR
+    treg->CCMR2 = 0;
+
+    treg->SMCR = 0; // trigger is armed once the pulse is set
+
+    if (trigger != STM32F4_OnePulse_Trigger::Software) {
+        treg->CCMR1 |= TIM_CCMR1_CC1S_0; // IC1 on TI1
+        treg->CCER = trigger == STM32F4_OnePulse_Trigger::FallingEdge ? TIM_CCER_CC1P : 0;
+    }
+
+    treg->CCER |= TIM_CCER_CC2E | (invert ? TIM_CCER_CC2P : 0);
+
+    if (controller == 0 || controller == 7)
+        treg->BDTR |= TIM_BDTR_MOE; // main output enable (timer 1 & 8 only)
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_OnePulse_Release(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_OnePulse_Controller[controller];
+    auto treg = state.timer;
+
+    if (treg == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    treg->SMCR = 0;
+    treg->CR1 = 0;
+    treg->CCER = 0;
+    treg->BDTR = 0;
+
+    STM32F4_TimerInternal_Release(treg, STM32F4_Timer_Owner::OnePulse);
+
+    STM32F4_OnePulse_ClosePin(controller, STM32F4_ONEPULSE_OUTPUT_PIN);
+
+    if (state.trigger != STM32F4_OnePulse_Trigger::Software)
+        STM32F4_OnePulse_ClosePin(controller, STM32F4_ONEPULSE_TRIGGER_PIN);
+
+    state.timer = nullptr;
+
+    return TinyCLR_Result::Success;
+}
+
+// delay is from the trigger to the pulse start, both times are rounded down to timer ticks with a minimum of one
+TinyCLR_Result STM32F4_OnePulse_SetPulse(int32_t controller, uint32_t delayNanoseconds, uint32_t widthNanoseconds) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_OnePulse_Controller[controller];
+    auto treg = state.timer;
+
+    if (treg == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (widthNanoseconds == 0)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    if (treg->CR1 & TIM_CR1_CEN)
+        return TinyCLR_Result::Busy;
+
+    uint64_t clock = ((uint32_t)treg & 0x10000) ? STM32F4_ONEPULSE_APB2_CLOCK_HZ : STM32F4_ONEPULSE_APB1_CLOCK_HZ;
+    uint64_t total = (((uint64_t)delayNanoseconds + widthNanoseconds) * clock) / 1000000000;
+    uint64_t prescaler = total / ((uint64_t)state.mask + 1) + 1; // smallest prescaler that fits the whole pulse
+
+    if (prescaler > 0x10000)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    clock /= prescaler;
+
+    uint32_t delay = ((uint64_t)delayNanoseconds * clock) / 1000000000;
+    uint32_t width = ((uint64_t)widthNanoseconds * clock) / 1000000000;
+
+    if (delay == 0) // CCR2 = 0 would leave the output active while idle
+        delay = 1;
+
+    if (width == 0)
+        width = 1;
+
+    if ((uint64_t)delay + width > state.mask)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    treg->PSC = prescaler - 1;
+    treg->CCR2 = delay;
+    treg->ARR = delay + width;
+    treg->EGR = TIM_EGR_UG; // load PSC and preload registers, OPM keeps the counter stopped
+
+    if (state.trigger != STM32F4_OnePulse_Trigger::Software)
+        treg->SMCR = TIM_SMCR_TS_2 | TIM_SMCR_TS_0 | TIM_SMCR_SMS_2 | TIM_SMCR_SMS_1; // trigger mode from TI1FP1, the edge sets CEN
+
+    state.configured = true;
+
+    return TinyCLR_Result::Success;
+}
+
+// starts the pulse now, edge triggered controllers start on each edge by themselves
+TinyCLR_Result STM32F4_OnePulse_Fire(int32_t controller) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& state = g_STM32F4_OnePulse_Controller[controller];
+    auto treg = state.timer;
+
+    if (treg == nullptr || !state.configured)
+        return TinyCLR_Result::InvalidOperation;
+
+    if (treg->CR1 & TIM_CR1_CEN)
+        return TinyCLR_Result::Busy;
+
+    treg->CR1 |= TIM_CR1_CEN;
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_OnePulse_IsBusy(int32_t controller, bool& busy) {
+    if (controller < 0 || controller >= TOTAL_ONEPULSE_CONTROLLERS)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto treg = g_STM32F4_OnePulse_Controller[controller].timer;
+
+    if (treg == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    busy = (treg->CR1 & TIM_CR1_CEN) != 0;
+
+    return TinyCLR_Result::Success;
+}
+
+#endif
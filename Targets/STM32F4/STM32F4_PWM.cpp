@@ -18,6 +18,57 @@
 
 void STM32F4_Pwm_Reset();
 
+// one owner per timer, indexed by the RCC enable bit, APB2 timers in the upper half
+static STM32F4_Timer_Owner g_STM32F4_Timer_Owner[64];
+
+static __IO uint32_t* STM32F4_TimerInternal_GetClockEnable(TIM_TypeDef* treg, uint32_t& enBit, uint32_t& index) {
+    auto apb2 = ((uint32_t)treg & 0x10000) != 0;
+    auto bit = ((uint32_t)treg >> 10) & 0x1F;
+
+    enBit = 1 << bit;
+    index = bit + (apb2 ? 32 : 0);
+
+    return apb2 ? &RCC->APB2ENR : &RCC->APB1ENR;
+}
+
+bool STM32F4_TimerInternal_Acquire(TIM_TypeDef* treg, STM32F4_Timer_Owner owner) {
+    uint32_t enBit, index;
+    auto enReg = STM32F4_TimerInternal_GetClockEnable(treg, enBit, index);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (g_STM32F4_Timer_Owner[index] != STM32F4_Timer_Owner::None)
+        return false;
+
+    g_STM32F4_Timer_Owner[index] = owner;
+
+    *enReg |= enBit; // enable timer clock
+
+    return true;
+}
+
+void STM32F4_TimerInternal_Release(TIM_TypeDef* treg, STM32F4_Timer_Owner owner) {
+    uint32_t enBit, index;
+    auto enReg = STM32F4_TimerInternal_GetClockEnable(treg, enBit, index);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (g_STM32F4_Timer_Owner[index] != owner)
+        return;
+
+    *enReg &= ~enBit; // disable timer clock
+
+    g_STM32F4_Timer_Owner[index] = STM32F4_Timer_Owner::None;
+}
+
+STM32F4_Timer_Owner STM32F4_TimerInternal_GetOwner(TIM_TypeDef* treg) {
+    uint32_t enBit, index;
+
+    STM32F4_TimerInternal_GetClockEnable(treg, enBit, index);
+
+    return g_STM32F4_Timer_Owner[index];
+}
+
 #if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
 #define PWM1_CLK_HZ (STM32F4_APB1_CLOCK_HZ)
 #else
@@ -57,7 +108,7 @@ struct PwmController {
     bool                invert[PWM_PER_CONTROLLER];
     double              actualFreq;
     double              theoryFreq;
-    double              dutyCycle[PWM_PER_CONTROLLER];
+    uint32_t            dutyCycle[PWM_PER_CONTROLLER]; // Q16
 
     uint32_t            period;
     uint32_t            presc;
@@ -74,6 +125,22 @@ static const int TOTAL_PWM_CONTROLLER = SIZEOF_ARRAY(pwmPins);
 
 static PwmController g_PwmController[TOTAL_PWM_CONTROLLER];
 
+// sequence mode: the timer update event requests DMA, which writes the next compare value for the following period
+#define STM32F4_PWM_SEQUENCE_MAX_LENGTH 0xFFFF
+
+struct STM32F4_Pwm_Sequence {
+    DMA_TypeDef* dma;
+    DMA_Stream_TypeDef* stream;
+    uint32_t irq;
+    uint32_t channel; // CHSEL
+    uint32_t shift; // stream flag offset in xISR/xIFCR
+    bool high; // stream 4..7 flags live in HISR/HIFCR
+    STM32F4_Pwm_SequenceHandler handler;
+    bool active;
+};
+
+static STM32F4_Pwm_Sequence g_STM32F4_Pwm_Sequence[TOTAL_PWM_CONTROLLER];
+
 static uint8_t pwmProviderDefs[TOTAL_PWM_CONTROLLER * sizeof(TinyCLR_Pwm_Provider)];
 static TinyCLR_Pwm_Provider* pwmProviders[TOTAL_PWM_CONTROLLER];
 static TinyCLR_Api_Info pwmApi;
@@ -119,13 +186,13 @@ TinyCLR_Result STM32F4_Pwm_AcquirePin(const TinyCLR_Pwm_Provider* self, int32_t
     if (!STM32F4_GpioInternal_OpenPin(actualPin->number))
         return TinyCLR_Result::SharingViolation;
 
-    // relevant RCC register & bit
-    __IO uint32_t* enReg = &RCC->APB1ENR;
-    if ((uint32_t)treg & 0x10000) enReg = &RCC->APB2ENR;
-    int enBit = 1 << (((uint32_t)treg >> 10) & 0x1F);
+    if (STM32F4_TimerInternal_GetOwner(treg) != STM32F4_Timer_Owner::Pwm) { // not yet initialized
+        if (!STM32F4_TimerInternal_Acquire(treg, STM32F4_Timer_Owner::Pwm)) { // timer used by another driver
+            STM32F4_GpioInternal_ClosePin(actualPin->number);
+
+            return TinyCLR_Result::SharingViolation;
+        }
 
-    if (!(*enReg & enBit)) { // not yet initialized
-        *enReg |= enBit; // enable timer clock
         treg->CR1 = TIM_CR1_URS | TIM_CR1_ARPE; // double buffered update
         treg->EGR = TIM_EGR_UG; // enforce first update
         if (pwmController(self->Index).timer == 1 || pwmController(self->Index).timer == 8) {
@@ -148,6 +215,9 @@ TinyCLR_Result STM32F4_Pwm_AcquirePin(const TinyCLR_Pwm_Provider* self, int32_t
 TinyCLR_Result STM32F4_Pwm_ReleasePin(const TinyCLR_Pwm_Provider* self, int32_t pin) {
     ptr_TIM_TypeDef treg = pwmController(self->Index).timerdef;
 
+    if (STM32F4_TimerInternal_GetOwner(treg) != STM32F4_Timer_Owner::Pwm) // no channel acquired
+        return TinyCLR_Result::Success;
+
     auto actualPin = STM32F4_Pwm_GetGpioPinForChannel(self, pin);
 
     uint32_t mask = 0xFF; // disable PWM channel
@@ -157,10 +227,7 @@ TinyCLR_Result STM32F4_Pwm_ReleasePin(const TinyCLR_Pwm_Provider* self, int32_t
     *reg &= ~mask;
 
     if ((treg->CCMR1 | treg->CCMR2) == 0) { // no channel active
-        __IO uint32_t* enReg = &RCC->APB1ENR;
-        if ((uint32_t)treg & 0x10000) enReg = &RCC->APB2ENR;
-        int enBit = 1 << (((uint32_t)treg >> 10) & 0x1F);
-        *enReg &= ~enBit; // disable timer clock
+        STM32F4_TimerInternal_Release(treg, STM32F4_Timer_Owner::Pwm);
     }
 
     STM32F4_GpioInternal_ClosePin(actualPin->number);
@@ -266,6 +333,9 @@ double STM32F4_Pwm_GetActualFrequency(const TinyCLR_Pwm_Provider* self) {
 TinyCLR_Result STM32F4_Pwm_EnablePin(const TinyCLR_Pwm_Provider* self, int32_t pin) {
     ptr_TIM_TypeDef treg = pwmController(self->Index).timerdef;
 
+    if (STM32F4_TimerInternal_GetOwner(treg) != STM32F4_Timer_Owner::Pwm) // pin not acquired
+        return TinyCLR_Result::InvalidOperation;
+
     auto actualPin = STM32F4_Pwm_GetGpioPinForChannel(self, pin);
 
     STM32F4_GpioInternal_ConfigurePin(actualPin->number, STM32F4_Gpio_PortMode::AlternateFunction, STM32F4_Gpio_OutputType::PushPull, STM32F4_Gpio_OutputSpeed::VeryHigh, STM32F4_Gpio_PullDirection::None, actualPin->alternateFunction);
@@ -287,6 +357,9 @@ TinyCLR_Result STM32F4_Pwm_EnablePin(const TinyCLR_Pwm_Provider* self, int32_t p
 TinyCLR_Result STM32F4_Pwm_DisablePin(const TinyCLR_Pwm_Provider* self, int32_t pin) {
     ptr_TIM_TypeDef treg = pwmController(self->Index).timerdef;
 
+    if (STM32F4_TimerInternal_GetOwner(treg) != STM32F4_Timer_Owner::Pwm) // no channel acquired
+        return TinyCLR_Result::Success;
+
     auto actualPin = STM32F4_Pwm_GetGpioPinForChannel(self, pin);
 
     uint16_t ccer = treg->CCER;
@@ -332,16 +405,16 @@ double STM32F4_Pwm_GetMinFrequency(const TinyCLR_Pwm_Provider* self) {
     return STM32F4_MIN_PWM_FREQUENCY;
 }
 
-TinyCLR_Result STM32F4_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity) {
+// Writes the preloaded compare register and sets the polarity bit in ccer, returns true if the compare value changed
+static bool STM32F4_Pwm_StageChannel(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity, uint32_t& ccer) {
     ptr_TIM_TypeDef treg = pwmController(self->Index).timerdef;
 
-    uint32_t duration = (uint32_t)(dutyCycle * pwmController(self->Index).period);
+    uint32_t period = pwmController(self->Index).period;
 
-    if (duration > pwmController(self->Index).period)
-        duration = pwmController(self->Index).period;
+    if (dutyCycle > STM32F4_PWM_DUTY_CYCLE_FULL)
+        dutyCycle = STM32F4_PWM_DUTY_CYCLE_FULL;
 
-    treg->PSC = pwmController(self->Index).presc - 1;
-    treg->ARR = pwmController(self->Index).period - 1;
+    uint32_t duration = (uint32_t)(((uint64_t)dutyCycle * period) >> 16);
 
     if (pwmController(self->Index).timer == 2) {
         if (pin == 0)
@@ -360,20 +433,91 @@ TinyCLR_Result STM32F4_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self,
     uint32_t invBit = TIM_CCER_CC1P << (4 * pin);
 
     if (invertPolarity) {
-        treg->CCER |= invBit;
+        ccer |= invBit;
     }
     else {
-        treg->CCER &= ~invBit;
+        ccer &= ~invBit;
     }
 
-    if (duration != (uint32_t)(pwmController(self->Index).dutyCycle[pin] * pwmController(self->Index).period))
-        treg->EGR = TIM_EGR_UG; // enforce register update - update immidiately any changes
+    bool changed = duration != (uint32_t)(((uint64_t)pwmController(self->Index).dutyCycle[pin] * period) >> 16);
 
     pwmController(self->Index).invert[pin] = invertPolarity;
     pwmController(self->Index).dutyCycle[pin] = dutyCycle;
 
+    return changed;
+}
+
+TinyCLR_Result STM32F4_Pwm_SetPulseParametersFixed(const TinyCLR_Pwm_Provider* self, int32_t pin, uint32_t dutyCycle, bool invertPolarity) {
+    ptr_TIM_TypeDef treg = pwmController(self->Index).timerdef;
+
+    if (g_STM32F4_Pwm_Sequence[self->Index].active || STM32F4_TimerInternal_GetOwner(treg) != STM32F4_Timer_Owner::Pwm)
+        return TinyCLR_Result::InvalidOperation;
+
+    treg->PSC = pwmController(self->Index).presc - 1;
+    treg->ARR = pwmController(self->Index).period - 1;
+
+    uint32_t ccer = treg->CCER;
+
+    bool changed = STM32F4_Pwm_StageChannel(self, pin, dutyCycle, invertPolarity, ccer);
+
+    if (ccer != treg->CCER) {
+        treg->CCER = ccer;
+        changed = true;
+    }
+
+    if (changed)
+        treg->EGR = TIM_EGR_UG; // enforce register update - update immidiately any changes
+
     return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Pwm_SetPulseParametersBatch(const TinyCLR_Pwm_Provider* self, const int32_t* pins, const uint32_t* dutyCycles, const bool* invertPolarity, size_t count) {
+    ptr_TIM_TypeDef treg = pwmController(self->Index).timerdef;
+
+    if (pins == nullptr || dutyCycles == nullptr || invertPolarity == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (g_STM32F4_Pwm_Sequence[self->Index].active || STM32F4_TimerInternal_GetOwner(treg) != STM32F4_Timer_Owner::Pwm)
+        return TinyCLR_Result::InvalidOperation;
+
+    for (size_t i = 0; i < count; i++)
+        if (pins[i] < 0 || pins[i] >= PWM_PER_CONTROLLER || pwmController(self->Index).gpioPin[pins[i]].number == PIN_NONE)
+            return TinyCLR_Result::ArgumentOutOfRange;
+
+    // PSC, ARR (ARPE) and CCRx (OCxPE) are all preloaded, hold off the update event
+    // while staging so the whole set is transferred together at the next overflow
+    treg->CR1 |= TIM_CR1_UDIS;
+
+    treg->PSC = pwmController(self->Index).presc - 1;
+    treg->ARR = pwmController(self->Index).period - 1;
+
+    uint32_t ccer = treg->CCER;
+
+    for (size_t i = 0; i < count; i++)
+        STM32F4_Pwm_StageChannel(self, pins[i], dutyCycles[i], invertPolarity[i], ccer);
 
+    if (ccer != treg->CCER) {
+        // CCER is not preloaded, force the update right after it so polarity and compares switch together
+        treg->CCER = ccer;
+        treg->CR1 &= ~TIM_CR1_UDIS;
+        treg->EGR = TIM_EGR_UG;
+    }
+    else {
+        treg->CR1 &= ~TIM_CR1_UDIS;
+    }
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Pwm_SetPulseParameters(const TinyCLR_Pwm_Provider* self, int32_t pin, double dutyCycle, bool invertPolarity) {
+    uint32_t fixed = 0;
+
+    if (dutyCycle >= 1.0)
+        fixed = STM32F4_PWM_DUTY_CYCLE_FULL;
+    else if (dutyCycle > 0.0)
+        fixed = (uint32_t)(dutyCycle * STM32F4_PWM_DUTY_CYCLE_FULL + 0.5);
+
+    return STM32F4_Pwm_SetPulseParametersFixed(self, pin, fixed, invertPolarity);
 }
 
 TinyCLR_Result STM32F4_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Provider* self, double& frequency) {
@@ -388,11 +532,182 @@ TinyCLR_Result STM32F4_Pwm_SetDesiredFrequency(const TinyCLR_Pwm_Provider* self,
     // Calculate actual frequency base on desired frequency
     frequency = STM32F4_Pwm_GetActualFrequency(self);
 
-    // Update channel if frequency had different
-    for (int p = 0; p < PWM_PER_CONTROLLER; p++)
-        if (pwmController(self->Index).gpioPin[p].number != PIN_NONE)
-            if (STM32F4_Pwm_SetPulseParameters(self, p, pwmController(self->Index).dutyCycle[p], pwmController(self->Index).invert[p]) != TinyCLR_Result::Success)
-                return TinyCLR_Result::InvalidOperation;
+    // Update channel if frequency had different, new period and compares take effect together
+    int32_t pins[PWM_PER_CONTROLLER];
+    uint32_t dutyCycles[PWM_PER_CONTROLLER];
+    bool invert[PWM_PER_CONTROLLER];
+    size_t count = 0;
+
+    for (int p = 0; p < PWM_PER_CONTROLLER; p++) {
+        if (pwmController(self->Index).gpioPin[p].number != PIN_NONE) {
+            pins[count] = p;
+            dutyCycles[count] = pwmController(self->Index).dutyCycle[p];
+            invert[count] = pwmController(self->Index).invert[p];
+            count++;
+        }
+    }
+
+    // Not running yet, the new period is written when the pins are set up
+    if (count == 0 || STM32F4_TimerInternal_GetOwner(pwmController(self->Index).timerdef) != STM32F4_Timer_Owner::Pwm)
+        return TinyCLR_Result::Success;
+
+    if (STM32F4_Pwm_SetPulseParametersBatch(self, pins, dutyCycles, invert, count) != TinyCLR_Result::Success)
+        return TinyCLR_Result::InvalidOperation;
+
+    return TinyCLR_Result::Success;
+}
+
+static bool STM32F4_Pwm_GetSequenceDma(int32_t controller, STM32F4_Pwm_Sequence& sequence) {
+    uint32_t stream;
+
+    // TIMx_UP requests
+    switch (pwmController(controller).timer) {
+    case 1: sequence.dma = DMA2; sequence.stream = DMA2_Stream5; sequence.irq = DMA2_Stream5_IRQn; sequence.channel = 6; stream = 5; break;
+    case 2: sequence.dma = DMA1; sequence.stream = DMA1_Stream1; sequence.irq = DMA1_Stream1_IRQn; sequence.channel = 3; stream = 1; break;
+    case 3: sequence.dma = DMA1; sequence.stream = DMA1_Stream2; sequence.irq = DMA1_Stream2_IRQn; sequence.channel = 5; stream = 2; break;
+    case 4: sequence.dma = DMA1; sequence.stream = DMA1_Stream6; sequence.irq = DMA1_Stream6_IRQn; sequence.channel = 2; stream = 6; break;
+#if !defined(STM32F401xE) && !defined(STM32F411xE)
+    case 5: sequence.dma = DMA1; sequence.stream = DMA1_Stream0; sequence.irq = DMA1_Stream0_IRQn; sequence.channel = 6; stream = 0; break;
+    case 8: sequence.dma = DMA2; sequence.stream = DMA2_Stream1; sequence.irq = DMA2_Stream1_IRQn; sequence.channel = 7; stream = 1; break;
+#endif
+    default:
+        return false;
+    }
+
+    static const uint8_t shifts[] = { 0, 6, 16, 22 };
+
+    sequence.shift = shifts[stream & 3];
+    sequence.high = stream > 3;
+
+    return true;
+}
+
+static void STM32F4_Pwm_ReleaseSequence(int32_t controller) {
+    auto& sequence = g_STM32F4_Pwm_Sequence[controller];
+
+    if (!sequence.active)
+        return;
+
+    pwmController(controller).timerdef->DIER &= ~TIM_DIER_UDE;
+    sequence.stream->CR = 0;
+
+    if (sequence.high)
+        sequence.dma->HIFCR = 0x3D << sequence.shift;
+    else
+        sequence.dma->LIFCR = 0x3D << sequence.shift;
+
+    STM32F4_InterruptInternal_Deactivate(sequence.irq);
+
+    sequence.active = false;
+}
+
+static void STM32F4_Pwm_SequenceInterrupt(int32_t controller) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    auto& sequence = g_STM32F4_Pwm_Sequence[controller];
+    auto status = ((sequence.high ? sequence.dma->HISR : sequence.dma->LISR) >> sequence.shift) & 0x3D;
+
+    if (sequence.high)
+        sequence.dma->HIFCR = status << sequence.shift; // clear
+    else
+        sequence.dma->LIFCR = status << sequence.shift;
+
+    if (status & DMA_LISR_TEIF0) {
+        STM32F4_Pwm_ReleaseSequence(controller);
+
+        if (sequence.handler != nullptr)
+            sequence.handler(controller, STM32F4_Pwm_SequenceEvent::Error);
+
+        return;
+    }
+
+    if (status & DMA_LISR_HTIF0) {
+        if (sequence.handler != nullptr)
+            sequence.handler(controller, STM32F4_Pwm_SequenceEvent::HalfTransfer);
+    }
+
+    if (status & DMA_LISR_TCIF0) {
+        if (!(sequence.stream->CR & DMA_SxCR_CIRC)) // single shot is done, the last value stays in the compare register
+            STM32F4_Pwm_ReleaseSequence(controller);
+
+        if (sequence.handler != nullptr)
+            sequence.handler(controller, STM32F4_Pwm_SequenceEvent::TransferComplete);
+    }
+}
+
+void STM32F4_Pwm_SequenceInterrupt1(void* param) { STM32F4_Pwm_SequenceInterrupt(0); }
+void STM32F4_Pwm_SequenceInterrupt2(void* param) { STM32F4_Pwm_SequenceInterrupt(1); }
+void STM32F4_Pwm_SequenceInterrupt3(void* param) { STM32F4_Pwm_SequenceInterrupt(2); }
+void STM32F4_Pwm_SequenceInterrupt4(void* param) { STM32F4_Pwm_SequenceInterrupt(3); }
+void STM32F4_Pwm_SequenceInterrupt5(void* param) { STM32F4_Pwm_SequenceInterrupt(4); }
+void STM32F4_Pwm_SequenceInterrupt8(void* param) { STM32F4_Pwm_SequenceInterrupt(7); }
+
+static void (* const g_STM32F4_Pwm_SequenceIsr[])(void*) = {
+    &STM32F4_Pwm_SequenceInterrupt1, &STM32F4_Pwm_SequenceInterrupt2, &STM32F4_Pwm_SequenceInterrupt3, &STM32F4_Pwm_SequenceInterrupt4,
+    &STM32F4_Pwm_SequenceInterrupt5, nullptr, nullptr, &STM32F4_Pwm_SequenceInterrupt8
+};
+
+uint32_t STM32F4_Pwm_GetPeriodTicks(const TinyCLR_Pwm_Provider* self) {
+    return pwmController(self->Index).period;
+}
+
+// compareValues are raw timer ticks (0..GetPeriodTicks), one per PWM period
+TinyCLR_Result STM32F4_Pwm_StartSequence(const TinyCLR_Pwm_Provider* self, int32_t pin, const uint16_t* compareValues, size_t length, bool circular, STM32F4_Pwm_SequenceHandler handler) {
+    ptr_TIM_TypeDef treg = pwmController(self->Index).timerdef;
+
+    if (compareValues == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (pin < 0 || pin >= PWM_PER_CONTROLLER || length == 0 || length > STM32F4_PWM_SEQUENCE_MAX_LENGTH)
+        return TinyCLR_Result::ArgumentOutOfRange;
+
+    auto& sequence = g_STM32F4_Pwm_Sequence[self->Index];
+
+    if (!STM32F4_Pwm_GetSequenceDma(self->Index, sequence))
+        return TinyCLR_Result::NotSupported;
+
+    if (pwmController(self->Index).period > 0x10000) // DMA writes 16 bit compare values
+        return TinyCLR_Result::NotSupported;
+
+    if (sequence.active || STM32F4_TimerInternal_GetOwner(treg) != STM32F4_Timer_Owner::Pwm || !(treg->CCER & (TIM_CCER_CC1E << (4 * pin)))) // pin not enabled
+        return TinyCLR_Result::InvalidOperation;
+
+    if (sequence.stream->CR & DMA_SxCR_EN) // stream used by another driver
+        return TinyCLR_Result::SharingViolation;
+
+    RCC->AHB1ENR |= sequence.dma == DMA1 ? RCC_AHB1ENR_DMA1EN : RCC_AHB1ENR_DMA2EN;
+
+    if (sequence.high)
+        sequence.dma->HIFCR = 0x3D << sequence.shift;
+    else
+        sequence.dma->LIFCR = 0x3D << sequence.shift;
+
+    ((__IO uint32_t*)&treg->CCR1)[pin] = 0; // upper half of 32 bit compare registers
+
+    sequence.stream->PAR = (uint32_t)&((uint32_t*)&treg->CCR1)[pin];
+    sequence.stream->M0AR = (uint32_t)compareValues;
+    sequence.stream->NDTR = length;
+    sequence.stream->FCR = 0; // direct mode
+    sequence.stream->CR = (sequence.channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_TCIE | DMA_SxCR_TEIE
+        | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0
+        | (circular ? (DMA_SxCR_CIRC | DMA_SxCR_HTIE) : 0);
+
+    sequence.handler = handler;
+    sequence.active = true;
+
+    pwmController(self->Index).dutyCycle[pin] = 0;
+
+    STM32F4_InterruptInternal_Activate(sequence.irq, (uint32_t*)g_STM32F4_Pwm_SequenceIsr[self->Index], 0, STM32F4_INTERRUPT_PRIORITY_PWM);
+
+    sequence.stream->CR |= DMA_SxCR_EN;
+
+    treg->DIER |= TIM_DIER_UDE; // first value is loaded at the next update and becomes active one period later
+
+    return TinyCLR_Result::Success;
+}
+
+TinyCLR_Result STM32F4_Pwm_StopSequence(const TinyCLR_Pwm_Provider* self) {
+    STM32F4_Pwm_ReleaseSequence(self->Index);
 
     return TinyCLR_Result::Success;
 }
@@ -444,7 +759,7 @@ void STM32F4_Pwm_Reset() {
 
         for (auto i = 0; i < PWM_PER_CONTROLLER; i++) {
             c.invert[0] = false;
-            c.dutyCycle[0] = 0.0;
+            c.dutyCycle[0] = 0;
 
             c.gpioPin[i].number = pwmPins[controller]->number;
             c.gpioPin[i].alternateFunction = pwmPins[controller]->alternateFunction;
@@ -462,6 +777,8 @@ void STM32F4_Pwm_Reset() {
 }
 
 void STM32F4_Pwm_ResetController(int32_t controller) {
+    STM32F4_Pwm_ReleaseSequence(controller);
+
     for (int p = 0; p < PWM_PER_CONTROLLER; p++) {
         if (pwmController(controller).gpioPin[p].number != PIN_NONE) {
             pwmController(controller).dutyCycle[p] = 0;
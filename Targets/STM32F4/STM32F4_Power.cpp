@@ -37,30 +37,236 @@ const TinyCLR_Api_Info* STM32F4_Power_GetApi() {
     return &powerApi;
 }
 
-void STM32F4_Power_Sleep(const TinyCLR_Power_Provider* self, TinyCLR_Power_Sleep_Level level) {
-    switch (level) {
+// tickless idle stops the clocks until the next timer event and wakes on the RTC wakeup timer.
+// The RTC runs from the LSE when the board has one, from the LSI otherwise. The LSI is anywhere
+// between 17 and 47 kHz, so it is measured against the timebase when tickless idle is enabled.
+#define STM32F4_POWER_RTC_ASYNC_PRESCALER 8
+#define STM32F4_POWER_RTC_WAKEUP_PRESCALER 16 // WUCKSEL = RTCCLK / 16
+#define STM32F4_POWER_RTC_WAKEUP_EXTI_LINE (1 << 22)
+#define STM32F4_POWER_RTC_TIMEOUT 10000000
 
-        case TinyCLR_Power_Sleep_Level::Hibernate: // stop
-            SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
-            PWR->CR |= PWR_CR_CWUF | PWR_CR_FPDS | PWR_CR_LPDS; // low power deepsleep
+#define STM32F4_POWER_TICKLESS_MINIMUM_MILLISECONDS 10 // shorter idles are not worth the clock restart
+#define STM32F4_POWER_TICKLESS_WAKE_MARGIN_MILLISECONDS 3 // HSE and PLL startup before the event is due
+
+static bool g_STM32F4_Power_TicklessIdle;
+static uint32_t g_STM32F4_Power_RtcClockHz;
+
+static void STM32F4_Power_RestoreClocks() {
+    if ((RCC->CFGR & RCC_CFGR_SWS) == RCC_CFGR_SWS_PLL) // STOP was not entered, a wakeup was already pending
+        return;
 
-            __WFI(); // stop clocks and wait for external interrupt
 #if STM32F4_EXT_CRYSTAL_CLOCK_HZ != 0
-            RCC->CR |= RCC_CR_HSEON;             // HSE on
+    RCC->CR |= RCC_CR_HSEON;             // HSE on
+
+    while (!(RCC->CR & RCC_CR_HSERDY));
 #endif
-            SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;  // reset deepsleep
 
-            while (!(RCC->CR & RCC_CR_HSERDY));
+    RCC->CR |= RCC_CR_PLLON;             // pll on
 
-            RCC->CR |= RCC_CR_PLLON;             // pll on
+    while (!(RCC->CR & RCC_CR_PLLRDY));
 
-            while (!(RCC->CR & RCC_CR_PLLRDY));
+    RCC->CFGR |= RCC_CFGR_SW_PLL;        // sysclk = pll out
 
-            RCC->CFGR |= RCC_CFGR_SW_PLL;        // sysclk = pll out
+    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
 #if STM32F4_EXT_CRYSTAL_CLOCK_HZ != 0
-            RCC->CR &= ~RCC_CR_HSION;            // HSI off
+    RCC->CR &= ~RCC_CR_HSION;            // HSI off
+#endif
+}
+
+static void STM32F4_Power_RtcWakeupInterrupt(void* param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    RTC->ISR &= ~RTC_ISR_WUTF;
+    EXTI->PR = STM32F4_POWER_RTC_WAKEUP_EXTI_LINE;
+}
+
+static bool STM32F4_Power_RtcWait(uint32_t mask) {
+    for (auto timeout = 0; timeout < STM32F4_POWER_RTC_TIMEOUT; timeout++)
+        if (RTC->ISR & mask)
+            return true;
+
+    return false;
+}
+
+static TinyCLR_Result STM32F4_Power_RtcInitialize() {
+    RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+    PWR->CR |= PWR_CR_DBP; // backup domain write access
+
+#if defined(STM32F4_EXT_RTC_CRYSTAL_CLOCK_HZ) && STM32F4_EXT_RTC_CRYSTAL_CLOCK_HZ != 0
+    RCC->BDCR |= RCC_BDCR_LSEON;
+
+    for (auto timeout = 0; !(RCC->BDCR & RCC_BDCR_LSERDY); timeout++)
+        if (timeout == STM32F4_POWER_RTC_TIMEOUT)
+            return TinyCLR_Result::InvalidOperation;
+
+    if (!(RCC->BDCR & RCC_BDCR_RTCEN))
+        RCC->BDCR |= RCC_BDCR_RTCSEL_0 | RCC_BDCR_RTCEN;
+
+    g_STM32F4_Power_RtcClockHz = STM32F4_EXT_RTC_CRYSTAL_CLOCK_HZ;
+#else
+    RCC->CSR |= RCC_CSR_LSION;
+
+    while (!(RCC->CSR & RCC_CSR_LSIRDY));
+
+    if (!(RCC->BDCR & RCC_BDCR_RTCEN))
+        RCC->BDCR |= RCC_BDCR_RTCSEL_1 | RCC_BDCR_RTCEN;
+
+    g_STM32F4_Power_RtcClockHz = STM32F4_Time_MeasureLsiClock(nullptr);
+
+    if (g_STM32F4_Power_RtcClockHz == 0)
+        return TinyCLR_Result::InvalidOperation;
 #endif
 
+    RTC->WPR = 0xCA; // unlock
+    RTC->WPR = 0x53;
+
+    if (!(RTC->ISR & RTC_ISR_INITS)) { // calendar never set, give the subseconds the finest useful resolution
+        RTC->ISR |= RTC_ISR_INIT;
+
+        if (!STM32F4_Power_RtcWait(RTC_ISR_INITF))
+            return TinyCLR_Result::InvalidOperation;
+
+        RTC->PRER = g_STM32F4_Power_RtcClockHz / STM32F4_POWER_RTC_ASYNC_PRESCALER - 1;
+        RTC->PRER |= (STM32F4_POWER_RTC_ASYNC_PRESCALER - 1) << 16;
+        RTC->TR = 0;
+
+        RTC->ISR &= ~RTC_ISR_INIT;
+    }
+
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE | RTC_CR_WUCKSEL);
+
+    if (!STM32F4_Power_RtcWait(RTC_ISR_WUTWF))
+        return TinyCLR_Result::InvalidOperation;
+
+    RTC->ISR &= ~RTC_ISR_WUTF;
+    RTC->CR |= RTC_CR_WUTIE;
+
+    EXTI->IMR |= STM32F4_POWER_RTC_WAKEUP_EXTI_LINE;
+    EXTI->RTSR |= STM32F4_POWER_RTC_WAKEUP_EXTI_LINE;
+    EXTI->PR = STM32F4_POWER_RTC_WAKEUP_EXTI_LINE;
+
+    STM32F4_InterruptInternal_Activate(RTC_WKUP_IRQn, (uint32_t*)&STM32F4_Power_RtcWakeupInterrupt, nullptr, STM32F4_INTERRUPT_PRIORITY_POWER);
+
+    return TinyCLR_Result::Success;
+}
+
+static void STM32F4_Power_RtcUninitialize() {
+    STM32F4_InterruptInternal_Deactivate(RTC_WKUP_IRQn);
+
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+
+    EXTI->IMR &= ~STM32F4_POWER_RTC_WAKEUP_EXTI_LINE;
+    EXTI->RTSR &= ~STM32F4_POWER_RTC_WAKEUP_EXTI_LINE;
+}
+
+// subsecond units since midnight, PREDIV_S + 1 per second, each one PREDIV_A + 1 RTC clocks
+static uint32_t STM32F4_Power_RtcRead() {
+    RTC->ISR &= ~RTC_ISR_RSF; // the shadow registers are stale after STOP
+
+    STM32F4_Power_RtcWait(RTC_ISR_RSF);
+
+    uint32_t ssr = RTC->SSR; // locks TR and DR until DR is read
+    uint32_t tr = RTC->TR;
+
+    (void)RTC->DR;
+
+    uint32_t hours = ((tr >> 20) & 0x3) * 10 + ((tr >> 16) & 0xF);
+    uint32_t minutes = ((tr >> 12) & 0x7) * 10 + ((tr >> 8) & 0xF);
+    uint32_t seconds = ((tr >> 4) & 0x7) * 10 + (tr & 0xF);
+    uint32_t units = (RTC->PRER & RTC_PRER_PREDIV_S) + 1;
+
+    return ((hours * 60 + minutes) * 60 + seconds) * units + (units - 1 - ssr);
+}
+
+static void STM32F4_Power_TicklessIdle() {
+    DISABLE_ALL_INTERRUPTS_SCOPED(irq); // WFI still wakes on interrupts masked by PRIMASK
+
+    uint64_t now = STM32F4_Time_GetCurrentProcessorTicks(nullptr);
+    uint64_t next = STM32F4_Time_GetNextEventTicks(nullptr);
+    uint64_t idle = next > now ? STM32F4_Time_GetTimeForProcessorTicks(nullptr, next - now) / 10000 : 0; // milliseconds
+
+    if (idle < STM32F4_POWER_TICKLESS_MINIMUM_MILLISECONDS) {
+        PWR->CR |= PWR_CR_CWUF;
+
+        __WFI(); // sleep and wait for interrupt, it is taken once irq goes out of scope
+        return;
+    }
+
+    uint64_t wakeup = ((idle - STM32F4_POWER_TICKLESS_WAKE_MARGIN_MILLISECONDS) * g_STM32F4_Power_RtcClockHz) / (STM32F4_POWER_RTC_WAKEUP_PRESCALER * 1000);
+
+    if (wakeup > RTC_WUTR_WUT) // longer idles wake up once on the way
+        wakeup = RTC_WUTR_WUT;
+
+    RTC->CR &= ~RTC_CR_WUTE;
+
+    if (!STM32F4_Power_RtcWait(RTC_ISR_WUTWF))
+        return;
+
+    RTC->WUTR = wakeup - 1;
+    RTC->ISR &= ~RTC_ISR_WUTF;
+    EXTI->PR = STM32F4_POWER_RTC_WAKEUP_EXTI_LINE;
+    RTC->CR |= RTC_CR_WUTE;
+
+    uint32_t start = STM32F4_Power_RtcRead();
+    uint64_t ticks = STM32F4_Time_GetCurrentProcessorTicks(nullptr);
+
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    PWR->CR |= PWR_CR_CWUF | PWR_CR_FPDS | PWR_CR_LPDS; // low power deepsleep
+
+    __WFI(); // stop clocks until the RTC or another EXTI line wakes up
+
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+    STM32F4_Power_RestoreClocks();
+
+    RTC->CR &= ~RTC_CR_WUTE;
+
+    uint32_t units = (RTC->PRER & RTC_PRER_PREDIV_S) + 1;
+    uint32_t clocks = ((RTC->PRER & RTC_PRER_PREDIV_A) >> 16) + 1;
+    uint32_t end = STM32F4_Power_RtcRead();
+
+    if (end < start) // passed midnight
+        end += 24 * 60 * 60 * units;
+
+    // the timebase stood still in STOP and ran off the HSI while the clocks restarted, the RTC covers both
+    ticks += STM32F4_Time_GetProcessorTicksForTime(nullptr, (uint64_t)(end - start) * clocks * 10000000 / g_STM32F4_Power_RtcClockHz);
+
+    STM32F4_Time_SetProcessorTicks(nullptr, ticks);
+}
+
+// peripherals on the APB and AHB clocks, UART and USB among them, do not run while stopped
+TinyCLR_Result STM32F4_Power_SetTicklessIdle(const TinyCLR_Power_Provider* self, bool enabled) {
+    if (enabled == g_STM32F4_Power_TicklessIdle)
+        return TinyCLR_Result::Success;
+
+    if (enabled) {
+        auto result = STM32F4_Power_RtcInitialize();
+
+        if (result != TinyCLR_Result::Success)
+            return result;
+    }
+    else {
+        STM32F4_Power_RtcUninitialize();
+    }
+
+    g_STM32F4_Power_TicklessIdle = enabled;
+
+    return TinyCLR_Result::Success;
+}
+
+void STM32F4_Power_Sleep(const TinyCLR_Power_Provider* self, TinyCLR_Power_Sleep_Level level) {
+    switch (level) {
+
+        case TinyCLR_Power_Sleep_Level::Hibernate: // stop
+            SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+            PWR->CR |= PWR_CR_CWUF | PWR_CR_FPDS | PWR_CR_LPDS; // low power deepsleep
+
+            __WFI(); // stop clocks and wait for external interrupt
+
+            SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;  // reset deepsleep
+
+            STM32F4_Power_RestoreClocks();
+
             return;
 
         case TinyCLR_Power_Sleep_Level::Off: // standby
@@ -71,6 +277,12 @@ void STM32F4_Power_Sleep(const TinyCLR_Power_Provider* self, TinyCLR_Power_Sleep
             return;
 
         default: // sleep
+            if (g_STM32F4_Power_TicklessIdle) {
+                STM32F4_Power_TicklessIdle();
+
+                return;
+            }
+
             PWR->CR |= PWR_CR_CWUF;
 
             __WFI(); // sleep and wait for interrupt
@@ -18,7 +18,17 @@
 
 #define TIMER_IDLE_VALUE  0x0000FFFFFFFFFFFFull
 
-#define SLOW_CLOCKS_PER_SECOND STM32F4_AHB_CLOCK_HZ
+// the timebase is TIM5 counting freely over 32 bit at the APB1 timer clock, CC1 holds the next event
+#define STM32F4_TIME_TIMER TIM5
+#define STM32F4_TIME_TIMER_IRQ TIM5_IRQn
+
+#if STM32F4_APB1_CLOCK_HZ == STM32F4_AHB_CLOCK_HZ
+#define STM32F4_TIME_TIMER_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ)
+#else
+#define STM32F4_TIME_TIMER_CLOCK_HZ (STM32F4_APB1_CLOCK_HZ * 2)
+#endif
+
+#define SLOW_CLOCKS_PER_SECOND STM32F4_TIME_TIMER_CLOCK_HZ
 #define SLOW_CLOCKS_TEN_MHZ_GCD           1000000   // GCD(SLOW_CLOCKS_PER_SECOND, 10M)
 #define SLOW_CLOCKS_MILLISECOND_GCD          1000   // GCD(SLOW_CLOCKS_PER_SECOND, 1k)
 #define CLOCK_COMMON_FACTOR               1000000   // GCD(STM32F4_SYSTEM_CLOCK_HZ, 1M)
@@ -26,14 +36,12 @@
 
 struct STM32F4_Timer_Driver {
 
-    uint64_t m_lastRead;
-    uint32_t m_currentTick;
-    uint32_t m_periodTicks;
+    volatile uint32_t m_overflows; // upper 32 bit of the tick count, only written by the interrupt
 
     TinyCLR_Time_TickCallback m_DequeuAndExecute;
 
     static bool Initialize();
-    static void Reload(uint32_t value);
+    static void Uninitialize();
 
 };
 
@@ -102,76 +110,322 @@ uint64_t STM32F4_Time_GetProcessorTicksForTime(const TinyCLR_Time_Provider* self
 }
 
 uint64_t STM32F4_Time_GetCurrentProcessorTicks(const TinyCLR_Time_Provider* self) {
+    uint32_t overflows;
+    uint32_t ticks;
+    uint32_t pending;
+
+    // no interrupt masking: read again if the overflow interrupt ran in between
+    do {
+        overflows = g_STM32F4_Timer_Driver.m_overflows;
+        ticks = STM32F4_TIME_TIMER->CNT;
+        pending = STM32F4_TIME_TIMER->SR & TIM_SR_UIF;
+    } while (overflows != g_STM32F4_Timer_Driver.m_overflows);
+
+    // an overflow not handled yet belongs to this read only if the counter was read after it
+    if (pending && ticks < 0x80000000)
+        overflows++;
+
+    return (((uint64_t)overflows << 32) | ticks) & TIMER_IDLE_VALUE;
+}
+
+// programs the hardware compare, it pends the compare interrupt if processorTicks has passed so
+// the events always run from the interrupt, never from the caller or nested inside a dispatch
+static void STM32F4_Time_ScheduleCompare(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
     DISABLE_INTERRUPTS_SCOPED(irq);
 
-    uint32_t tick_spent;
-    uint32_t reg = SysTick->CTRL;
-    uint32_t ticks = (SysTick->VAL & SysTick_LOAD_RELOAD_Msk);
+    g_nextEvent = processorTicks;
 
-    if ((reg & SysTick_CTRL_COUNTFLAG_Msk) == SysTick_CTRL_COUNTFLAG_Msk   // Interrupt was trigger on time as expected
-        || ticks >= g_STM32F4_Timer_Driver.m_currentTick) {                // Interrupt was trigger slower than expected
-        if (ticks > 0) {
-            tick_spent = g_STM32F4_Timer_Driver.m_currentTick + (SysTick->LOAD - ticks);
-        }
-        else {
-            tick_spent = g_STM32F4_Timer_Driver.m_currentTick;
+    STM32F4_TIME_TIMER->DIER &= ~TIM_DIER_CC1IE;
+
+    if (processorTicks == TIMER_IDLE_VALUE)
+        return;
+
+    uint64_t ticks = STM32F4_Time_GetCurrentProcessorTicks(self);
+
+    if (ticks >= processorTicks) { // missed event
+        STM32F4_TIME_TIMER->DIER |= TIM_DIER_CC1IE;
+        STM32F4_TIME_TIMER->EGR = TIM_EGR_CC1G;
+
+        return;
+    }
+
+    // events more than one lap away are rescheduled from the overflow interrupt, the counter is never stopped
+    if (processorTicks - ticks <= 0xFFFFFFFF) {
+        STM32F4_TIME_TIMER->CCR1 = (uint32_t)processorTicks;
+        STM32F4_TIME_TIMER->SR = ~TIM_SR_CC1IF;
+        STM32F4_TIME_TIMER->DIER |= TIM_DIER_CC1IE;
+
+        if (STM32F4_Time_GetCurrentProcessorTicks(self) >= processorTicks) // passed while CCR1 was written
+            STM32F4_TIME_TIMER->EGR = TIM_EGR_CC1G;
+    }
+}
+
+//******************** Timer service ********************
+
+// native timers share the hardware compare with the runtime: a min heap on the deadline keeps the earliest
+// timer at the top, and the compare is set to the earlier of it and the runtime event
+#define STM32F4_Time_MaxTimers 32
+
+static STM32F4_Time_Timer* g_STM32F4_Time_Timers[STM32F4_Time_MaxTimers];
+static int32_t g_STM32F4_Time_TimerCount;
+
+static uint64_t g_runtimeEvent = TIMER_IDLE_VALUE; // next event asked for by the runtime
+
+static void STM32F4_Time_TimerSwap(int32_t a, int32_t b) {
+    auto timer = g_STM32F4_Time_Timers[a];
+
+    g_STM32F4_Time_Timers[a] = g_STM32F4_Time_Timers[b];
+    g_STM32F4_Time_Timers[b] = timer;
+
+    g_STM32F4_Time_Timers[a]->index = a;
+    g_STM32F4_Time_Timers[b]->index = b;
+}
+
+static void STM32F4_Time_TimerSiftUp(int32_t index) {
+    while (index > 0 && g_STM32F4_Time_Timers[(index - 1) / 2]->deadline > g_STM32F4_Time_Timers[index]->deadline) {
+        STM32F4_Time_TimerSwap(index, (index - 1) / 2);
+
+        index = (index - 1) / 2;
+    }
+}
+
+static void STM32F4_Time_TimerSiftDown(int32_t index) {
+    while (true) {
+        auto smallest = index;
+        auto left = index * 2 + 1;
+        auto right = index * 2 + 2;
+
+        if (left < g_STM32F4_Time_TimerCount && g_STM32F4_Time_Timers[left]->deadline < g_STM32F4_Time_Timers[smallest]->deadline)
+            smallest = left;
+
+        if (right < g_STM32F4_Time_TimerCount && g_STM32F4_Time_Timers[right]->deadline < g_STM32F4_Time_Timers[smallest]->deadline)
+            smallest = right;
+
+        if (smallest == index)
+            return;
+
+        STM32F4_Time_TimerSwap(index, smallest);
+
+        index = smallest;
+    }
+}
+
+static bool STM32F4_Time_TimerIsActive(STM32F4_Time_Timer* timer) {
+    return timer->index >= 0 && timer->index < g_STM32F4_Time_TimerCount && g_STM32F4_Time_Timers[timer->index] == timer;
+}
+
+static void STM32F4_Time_TimerInsert(STM32F4_Time_Timer* timer) {
+    timer->index = g_STM32F4_Time_TimerCount++;
+
+    g_STM32F4_Time_Timers[timer->index] = timer;
+
+    STM32F4_Time_TimerSiftUp(timer->index);
+}
+
+static void STM32F4_Time_TimerRemove(STM32F4_Time_Timer* timer) {
+    auto index = timer->index;
+
+    timer->index = -1;
+
+    if (index == --g_STM32F4_Time_TimerCount)
+        return;
+
+    g_STM32F4_Time_Timers[index] = g_STM32F4_Time_Timers[g_STM32F4_Time_TimerCount];
+    g_STM32F4_Time_Timers[index]->index = index;
+
+    STM32F4_Time_TimerSiftDown(index);
+    STM32F4_Time_TimerSiftUp(index);
+}
+
+static uint64_t STM32F4_Time_GetNextCompare() {
+    if (g_STM32F4_Time_TimerCount > 0 && g_STM32F4_Time_Timers[0]->deadline < g_runtimeEvent)
+        return g_STM32F4_Time_Timers[0]->deadline;
+
+    return g_runtimeEvent;
+}
+
+// runs the timers that are due, a periodic timer is queued again before its callback so the callback can stop it
+static void STM32F4_Time_ExecuteTimers(const TinyCLR_Time_Provider* self) {
+    auto now = STM32F4_Time_GetCurrentProcessorTicks(self);
+
+    while (g_STM32F4_Time_TimerCount > 0 && g_STM32F4_Time_Timers[0]->deadline <= now) {
+        auto timer = g_STM32F4_Time_Timers[0];
+
+        STM32F4_Time_TimerRemove(timer);
+
+        if (timer->period != 0) {
+            timer->deadline += timer->period;
+
+            if (timer->deadline <= now) // missed periods are skipped, not run in a burst
+                timer->deadline = now + timer->period;
+
+            STM32F4_Time_TimerInsert(timer);
         }
+
+        timer->callback(timer->param);
     }
-    else {
-        tick_spent = g_STM32F4_Timer_Driver.m_currentTick - ticks;
+}
+
+static void STM32F4_Time_Dispatch(const TinyCLR_Time_Provider* self) {
+    STM32F4_Time_ExecuteTimers(self);
+
+    if (STM32F4_Time_GetCurrentProcessorTicks(self) >= g_runtimeEvent) {
+        g_runtimeEvent = TIMER_IDLE_VALUE;
+
+        g_STM32F4_Timer_Driver.m_DequeuAndExecute(); // schedules the next runtime event, if there is one
     }
 
-    g_STM32F4_Timer_Driver.m_currentTick = ticks;
-    g_STM32F4_Timer_Driver.m_lastRead += tick_spent;
+    STM32F4_Time_ScheduleCompare(self, STM32F4_Time_GetNextCompare());
+}
+
+// timeout and period are in microseconds, a period of 0 makes a one shot timer. The callback runs in interrupt
+// context with interrupts disabled. The timer is owned by the caller and must stay valid while it is started.
+TinyCLR_Result STM32F4_Time_StartTimer(const TinyCLR_Time_Provider* self, STM32F4_Time_Timer* timer, uint64_t timeout, uint64_t period) {
+    if (timer == nullptr || timer->callback == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    if (g_STM32F4_Timer_Driver.m_DequeuAndExecute == nullptr)
+        return TinyCLR_Result::InvalidOperation;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (STM32F4_Time_TimerIsActive(timer))
+        STM32F4_Time_TimerRemove(timer);
+
+    if (g_STM32F4_Time_TimerCount == STM32F4_Time_MaxTimers)
+        return TinyCLR_Result::NotAvailable;
+
+    timer->deadline = STM32F4_Time_GetCurrentProcessorTicks(self) + STM32F4_Time_GetProcessorTicksForTime(self, timeout * 10);
+    timer->period = STM32F4_Time_GetProcessorTicksForTime(self, period * 10);
+
+    if (period != 0 && timer->period == 0)
+        timer->period = 1;
+
+    STM32F4_Time_TimerInsert(timer);
+
+    if (timer->index == 0)
+        STM32F4_Time_ScheduleCompare(self, STM32F4_Time_GetNextCompare());
+
+    return TinyCLR_Result::Success;
+}
+
+// a stopped timer can leave one early compare interrupt behind, which finds nothing to run
+TinyCLR_Result STM32F4_Time_StopTimer(const TinyCLR_Time_Provider* self, STM32F4_Time_Timer* timer) {
+    if (timer == nullptr)
+        return TinyCLR_Result::ArgumentNull;
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    if (STM32F4_Time_TimerIsActive(timer))
+        STM32F4_Time_TimerRemove(timer);
 
-    return (uint64_t)(g_STM32F4_Timer_Driver.m_lastRead & TIMER_IDLE_VALUE);
+    return TinyCLR_Result::Success;
 }
 
 TinyCLR_Result STM32F4_Time_SetNextTickCallbackTime(const TinyCLR_Time_Provider* self, uint64_t processorTicks) {
-    uint64_t ticks;
+    DISABLE_INTERRUPTS_SCOPED(irq);
+
+    g_runtimeEvent = processorTicks;
+
+    STM32F4_Time_ScheduleCompare(self, STM32F4_Time_GetNextCompare());
+
+    return TinyCLR_Result::Success;
+}
+
+uint64_t STM32F4_Time_GetNextEventTicks(const TinyCLR_Time_Provider* self) {
+    return g_nextEvent;
+}
 
+// the timebase stops with the APB clocks in STOP mode and runs at the wrong rate while they restart,
+// ticks is the count it should be at now. It never goes backwards. Events that came due meanwhile are run now.
+void STM32F4_Time_SetProcessorTicks(const TinyCLR_Time_Provider* self, uint64_t ticks) {
     DISABLE_INTERRUPTS_SCOPED(irq);
 
-    ticks = STM32F4_Time_GetCurrentProcessorTicks(self);
+    uint64_t now = STM32F4_Time_GetCurrentProcessorTicks(self);
 
-    g_nextEvent = processorTicks;
+    if (ticks <= now)
+        return;
 
-    if (processorTicks == TIMER_IDLE_VALUE) {
-        g_STM32F4_Timer_Driver.m_periodTicks = SysTick_LOAD_RELOAD_Msk;
-        g_STM32F4_Timer_Driver.Reload(SysTick_LOAD_RELOAD_Msk);
-    }
-    else {
-        if (ticks >= processorTicks) { // missed event
-            g_STM32F4_Timer_Driver.m_DequeuAndExecute();
-        }
-        else {
-            g_STM32F4_Timer_Driver.m_periodTicks = (processorTicks - ticks);
-
-            if (g_STM32F4_Timer_Driver.m_periodTicks >= SysTick_LOAD_RELOAD_Msk) {
-                g_STM32F4_Timer_Driver.Reload(SysTick_LOAD_RELOAD_Msk);
-            }
-            else {
-                g_STM32F4_Timer_Driver.Reload(g_STM32F4_Timer_Driver.m_periodTicks);
-            }
+    now = ticks;
+
+    STM32F4_TIME_TIMER->SR = ~TIM_SR_UIF; // a pending overflow is already in now
+    STM32F4_TIME_TIMER->CNT = (uint32_t)now;
+
+    g_STM32F4_Timer_Driver.m_overflows = (uint32_t)(now >> 32);
+
+    if (g_nextEvent != TIMER_IDLE_VALUE)
+        STM32F4_Time_ScheduleCompare(self, g_nextEvent);
+}
+
+#define STM32F4_TIME_LSI_PERIODS 16 // captures of 8 LSI cycles each, about 4ms
+#define STM32F4_TIME_LSI_TIMEOUT 1000000
+
+// TI4_RMP routes the LSI to CH4, the capture interval in timebase ticks gives its frequency
+uint32_t STM32F4_Time_MeasureLsiClock(const TinyCLR_Time_Provider* self) {
+    auto treg = STM32F4_TIME_TIMER;
+    uint32_t first = 0;
+    uint32_t last = 0;
+
+    treg->OR = (treg->OR & ~TIM_OR_TI4_RMP) | TIM_OR_TI4_RMP_0; // LSI on TI4
+    treg->CCMR2 = (treg->CCMR2 & ~(TIM_CCMR2_CC4S | TIM_CCMR2_IC4PSC | TIM_CCMR2_IC4F)) | TIM_CCMR2_CC4S_0 | TIM_CCMR2_IC4PSC; // IC4 on TI4, every 8th edge
+    treg->CCER |= TIM_CCER_CC4E;
+    treg->SR = ~TIM_SR_CC4IF;
+
+    for (auto i = 0; i <= STM32F4_TIME_LSI_PERIODS; i++) {
+        auto timeout = 0;
+
+        while (!(treg->SR & TIM_SR_CC4IF) && timeout < STM32F4_TIME_LSI_TIMEOUT)
+            timeout++;
+
+        if (timeout == STM32F4_TIME_LSI_TIMEOUT) { // LSI not running
+            last = first;
+
+            break;
         }
+
+        last = treg->CCR4; // clears CC4IF
+
+        if (i == 0)
+            first = last;
     }
 
-    return TinyCLR_Result::Success;
+    treg->CCER &= ~TIM_CCER_CC4E;
+    treg->CCMR2 &= ~(TIM_CCMR2_CC4S | TIM_CCMR2_IC4PSC);
+    treg->OR &= ~TIM_OR_TI4_RMP;
+
+    if (last == first)
+        return 0;
+
+    return (uint32_t)((uint64_t)STM32F4_TIME_TIMER_CLOCK_HZ * 8 * STM32F4_TIME_LSI_PERIODS / (last - first));
 }
 
-extern "C" {
+void STM32F4_Time_InterruptHandler(void *param) {
+    INTERRUPT_STARTED_SCOPED(isr);
+
+    DISABLE_INTERRUPTS_SCOPED(irq);
 
-    void SysTick_Handler(void *param) {
-        INTERRUPT_STARTED_SCOPED(isr);
+    uint32_t sr = STM32F4_TIME_TIMER->SR;
 
-            if (STM32F4_Time_GetCurrentProcessorTicks(nullptr) >= g_nextEvent) { // handle event
-                g_STM32F4_Timer_Driver.m_DequeuAndExecute();
-            }
-            else {
-                STM32F4_Time_SetNextTickCallbackTime(nullptr, g_nextEvent);
-            }
+    if (sr & TIM_SR_UIF) {
+        STM32F4_TIME_TIMER->SR = ~TIM_SR_UIF;
+
+        g_STM32F4_Timer_Driver.m_overflows++;
     }
 
+    if (sr & TIM_SR_CC1IF)
+        STM32F4_TIME_TIMER->SR = ~TIM_SR_CC1IF;
+
+    if (g_nextEvent == TIMER_IDLE_VALUE)
+        return;
+
+    if (STM32F4_Time_GetCurrentProcessorTicks(nullptr) >= g_nextEvent) { // handle event
+        STM32F4_TIME_TIMER->DIER &= ~TIM_DIER_CC1IE;
+
+        STM32F4_Time_Dispatch(nullptr);
+    }
+    else if (sr & TIM_SR_UIF) { // a far event may be within one lap now
+        STM32F4_Time_ScheduleCompare(nullptr, g_nextEvent);
+    }
 }
 
 TinyCLR_Result STM32F4_Time_Acquire(const TinyCLR_Time_Provider* self) {
@@ -179,7 +433,7 @@ TinyCLR_Result STM32F4_Time_Acquire(const TinyCLR_Time_Provider* self) {
 }
 
 TinyCLR_Result STM32F4_Time_Release(const TinyCLR_Time_Provider* self) {
-    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    g_STM32F4_Timer_Driver.Uninitialize();
 
     return TinyCLR_Result::Success;
 }
@@ -189,13 +443,13 @@ TinyCLR_Result STM32F4_Time_SetTickCallback(const TinyCLR_Time_Provider* self, T
 
     g_nextEvent = TIMER_IDLE_VALUE;
 
-    g_STM32F4_Timer_Driver.Initialize();
-
-    g_STM32F4_Timer_Driver.m_periodTicks = SysTick_LOAD_RELOAD_Msk;
+    g_STM32F4_Timer_Driver.m_DequeuAndExecute = callback;
 
-    g_STM32F4_Timer_Driver.Reload(g_STM32F4_Timer_Driver.m_periodTicks);
+    if (!g_STM32F4_Timer_Driver.Initialize()) {
+        g_STM32F4_Timer_Driver.m_DequeuAndExecute = nullptr;
 
-    g_STM32F4_Timer_Driver.m_DequeuAndExecute = callback;
+        return TinyCLR_Result::SharingViolation;
+    }
 
     return TinyCLR_Result::Success;
 }
@@ -231,21 +485,36 @@ void STM32F4_Time_Delay(const TinyCLR_Time_Provider* self, uint64_t microseconds
 //******************** Profiler ********************
 
 bool STM32F4_Timer_Driver::Initialize() {
-    g_STM32F4_Timer_Driver.m_lastRead = 0;
+    g_STM32F4_Timer_Driver.m_overflows = 0;
+
+    if (!STM32F4_TimerInternal_Acquire(STM32F4_TIME_TIMER, STM32F4_Timer_Owner::Time))
+        return false;
+
+    STM32F4_TIME_TIMER->CR1 = 0;
+    STM32F4_TIME_TIMER->PSC = 0;
+    STM32F4_TIME_TIMER->ARR = 0xFFFFFFFF;
+    STM32F4_TIME_TIMER->CCMR1 = 0; // CC1 is a frozen output compare, it only raises CC1IF
+    STM32F4_TIME_TIMER->CNT = 0;
+    STM32F4_TIME_TIMER->EGR = TIM_EGR_UG; // load PSC
+    STM32F4_TIME_TIMER->SR = 0;
+    STM32F4_TIME_TIMER->DIER = TIM_DIER_UIE;
 
-    g_STM32F4_Timer_Driver.m_currentTick = SysTick_LOAD_RELOAD_Msk;
-    g_STM32F4_Timer_Driver.m_periodTicks = SysTick_LOAD_RELOAD_Msk;
+    STM32F4_InterruptInternal_Activate(STM32F4_TIME_TIMER_IRQ, (uint32_t*)&STM32F4_Time_InterruptHandler, nullptr, STM32F4_INTERRUPT_PRIORITY_TIME);
 
-    SysTick_Config(g_STM32F4_Timer_Driver.m_periodTicks);
+    STM32F4_TIME_TIMER->CR1 = TIM_CR1_URS | TIM_CR1_CEN; // only overflows raise UIF
 
     return true;
 }
-void STM32F4_Timer_Driver::Reload(uint32_t value) {
-    g_STM32F4_Timer_Driver.m_currentTick = value;
 
-    SysTick->LOAD = (uint32_t)(g_STM32F4_Timer_Driver.m_currentTick - 1UL);
-    SysTick->VAL = 0UL;
+void STM32F4_Timer_Driver::Uninitialize() {
+    STM32F4_TIME_TIMER->CR1 = 0;
+    STM32F4_TIME_TIMER->DIER = 0;
+
+    STM32F4_InterruptInternal_Deactivate(STM32F4_TIME_TIMER_IRQ);
+
+    STM32F4_TimerInternal_Release(STM32F4_TIME_TIMER, STM32F4_Timer_Owner::Time);
 }
+
 #ifdef __GNUC__
 asm volatile (
     ".syntax unified\n\t"
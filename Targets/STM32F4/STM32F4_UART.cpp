@@ -359,38 +359,38 @@ TinyCLR_Result STM32F4_Uart_SetActiveSettings(const TinyCLR_Uart_Provider* self,
 
     switch (portNum) {
     case 0:
-        STM32F4_InterruptInternal_Activate(USART1_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt0, 0);
+        STM32F4_InterruptInternal_Activate(USART1_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt0, 0, STM32F4_INTERRUPT_PRIORITY_UART);
         break;
 
     case 1:
-        STM32F4_InterruptInternal_Activate(USART2_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt1, 0);
+        STM32F4_InterruptInternal_Activate(USART2_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt1, 0, STM32F4_INTERRUPT_PRIORITY_UART);
         break;
 #if !defined(STM32F401xE) && !defined(STM32F411xE)
     case 2:
-        STM32F4_InterruptInternal_Activate(USART3_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt2, 0);
+        STM32F4_InterruptInternal_Activate(USART3_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt2, 0, STM32F4_INTERRUPT_PRIORITY_UART);
         break;
 
     case 3:
-        STM32F4_InterruptInternal_Activate(UART4_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt3, 0);
+        STM32F4_InterruptInternal_Activate(UART4_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt3, 0, STM32F4_INTERRUPT_PRIORITY_UART);
         break;
 
     case 4:
-        STM32F4_InterruptInternal_Activate(UART5_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt4, 0);
+        STM32F4_InterruptInternal_Activate(UART5_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt4, 0, STM32F4_INTERRUPT_PRIORITY_UART);
         break;
 
     case 5:
-        STM32F4_InterruptInternal_Activate(USART6_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt5, 0);
+        STM32F4_InterruptInternal_Activate(USART6_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt5, 0, STM32F4_INTERRUPT_PRIORITY_UART);
         break;
 
 #ifdef UART7
     case 6:
-        STM32F4_InterruptInternal_Activate(UART7_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt4, 0);
+        STM32F4_InterruptInternal_Activate(UART7_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt4, 0, STM32F4_INTERRUPT_PRIORITY_UART);
         break;
 #endif
 
 #ifdef UART8
     case 7:
-        STM32F4_InterruptInternal_Activate(UART8_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt5, 0);
+        STM32F4_InterruptInternal_Activate(UART8_IRQn, (uint32_t*)&STM32F4_Uart_Interrupt5, 0, STM32F4_INTERRUPT_PRIORITY_UART);
         break;
 #endif
 